@@ -17,12 +17,15 @@
 
 TEST_PATH=tests/$(TEST)
 
+# a test can bring its own matrix.c, which has to implement test_matrix.h
+TEST_MATRIX_SRC ?= tests/test_common/matrix.c
+
 $(TEST)_SRC= \
 	$(TEST_PATH)/keymap.c \
 	$(TMK_COMMON_SRC) \
 	$(QUANTUM_SRC) \
 	$(SRC) \
-	tests/test_common/matrix.c \
+	$(TEST_MATRIX_SRC) \
 	tests/test_common/test_driver.cpp \
 	tests/test_common/keyboard_report_util.cpp \
 	tests/test_common/test_fixture.cpp
@@ -266,6 +266,12 @@ $(KEYBOARD_OUTPUT)_DEFS := $(PROJECT_DEFS) $(GFXDEFS)
 $(KEYBOARD_OUTPUT)_INC := $(PROJECT_INC) $(GFXINC)
 $(KEYBOARD_OUTPUT)_CONFIG := $(PROJECT_CONFIG)
 
+ifeq ($(strip $(KEYMAP_BITMAP_ENABLE)), yes)
+    KEYMAP_BITMAP_OUTPUT := $(KEYMAP_OUTPUT)
+    KEYMAP_BITMAP_KEYMAP_C := $(KEYMAP_C)
+    include keymap_bitmap.mk
+endif
+
 # Default target.
 all: build check-size
 
@@ -49,6 +49,9 @@ endif
 include common_features.mk
 include $(TMK_PATH)/common.mk
 include $(QUANTUM_PATH)/serial_link/tests/rules.mk
+include $(QUANTUM_PATH)/debounce/tests/rules.mk
+include $(QUANTUM_PATH)/audio/tests/rules.mk
+include $(TMK_PATH)/protocol/lufa/tests/rules.mk
 ifneq ($(filter $(FULL_TESTS),$(TEST)),)
 include build_full_test.mk
 endif
@@ -59,6 +62,15 @@ $(TEST_OBJ)/$(TEST)_DEFS := $($(TEST)_DEFS)
 $(TEST_OBJ)/$(TEST)_CONFIG := $($(TEST)_CONFIG)
 
 include $(TMK_PATH)/native.mk
+
+ifneq ($(filter $(FULL_TESTS),$(TEST)),)
+ifeq ($(strip $(KEYMAP_BITMAP_ENABLE)), yes)
+    KEYMAP_BITMAP_OUTPUT := $(TEST_OBJ)/$(TEST)
+    KEYMAP_BITMAP_KEYMAP_C := tests/$(TEST)/keymap.c
+    include keymap_bitmap.mk
+endif
+endif
+
 include $(TMK_PATH)/rules.mk
 
 
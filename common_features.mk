@@ -37,6 +37,7 @@ ifeq ($(strip $(AUDIO_ENABLE)), yes)
     SRC += $(QUANTUM_DIR)/audio/audio.c
     SRC += $(QUANTUM_DIR)/audio/voices.c
     SRC += $(QUANTUM_DIR)/audio/luts.c
+    SRC += $(QUANTUM_DIR)/audio/synth.c
 endif
 
 ifeq ($(strip $(MIDI_ENABLE)), yes)
@@ -114,6 +115,11 @@ ifeq ($(strip $(TAP_DANCE_ENABLE)), yes)
     SRC += $(QUANTUM_DIR)/process_keycode/process_tap_dance.c
 endif
 
+# The build stage itself is in keymap_bitmap.mk
+ifeq ($(strip $(KEYMAP_BITMAP_ENABLE)), yes)
+    OPT_DEFS += -DKEYMAP_BITMAP_ENABLE
+endif
+
 ifeq ($(strip $(KEY_LOCK_ENABLE)), yes)
     OPT_DEFS += -DKEY_LOCK_ENABLE
     SRC += $(QUANTUM_DIR)/process_keycode/process_key_lock.c
@@ -186,3 +192,12 @@ QUANTUM_SRC:= \
 ifndef CUSTOM_MATRIX
     QUANTUM_SRC += $(QUANTUM_DIR)/matrix.c
 endif
+
+DEBOUNCE_TYPE ?= sym_defer_g
+VALID_DEBOUNCE_TYPES := sym_defer_g sym_defer_pr asym_eager_defer_pk custom
+ifeq ($(filter $(strip $(DEBOUNCE_TYPE)),$(VALID_DEBOUNCE_TYPES)),)
+    $(error DEBOUNCE_TYPE="$(DEBOUNCE_TYPE)" is not a valid debounce algorithm)
+endif
+ifneq ($(strip $(DEBOUNCE_TYPE)), custom)
+    QUANTUM_SRC += $(QUANTUM_DIR)/debounce/$(strip $(DEBOUNCE_TYPE)).c
+endif
@@ -58,8 +58,23 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 /* fix space cadet rollover issue */
 #define DISABLE_SPACE_CADET_ROLLOVER
 
-/* Set 0 if debouncing isn't needed */
-#define DEBOUNCE    15
+/* select each row and read its columns in a single I2C transaction */
+#define MCP23018_BATCHED_SCAN
+
+/* read the left hand from the TWI interrupt while the right hand is scanned,
+ * the left hand columns then lag one scan behind */
+//#define MCP23018_ASYNC_SCAN
+
+/* scan once per ms, and only after a column changed while no key is down */
+//#define MATRIX_WAKE_ON_CHANGE
+/* INTA of the MCP23018 is wired to PE6, otherwise the left hand is polled */
+//#define MCP23018_INTA_INT6
+
+/* print the achieved matrix scans per second to the console */
+//#define DEBUG_MATRIX_SCAN_RATE
+
+/* debounce time in ms, set 0 if debouncing isn't needed */
+#define DEBOUNCE    10
 
 #define PREVENT_STUCK_MODIFIERS
 
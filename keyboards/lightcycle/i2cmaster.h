@@ -174,5 +174,58 @@ extern unsigned char i2c_read(unsigned char ack);
 #define i2c_read(ack)  (ack) ? i2c_readAck() : i2c_readNak(); 
 
 
+/** size of the transaction queue used by i2c_submit() */
+#ifndef I2C_QUEUE_SIZE
+#define I2C_QUEUE_SIZE 8
+#endif
+
+/**
+ @brief Descriptor of a non-blocking transaction
+
+ The write bytes are sent first, then if read_length is non-zero a repeated
+ start is issued and read_length bytes are read into read_data. At least one
+ of the lengths must be non-zero. The
+ descriptor and its buffers must stay valid until the transaction has
+ completed. status is I2C_PENDING while queued or in flight, then 0 on success
+ or 1 if the device didn't respond. The callback, if set, is called from the
+ TWI interrupt once the transaction has completed.
+ */
+typedef struct i2c_transaction {
+    unsigned char address;          /**< 7-bit device address */
+    const unsigned char *write_data;
+    unsigned char write_length;
+    unsigned char *read_data;
+    unsigned char read_length;
+    volatile unsigned char status;
+    void (*callback)(struct i2c_transaction *transaction);
+} i2c_transaction_t;
+
+/** status of a transaction that hasn't completed yet */
+#define I2C_PENDING 0xFF
+
+/**
+ @brief Queue a transaction, which is then run by the TWI interrupt
+
+ @param    transaction descriptor of the transaction
+ @retval   0 queued
+ @retval   1 the queue is full
+ */
+extern unsigned char i2c_submit(i2c_transaction_t *transaction);
+
+/**
+ @brief    whether any submitted transaction is still queued or in flight
+ @return   1 if busy
+ */
+extern unsigned char i2c_busy(void);
+
+/**
+ @brief    wait until all submitted transactions have completed
+
+ Called by i2c_start(), so the blocking functions above can still be mixed
+ with submitted transactions.
+ */
+extern void i2c_wait_idle(void);
+
+
 /**@}*/
 #endif
@@ -50,6 +50,15 @@ uint8_t init_mcp23018(void)
     mcp23018_status = i2c_write(0xFF);              if (mcp23018_status) goto out;
     mcp23018_status = i2c_write(0xE0);              if (mcp23018_status) goto out;
 
+#if defined(MCP23018_BATCHED_SCAN) || defined(MCP23018_ASYNC_SCAN)
+    // byte mode, so the address pointer toggles between the GPIOA/GPIOB pair
+    // and a row can be selected and read in one transaction
+    i2c_stop();
+    mcp23018_status = i2c_start(I2C_ADDR_WRITE);    if (mcp23018_status) goto out;
+    mcp23018_status = i2c_write(IOCON);             if (mcp23018_status) goto out;
+    mcp23018_status = i2c_write(IOCON_SEQOP);       if (mcp23018_status) goto out;
+#endif
+
 out:
     i2c_stop();
 
@@ -16,6 +16,8 @@
 #define I2C_ADDR_READ   ( (I2C_ADDR<<1) | I2C_READ  )
 #define IODIRA          0x00            // i/o direction register
 #define IODIRB          0x01
+#define GPINTENA        0x04            // interrupt-on-change enable register
+#define IOCON           0x0A            // configuration register (also at 0x0B)
 #define GPPUA           0x0C            // GPIO pull-up resistor register
 #define GPPUB           0x0D
 #define GPIOA           0x12            // general purpose i/o port register (write modifies OLAT)
@@ -23,6 +25,8 @@
 #define OLATA           0x14            // output latch register
 #define OLATB           0x15
 
+#define IOCON_SEQOP     (1<<5)          // byte mode: address pointer doesn't increment
+
 extern uint8_t mcp23018_status;
 
 uint8_t init_lightcycle(void);
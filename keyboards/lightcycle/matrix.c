@@ -31,42 +31,92 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "matrix.h"
 #include "lightcycle.h"
 #include "i2cmaster.h"
-#ifdef DEBUG_MATRIX_SCAN_RATE
+#include "debounce.h"
+#if defined(DEBUG_MATRIX_SCAN_RATE) || defined(MATRIX_WAKE_ON_CHANGE)
 #include  "timer.h"
 #endif
+#ifdef MATRIX_WAKE_ON_CHANGE
+#include <avr/interrupt.h>
+#endif
 
 /*
- * This constant define not debouncing time in msecs, but amount of matrix
- * scan loops which should be made to get stable debounced results.
- *
  * On the Dactyl, the matrix scan rate is relatively low, because
  * communicating with the left hand's I/O expander is slower than simply
  * selecting local pins.
- * Now it's only 317 scans/second, or about 3.15 msec/scan.
- * According to Cherry specs, debouncing time is 5 msec.
+ * Doing a separate I2C transaction to select, read and unselect every row
+ * only gives 317 scans/second, or about 3.15 msec/scan.
+ * With MCP23018_BATCHED_SCAN each row is one transaction of five bytes, which
+ * is roughly 0.7 msec/scan on the bus, so aim for at least 1000 scans/second
+ * (check with DEBUG_MATRIX_SCAN_RATE).
+ *
+ * Debouncing is done by the shared debounce module (DEBOUNCE_TYPE in
+ * rules.mk), which counts DEBOUNCE in msecs, so it doesn't depend on the
+ * scan rate.
  *
- * And so, there is no sense to have DEBOUNCE higher than 2.
+ * With MATRIX_WAKE_ON_CHANGE the matrix is scanned once per tick of the
+ * timer, and not at all while no key is down: then all rows are driven low
+ * and a change of the columns wakes the scan up. The Teensy columns raise
+ * pin change (PB0-3) and external (PD2-3) interrupts. The left hand raises
+ * INTA on PE6 if it is wired there (MCP23018_INTA_INT6), otherwise its
+ * columns are polled with a single read per tick.
  */
 
-#ifndef DEBOUNCE
-#   define DEBOUNCE	5
-#endif
-
 /* matrix state(1:on, 0:off) */
 static uint16_t matrix[MATRIX_ROWS];
 
-// Debouncing: store for each key the number of scans until it's eligible to
-// change.  When scanning the matrix, ignore any changes in keys that have
-// already changed in the last DEBOUNCE scans.
-// keys are stored as row0/col0, row0/col1, row0/col2, ...
-static uint8_t debounce_matrix[MATRIX_ROWS*MATRIX_COLS];
+/* raw state of the latest scan, before debouncing */
+static uint16_t raw_matrix[MATRIX_ROWS];
 
+static void unselect_rows(void);
+#if defined(MCP23018_ASYNC_SCAN)
+static void mcp23018_scan_init(void);
+static void mcp23018_scan_submit(void);
+static uint16_t select_teensy_row_read_cols(uint8_t row);
+static void unselect_teensy_rows(void);
+#elif defined(MCP23018_BATCHED_SCAN)
+static uint16_t select_row_read_cols(uint8_t row);
+static void unselect_teensy_rows(void);
+#else
 static uint16_t read_cols(void);
 static void select_row(uint8_t row);
-static void unselect_rows(void);
+#endif
 
 static uint8_t mcp23018_reset_loop;
 
+#define TEENSY_ROWS (1<<0 | 1<<1 | 1<<4 | 1<<5 | 1<<6)
+
+#ifdef MATRIX_WAKE_ON_CHANGE
+#ifdef MCP23018_ASYNC_SCAN
+#error "MATRIX_WAKE_ON_CHANGE talks to the MCP23018 in between the asynchronous reads"
+#endif
+static void matrix_sleep(void);
+static bool matrix_woken(void);
+
+static uint16_t matrix_scan_time;
+static bool matrix_idle = false;
+/* set by the interrupts of the columns while idle */
+static volatile bool matrix_wake = false;
+#ifdef MCP23018_INTA_INT6
+static uint8_t mcp23018_probe_loop;
+#endif
+#endif
+
+#ifdef DEBUG_MATRIX_SCAN_RATE
+uint32_t matrix_timer;
+uint32_t matrix_scan_count;
+#endif
+
+#ifdef MCP23018_ASYNC_SCAN
+// Left hand columns, read by the TWI interrupt in the background. Each row
+// is one queued transaction, which selects the row and reads GPIOA in byte
+// mode, the same sequence as MCP23018_BATCHED_SCAN uses. The results of a complete left hand
+// scan are picked up by the following matrix_scan().
+static uint8_t mcp23018_row_select[MATRIX_ROWS][2];
+static uint8_t mcp23018_row_data[MATRIX_ROWS];
+static i2c_transaction_t mcp23018_row_read[MATRIX_ROWS];
+static uint8_t mcp23018_cols[MATRIX_ROWS];
+#endif
+
 __attribute__ ((weak))
 void matrix_init_user(void) {}
 
@@ -96,12 +146,26 @@ void matrix_init(void)
     unselect_rows();
 
     // initialize matrix state
-    for (uint8_t i=0; i < MATRIX_ROWS; i++)
+    for (uint8_t i=0; i < MATRIX_ROWS; i++) {
         matrix[i] = 0;
+        raw_matrix[i] = 0;
+    }
+    debounce_init(MATRIX_ROWS);
+
+#ifdef DEBUG_MATRIX_SCAN_RATE
+    matrix_timer = timer_read32();
+    matrix_scan_count = 0;
+#endif
 
-    // Inintialize Debounce Matrix
-    for (uint8_t i=0; i < MATRIX_ROWS*MATRIX_COLS; i++)
-        debounce_matrix[i] = 0;
+#ifdef MCP23018_ASYNC_SCAN
+    mcp23018_scan_init();
+#endif
+
+#ifdef MATRIX_WAKE_ON_CHANGE
+    // the first call scans
+    matrix_scan_time = timer_read() - 1;
+    matrix_idle = false;
+#endif
 
     matrix_init_quantum();
 }
@@ -111,40 +175,22 @@ void matrix_power_up(void)
     matrix_init();
 }
 
-// Returns a uint16_t whose bits are set if the corresponding key should be eligible to change in this scan.
-uint16_t debounce_mask(uint8_t row)
-{
-  uint16_t result = 0;
-  uint8_t start = row * MATRIX_COLS;
-  uint8_t stop = start + MATRIX_COLS;
-
-  for (uint16_t i = start; i < stop; i++)
-  {
-    if (debounce_matrix[i] > 0)
-      debounce_matrix[i]--;
-    else
-      result |= (1 << (i-start));
-  }
-
-  return result;
-}
-
-// Report changed keys in the given row.  Resets the debounce countdowns
-// corresponding to each set bit in 'change' to DEBOUNCE.
-void debounce_report(uint16_t change, uint16_t row)
+uint8_t matrix_scan(void)
 {
-    uint8_t start = row * MATRIX_COLS;
-    uint8_t stop = start + MATRIX_COLS;
-    
-    for (uint8_t i = start; i < stop; i++)
-    {
-    	if(change & (1 << (i - start)))
-        	debounce_matrix[i] = DEBOUNCE;
+    bool changed = false;
+    bool any_key = false;
+
+#ifdef MATRIX_WAKE_ON_CHANGE
+    // one scan per tick, so the latency doesn't depend on how long the rest
+    // of the main loop takes
+    uint16_t now = timer_read();
+    if (now == matrix_scan_time) {
+        matrix_scan_quantum();
+        return 1;
     }
-}
+    matrix_scan_time = now;
+#endif
 
-uint8_t matrix_scan(void)
-{
     if (mcp23018_status)
     { // if there was an error
         if (++mcp23018_reset_loop == 0)
@@ -158,28 +204,78 @@ uint8_t matrix_scan(void)
                 print("left side not responding\n");
             else
                 print("left side attached\n");
+#ifdef MATRIX_WAKE_ON_CHANGE
+            // scan once, which selects the rows of the left hand again
+            if (!mcp23018_status)
+                matrix_wake = true;
+#endif
         }
     }
 
+#ifdef DEBUG_MATRIX_SCAN_RATE
+    matrix_scan_count++;
+
+    uint32_t timer_now = timer_read32();
+    if (TIMER_DIFF_32(timer_now, matrix_timer) > 1000) {
+        print("matrix scan frequency: ");
+        pdec(matrix_scan_count);
+        print("\n");
+
+        matrix_timer = timer_now;
+        matrix_scan_count = 0;
+    }
+#endif
+
+#ifdef MATRIX_WAKE_ON_CHANGE
+    if (matrix_idle && !matrix_woken()) {
+        matrix_scan_quantum();
+        return 1;
+    }
+#endif
+
+#ifdef MCP23018_ASYNC_SCAN
+    // the right hand is scanned while the left hand is read in the background
+    mcp23018_scan_submit();
+#endif
+
     for(uint8_t i=0; i < MATRIX_ROWS; i++)
     {
+#if defined(MCP23018_ASYNC_SCAN)
+        uint16_t col_data = select_teensy_row_read_cols(i);
+#elif defined(MCP23018_BATCHED_SCAN)
+        uint16_t col_data = select_row_read_cols(i);
+#else
         select_row(i);
         wait_us(30);
         uint16_t col_data = read_cols();
-        uint16_t mask = debounce_mask(i);
-        col_data = (col_data & mask) | (matrix[i] & ~mask);
-        debounce_report(col_data ^ matrix[i], i);
-        matrix[i] = col_data;
+#endif
+        changed |= (raw_matrix[i] != col_data);
+        any_key |= (col_data != 0);
+        raw_matrix[i] = col_data;
+#if defined(MCP23018_ASYNC_SCAN) || defined(MCP23018_BATCHED_SCAN)
+        unselect_teensy_rows();
+#else
         unselect_rows();
+#endif
     }
 
+    debounce(raw_matrix, matrix, MATRIX_ROWS, changed);
+
+#ifdef MATRIX_WAKE_ON_CHANGE
+    if (!any_key && !debounce_active())
+        matrix_sleep();
+#else
+    (void)any_key;
+#endif
+
     matrix_scan_quantum();
 
     return 1;
 }
 
-bool matrix_is_modified(void) // deprecated and evidently not called.
+bool matrix_is_modified(void)
 {
+    if (debounce_active()) return false;
     return true;
 }
 
@@ -215,19 +311,227 @@ uint8_t matrix_key_count(void)
 }
 
 
-static uint16_t read_cols(void)
+static void unselect_rows(void)
+{
+    // unselect on mcp23018
+    if (!mcp23018_status)
+    {
+        // set all rows to drive high
+        mcp23018_status = i2c_start(I2C_ADDR_WRITE); if (mcp23018_status) goto out;
+        mcp23018_status = i2c_write(GPIOB);          if (mcp23018_status) goto out;
+        mcp23018_status = i2c_write(0xFF);
+    out:
+        i2c_stop();
+    }
+
+    // Unselect on Teensy 2.0
+    PORTF |=  TEENSY_ROWS;
+}
+
+#if defined(MCP23018_ASYNC_SCAN) || defined(MCP23018_BATCHED_SCAN)
+static void unselect_teensy_rows(void)
+{
+    PORTF |=  TEENSY_ROWS;
+}
+#endif
+
+#ifdef MATRIX_WAKE_ON_CHANGE
+ISR(PCINT0_vect)
+{
+    matrix_wake = true;
+}
+
+ISR(INT2_vect)
+{
+    matrix_wake = true;
+}
+
+ISR(INT3_vect)
+{
+    matrix_wake = true;
+}
+
+#ifdef MCP23018_INTA_INT6
+ISR(INT6_vect)
+{
+    matrix_wake = true;
+}
+#endif
+
+// Whether a left hand column is low, with all rows selected
+static bool mcp23018_cols_active(void)
+{
+    uint8_t mcp_data = 0xFF;
+
+    if (!mcp23018_status)
+    {
+        mcp23018_status = i2c_start(I2C_ADDR_WRITE);    if (mcp23018_status) goto out;
+        mcp23018_status = i2c_write(GPIOA);             if (mcp23018_status) goto out;
+        mcp23018_status = i2c_rep_start(I2C_ADDR_READ); if (mcp23018_status) goto out;
+        mcp_data = i2c_readNak();
+    out:
+        i2c_stop();
+    }
+    return ((~mcp_data >> 1) & 0x3F) != 0;
+}
+
+// Drive all rows low and let the columns wake the scan up
+static void matrix_sleep(void)
+{
+    PORTF &= ~TEENSY_ROWS;
+
+    if (!mcp23018_status)
+    {
+        mcp23018_status = i2c_start(I2C_ADDR_WRITE);    if (mcp23018_status) goto out;
+        mcp23018_status = i2c_write(GPIOB);             if (mcp23018_status) goto out;
+        mcp23018_status = i2c_write(0x00);
+#ifdef MCP23018_INTA_INT6
+        // INTA goes low when a column changes, until GPIOA is read
+        i2c_stop();
+        mcp23018_status = i2c_start(I2C_ADDR_WRITE);    if (mcp23018_status) goto out;
+        mcp23018_status = i2c_write(GPINTENA);          if (mcp23018_status) goto out;
+        mcp23018_status = i2c_write(0x7E);
+#endif
+    out:
+        i2c_stop();
+    }
+
+    matrix_wake = false;
+    matrix_idle = true;
+
+    PCMSK0 |= 0x0F;
+    PCIFR = (1<<PCIF0);
+    PCICR |= (1<<PCIE0);
+    EICRA = (EICRA & ~(1<<ISC21 | 1<<ISC31)) | (1<<ISC20 | 1<<ISC30);   // any edge
+    EIFR = (1<<INTF2 | 1<<INTF3);
+    EIMSK |= (1<<INT2 | 1<<INT3);
+#ifdef MCP23018_INTA_INT6
+    EICRB = (EICRB & ~(1<<ISC60)) | (1<<ISC61);                         // falling edge
+    EIFR = (1<<INTF6);
+    EIMSK |= (1<<INT6);
+#endif
+
+    // a key that went down while the rows were switched left no edge, and
+    // reading GPIOA releases INTA
+    if ((PINB & 0x0F) != 0x0F || (PIND & 0x0C) != 0x0C || mcp23018_cols_active())
+        matrix_wake = true;
+}
+
+// Leave idle if a column changed, or a left hand one is low
+static bool matrix_woken(void)
+{
+#ifdef MCP23018_INTA_INT6
+    // an expander that was unplugged lost its interrupt setup, so check
+    // that it's there every 256 ms
+    if (!matrix_wake && ++mcp23018_probe_loop == 0 && mcp23018_cols_active())
+        matrix_wake = true;
+#else
+    if (!matrix_wake && mcp23018_cols_active())
+        matrix_wake = true;
+#endif
+    if (!matrix_wake)
+        return false;
+
+    PCICR &= ~(1<<PCIE0);
+    EIMSK &= ~(1<<INT2 | 1<<INT3);
+#ifdef MCP23018_INTA_INT6
+    EIMSK &= ~(1<<INT6);
+#endif
+    matrix_idle = false;
+    unselect_rows();
+    return true;
+}
+#endif
+
+#if defined(MCP23018_ASYNC_SCAN)
+static void mcp23018_scan_init(void)
+{
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        mcp23018_row_select[row][0] = GPIOB;
+        mcp23018_row_select[row][1] = 0xFF & ~(1<<row);
+        mcp23018_row_data[row] = 0xFF;
+        mcp23018_cols[row] = 0;
+
+        mcp23018_row_read[row] = (i2c_transaction_t){
+            .address = I2C_ADDR,
+            .write_data = mcp23018_row_select[row],
+            .write_length = 2,
+            .read_data = &mcp23018_row_data[row],
+            .read_length = 1,
+            .status = 0,
+            .callback = NULL
+        };
+    }
+}
+
+// Pick up the left hand columns of the last background scan once all of its
+// rows have completed, and queue the next one.
+static void mcp23018_scan_submit(void)
+{
+    if (mcp23018_status)
+        return;
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        if (mcp23018_row_read[row].status == I2C_PENDING)
+            return;
+    }
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        if (mcp23018_row_read[row].status) {
+            // start over once the reset loop has brought the MCP23018 back
+            mcp23018_status = mcp23018_row_read[row].status;
+            mcp23018_scan_init();
+            return;
+        }
+        mcp23018_cols[row] = ((uint8_t)~mcp23018_row_data[row] >> 1) & 0x3F;
+    }
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        i2c_submit(&mcp23018_row_read[row]);
+    }
+}
+
+static uint16_t select_teensy_row_read_cols(uint8_t row)
+{
+    // Select on Teensy 2.0
+    PORTF &= (row < 2) ? ~(1<<row) : ~(1<<(row + 2));
+    wait_us(30);
+
+    // Read Teensy data
+    uint8_t teensy_data = ~((PINB & 0x0F) | ((PIND & 0x0C)<<2));
+
+    return ((teensy_data << 6) | mcp23018_cols[row]) & 0x0FFF;
+}
+
+#elif defined(MCP23018_BATCHED_SCAN)
+/* Select a row and read its columns with a single I2C transaction.
+ *
+ * init_mcp23018() puts the expander in byte mode (IOCON.SEQOP), where the
+ * address pointer toggles between the A/B register pair after each byte.
+ * So once the row mask has been written to GPIOB the pointer is left on
+ * GPIOA, and a repeated start in read mode returns the columns directly:
+ *
+ *   S SLA+W GPIOB mask Sr SLA+R GPIOA P
+ *
+ * The Teensy row is selected first, so it settles while the bus is busy.
+ * There's no need to unselect the MCP23018 rows between rows, selecting the
+ * next row drives the previous one high again.
+ */
+static uint16_t select_row_read_cols(uint8_t row)
 {
-    // Columns 0-5 are on the MCP, 6-B are on the teensy
-    // Read from MCP and Teensy
     uint8_t mcp_data = 0;
     uint8_t teensy_data = 0;
-    uint16_t column_data = 0;
+
+    // Select on Teensy 2.0
+    PORTF &= (row < 2) ? ~(1<<row) : ~(1<<(row + 2));
 
     if (!mcp23018_status)
     {
+        // set active row low and all other rows high, then read columns
         mcp23018_status = i2c_start(I2C_ADDR_WRITE);    if (mcp23018_status) goto out;
-        mcp23018_status = i2c_write(GPIOA);             if (mcp23018_status) goto out;
-        mcp23018_status = i2c_start(I2C_ADDR_READ);     if (mcp23018_status) goto out;
+        mcp23018_status = i2c_write(GPIOB);             if (mcp23018_status) goto out;
+        mcp23018_status = i2c_write(0xFF & ~(1<<row));  if (mcp23018_status) goto out;
+        mcp23018_status = i2c_rep_start(I2C_ADDR_READ); if (mcp23018_status) goto out;
         mcp_data = i2c_readNak();
         mcp_data = (~mcp_data) >> 1;
     out:
@@ -237,26 +541,33 @@ static uint16_t read_cols(void)
     // Read Teensy data
     teensy_data = ~((PINB & 0x0F) | ((PIND & 0x0C)<<2));
 
-    column_data = ((teensy_data << 6) | (mcp_data & 0x3F)) & 0x0FFF;
-    return column_data;
+    return ((teensy_data << 6) | (mcp_data & 0x3F)) & 0x0FFF;
 }
-
-
-static void unselect_rows(void)
+#else
+static uint16_t read_cols(void)
 {
-    // unselect on mcp23018
+    // Columns 0-5 are on the MCP, 6-B are on the teensy
+    // Read from MCP and Teensy
+    uint8_t mcp_data = 0;
+    uint8_t teensy_data = 0;
+    uint16_t column_data = 0;
+
     if (!mcp23018_status)
     {
-        // set all rows to drive high
-        mcp23018_status = i2c_start(I2C_ADDR_WRITE); if (mcp23018_status) goto out;
-        mcp23018_status = i2c_write(GPIOB);          if (mcp23018_status) goto out;
-        mcp23018_status = i2c_write(0xFF);
+        mcp23018_status = i2c_start(I2C_ADDR_WRITE);    if (mcp23018_status) goto out;
+        mcp23018_status = i2c_write(GPIOA);             if (mcp23018_status) goto out;
+        mcp23018_status = i2c_start(I2C_ADDR_READ);     if (mcp23018_status) goto out;
+        mcp_data = i2c_readNak();
+        mcp_data = (~mcp_data) >> 1;
     out:
         i2c_stop();
     }
 
-    // Unselect on Teensy 2.0
-    PORTF |=  (1<<0 | 1<<1 | 1<<4 | 1<<5 | 1<<6);
+    // Read Teensy data
+    teensy_data = ~((PINB & 0x0F) | ((PIND & 0x0C)<<2));
+
+    column_data = ((teensy_data << 6) | (mcp_data & 0x3F)) & 0x0FFF;
+    return column_data;
 }
 
 
@@ -277,4 +588,4 @@ static void select_row(uint8_t row)
     // Select on Teensy 2.0
     PORTF &= (row < 2) ? ~(1<<row) : ~(1<<(row + 2));
 }
-
+#endif
@@ -81,6 +81,8 @@ CONSOLE_ENABLE          = no  # Console for debug(+8000)
 COMMAND_ENABLE          = no  # Commands for debug and configuration
 DEBUG_ENABLE			= no
 CUSTOM_MATRIX           = yes # Custom matrix file for the Dactyl
+DEBOUNCE_TYPE           = asym_eager_defer_pk # Report presses at once, defer releases
+KEYMAP_BITMAP_ENABLE    = yes # Find the layer of a key from a bitmap generated at build time
 NKRO_ENABLE             = yes # USB Nkey Rollover
 UNICODE_ENABLE          = yes # Unicode
 ONEHAND_ENABLE          = yes # Allow swapping hands of keyboard
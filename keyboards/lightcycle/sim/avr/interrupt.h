@@ -0,0 +1,41 @@
+/* Copyright 2017
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Interrupt vectors of the host build are plain functions, which the
+// simulated pins call when they change, see lightcycle_sim.h.
+
+#ifndef SIM_AVR_INTERRUPT_H
+#define SIM_AVR_INTERRUPT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void PCINT0_vect(void);
+void INT2_vect(void);
+void INT3_vect(void);
+void INT6_vect(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define ISR(vector, ...) void vector(void)
+
+#define sei()
+#define cli()
+
+#endif
@@ -0,0 +1,68 @@
+/* Copyright 2017
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// The Teensy ports used by the lightcycle, for the host build, see
+// lightcycle_sim.h. The output and direction registers are plain variables,
+// the input registers are read from the simulated switches.
+
+#ifndef SIM_AVR_IO_H
+#define SIM_AVR_IO_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern volatile uint8_t DDRB, PORTB;
+extern volatile uint8_t DDRC, PORTC;
+extern volatile uint8_t DDRD, PORTD;
+extern volatile uint8_t DDRE, PORTE;
+extern volatile uint8_t DDRF, PORTF;
+extern volatile uint8_t CLKPR;
+
+/* pin change and external interrupts of the columns */
+extern volatile uint8_t PCICR, PCIFR, PCMSK0;
+extern volatile uint8_t EICRA, EICRB, EIMSK, EIFR;
+
+#define PCIE0   0
+#define PCIF0   0
+#define ISC20   4
+#define ISC21   5
+#define ISC30   6
+#define ISC31   7
+#define ISC60   4
+#define ISC61   5
+#define INT2    2
+#define INT3    3
+#define INT6    6
+#define INTF2   2
+#define INTF3   3
+#define INTF6   6
+
+uint8_t sim_read_pin(volatile uint8_t *port);
+
+#define PINB sim_read_pin(&PORTB)
+#define PINC sim_read_pin(&PORTC)
+#define PIND sim_read_pin(&PORTD)
+#define PINE sim_read_pin(&PORTE)
+#define PINF sim_read_pin(&PORTF)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
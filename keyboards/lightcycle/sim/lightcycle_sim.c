@@ -0,0 +1,415 @@
+/* Copyright 2017
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "lightcycle_sim.h"
+#include "../i2cmaster.h"
+#include "matrix.h"
+#include "test_matrix.h"
+
+volatile uint8_t DDRB, PORTB;
+volatile uint8_t DDRC, PORTC;
+volatile uint8_t DDRD, PORTD;
+volatile uint8_t DDRE, PORTE;
+volatile uint8_t DDRF, PORTF;
+volatile uint8_t CLKPR;
+volatile uint8_t PCICR, PCIFR, PCMSK0;
+volatile uint8_t EICRA, EICRB, EIMSK, EIFR;
+
+static matrix_row_t switches[MATRIX_ROWS];
+
+static sim_stats_t stats;
+static uint16_t transaction_us = SIM_TRANSACTION_US;
+static uint16_t byte_us = SIM_BYTE_US;
+
+/*
+ * MCP23018 in its default IOCON.BANK = 0 layout
+ */
+#define MCP23018_ADDR   0x20
+#define MCP23018_REGS   0x16
+
+enum {
+    IODIRA_ = 0x00, IODIRB_, IPOLA_, IPOLB_, GPINTENA_, GPINTENB_,
+    DEFVALA_, DEFVALB_, INTCONA_, INTCONB_, IOCON_, IOCON2_, GPPUA_, GPPUB_,
+    INTFA_, INTFB_, INTCAPA_, INTCAPB_, GPIOA_, GPIOB_, OLATA_, OLATB_,
+};
+
+#define SEQOP (1<<5)
+
+static uint8_t registers[MCP23018_REGS] = {
+    [IODIRA_] = 0xFF,
+    [IODIRB_] = 0xFF,
+};
+/* the interrupt-on-change comparison value when INTCON is clear */
+static uint8_t previous_a;
+static uint8_t pointer;
+static bool connected = true;
+
+/* the transfer in progress */
+static bool selected = false;
+static bool reading = false;
+static bool addressing = false;
+
+void sim_reset(void)
+{
+    memset(registers, 0, sizeof(registers));
+    registers[IODIRA_] = 0xFF;
+    registers[IODIRB_] = 0xFF;
+    previous_a = 0;
+    pointer = 0;
+    connected = true;
+    selected = false;
+    sim_clear_stats();
+}
+
+void sim_set_bus_time(uint16_t transaction, uint16_t byte)
+{
+    transaction_us = transaction;
+    byte_us = byte;
+}
+
+void sim_mcp23018_connect(bool connect)
+{
+    connected = connect;
+    if (!connect) {
+        selected = false;
+    }
+}
+
+const sim_stats_t *sim_stats(void)
+{
+    return &stats;
+}
+
+void sim_clear_stats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+void sim_delay_us(uint32_t us)
+{
+    stats.busy_us += us;
+}
+
+/* The rows of the left hand are GPB0-4, open drain outputs, and its columns
+ * 0-5 are GPA1-6, with pull-ups. */
+static uint8_t mcp23018_pins_a(void)
+{
+    uint8_t outputs = ~registers[IODIRA_];
+    uint8_t pins = (registers[OLATA_] & outputs) | (registers[GPPUA_] & ~outputs);
+    uint8_t driven_low = ~registers[IODIRB_] & ~registers[OLATB_];
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        if (!(driven_low & (1<<row))) continue;
+        for (uint8_t col = 0; col < 6; col++) {
+            if (switches[row] & ((matrix_row_t)1<<col)) {
+                pins &= ~(1<<(col + 1));
+            }
+        }
+    }
+    return pins;
+}
+
+static uint8_t mcp23018_pins_b(void)
+{
+    uint8_t outputs = ~registers[IODIRB_];
+    return (registers[OLATB_] & outputs) | (registers[GPPUB_] & ~outputs);
+}
+
+/* INTA is active while INTFA holds a flag, reading GPIOA or INTCAPA clears
+ * it */
+uint8_t sim_mcp23018_register(uint8_t address)
+{
+    switch (address) {
+        case INTCAPA_:
+            registers[INTFA_] = 0;
+            return registers[INTCAPA_];
+        case GPIOA_:
+            registers[INTFA_] = 0;
+            return mcp23018_pins_a() ^ registers[IPOLA_];
+        case GPIOB_:
+            return mcp23018_pins_b() ^ registers[IPOLB_];
+        default:
+            return address < MCP23018_REGS ? registers[address] : 0;
+    }
+}
+
+static void mcp23018_write(uint8_t address, uint8_t data)
+{
+    switch (address) {
+        case GPIOA_:
+        case GPIOB_:
+            registers[address + 2] = data;
+            break;
+        case IOCON_:
+        case IOCON2_:
+            registers[IOCON_] = registers[IOCON2_] = data;
+            break;
+        case INTFA_:
+        case INTFB_:
+        case INTCAPA_:
+        case INTCAPB_:
+            break;
+        default:
+            if (address < MCP23018_REGS) {
+                registers[address] = data;
+            }
+    }
+}
+
+/* Byte mode toggles between the A and B register of a pair, sequential mode
+ * walks through the register file. */
+static void mcp23018_advance(void)
+{
+    if (registers[IOCON_] & SEQOP) {
+        pointer ^= 1;
+    } else {
+        pointer = (pointer + 1) % MCP23018_REGS;
+    }
+}
+
+/*
+ * i2cmaster.h
+ */
+void i2c_init(void)
+{
+}
+
+unsigned char i2c_start(unsigned char address)
+{
+    stats.starts++;
+    stats.bytes++;
+    stats.busy_us += transaction_us + byte_us;
+
+    selected = connected && (address >> 1) == MCP23018_ADDR;
+    if (!selected) {
+        stats.nacks++;
+        return 1;
+    }
+    reading = address & I2C_READ;
+    addressing = !reading;
+    return 0;
+}
+
+unsigned char i2c_rep_start(unsigned char address)
+{
+    return i2c_start(address);
+}
+
+void i2c_start_wait(unsigned char address)
+{
+    // the model is never busy, it either answers or isn't there
+    i2c_start(address);
+}
+
+void i2c_stop(void)
+{
+    selected = false;
+}
+
+unsigned char i2c_write(unsigned char data)
+{
+    stats.bytes++;
+    stats.busy_us += byte_us;
+
+    if (!selected || reading) return 1;
+    if (addressing) {
+        pointer = data < MCP23018_REGS ? data : 0;
+        addressing = false;
+    } else {
+        mcp23018_write(pointer, data);
+        mcp23018_advance();
+    }
+    return 0;
+}
+
+static unsigned char read_byte(void)
+{
+    stats.bytes++;
+    stats.busy_us += byte_us;
+
+    if (!selected || !reading) return 0xFF;
+    uint8_t data = sim_mcp23018_register(pointer);
+    mcp23018_advance();
+    return data;
+}
+
+unsigned char i2c_readAck(void)
+{
+    return read_byte();
+}
+
+unsigned char i2c_readNak(void)
+{
+    return read_byte();
+}
+
+/* Submitted transactions complete at once, as if the TWI interrupt had run
+ * them before the next scan. */
+unsigned char i2c_submit(i2c_transaction_t *transaction)
+{
+    uint8_t status = 0;
+
+    if (transaction->write_length) {
+        status = i2c_start(transaction->address << 1 | I2C_WRITE);
+        for (uint8_t i = 0; !status && i < transaction->write_length; i++) {
+            status = i2c_write(transaction->write_data[i]);
+        }
+    }
+    if (!status && transaction->read_length) {
+        status = i2c_rep_start(transaction->address << 1 | I2C_READ);
+        for (uint8_t i = 0; !status && i < transaction->read_length; i++) {
+            transaction->read_data[i] = read_byte();
+        }
+    }
+    i2c_stop();
+
+    transaction->status = status;
+    if (transaction->callback) {
+        transaction->callback(transaction);
+    }
+    return 0;
+}
+
+unsigned char i2c_busy(void)
+{
+    return 0;
+}
+
+void i2c_wait_idle(void)
+{
+}
+
+/*
+ * Teensy 2.0
+ */
+
+/* Rows PF0, PF1, PF4, PF5 and PF6, columns 6-11 on PB0-3, PD2 and PD3 */
+uint8_t sim_read_pin(volatile uint8_t *port)
+{
+    uint8_t pins = *port;
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        uint8_t row_bit = 1 << (row < 2 ? row : row + 2);
+        if (!(DDRF & row_bit) || (PORTF & row_bit)) continue;
+        for (uint8_t col = 6; col < MATRIX_COLS; col++) {
+            if (!(switches[row] & ((matrix_row_t)1<<col))) continue;
+            if (col < 10 && port == &PORTB) {
+                pins &= ~(1<<(col - 6));
+            } else if (col >= 10 && port == &PORTD) {
+                pins &= ~(1<<(col - 8));
+            }
+        }
+    }
+    return pins;
+}
+
+/*
+ * Interrupts, the vectors are overridden by a matrix.c built with
+ * MATRIX_WAKE_ON_CHANGE
+ */
+__attribute__((weak)) void PCINT0_vect(void) {}
+__attribute__((weak)) void INT2_vect(void) {}
+__attribute__((weak)) void INT3_vect(void) {}
+__attribute__((weak)) void INT6_vect(void) {}
+
+typedef struct {
+    uint8_t portb;
+    uint8_t portd;
+    uint8_t gpioa;
+} pin_levels_t;
+
+static pin_levels_t pin_levels(void)
+{
+    return (pin_levels_t){ PINB, PIND, connected ? mcp23018_pins_a() : 0xFF };
+}
+
+/* ISCn1:ISCn0 of an external interrupt, 0 is the low level */
+static bool int_edge(uint8_t sense, bool before, bool after)
+{
+    switch (sense) {
+        case 1: return before != after;
+        case 2: return before && !after;
+        case 3: return !before && after;
+        default: return !after;
+    }
+}
+
+static void int_fire(uint8_t n, uint8_t sense, bool before, bool after, void (*vector)(void))
+{
+    if (!int_edge(sense, before, after)) return;
+    EIFR |= 1 << n;
+    if (EIMSK & (1 << n)) {
+        EIFR &= ~(1 << n);
+        vector();
+    }
+}
+
+/* Raise the interrupts of the pins that the switches changed */
+static void pins_changed(pin_levels_t before)
+{
+    pin_levels_t after = pin_levels();
+
+    if ((before.portb ^ after.portb) & PCMSK0) {
+        PCIFR |= 1 << PCIF0;
+        if (PCICR & (1 << PCIE0)) {
+            PCIFR &= ~(1 << PCIF0);
+            PCINT0_vect();
+        }
+    }
+    int_fire(2, (EICRA >> ISC20) & 3, before.portd & (1<<2), after.portd & (1<<2), INT2_vect);
+    int_fire(3, (EICRA >> ISC30) & 3, before.portd & (1<<3), after.portd & (1<<3), INT3_vect);
+
+    uint8_t compare = (registers[INTCONA_] & registers[DEFVALA_]) | (~registers[INTCONA_] & previous_a);
+    uint8_t flags = (after.gpioa ^ compare) & registers[GPINTENA_];
+    previous_a = after.gpioa;
+    if (flags && !registers[INTFA_]) {
+        registers[INTFA_] = flags;
+        registers[INTCAPA_] = after.gpioa ^ registers[IPOLA_];
+        // INTA is wired to PE6, active low
+        int_fire(6, (EICRB >> ISC60) & 3, true, false, INT6_vect);
+    }
+}
+
+/*
+ * test_matrix.h
+ */
+void press_key(uint8_t col, uint8_t row)
+{
+    pin_levels_t before = pin_levels();
+    switches[row] |= (matrix_row_t)1 << col;
+    pins_changed(before);
+}
+
+void release_key(uint8_t col, uint8_t row)
+{
+    pin_levels_t before = pin_levels();
+    switches[row] &= ~((matrix_row_t)1 << col);
+    pins_changed(before);
+}
+
+void clear_all_keys(void)
+{
+    pin_levels_t before = pin_levels();
+    memset(switches, 0, sizeof(switches));
+    pins_changed(before);
+}
+
+void led_set(uint8_t usb_led)
+{
+}
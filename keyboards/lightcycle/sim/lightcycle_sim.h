@@ -0,0 +1,73 @@
+/* Copyright 2017
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIGHTCYCLE_SIM_H
+#define LIGHTCYCLE_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Host model of the lightcycle hardware, see tests/lightcycle.
+//
+// It replaces twimaster.c and the Teensy ports, so that matrix.c and
+// lightcycle.c are built unchanged for the host. press_key() of
+// test_matrix.h closes a switch of the model. The right hand is read through
+// PINB/PIND while its row is driven low on PORTF. The left hand sits behind
+// an MCP23018 on the I2C bus, with its register file, address pointer and
+// output latches.
+//
+// A switch that changes a column raises its pin change or external
+// interrupt, and the interrupt-on-change of the expander, whose INTA is
+// taken to be wired to PE6. The vectors are called right away.
+//
+// Every byte on the bus adds to the bus time, so the time a scan takes can be
+// measured. The expander can also be unplugged to exercise the
+// mcp23018_status reset loop.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default bus timing, for the 400 kHz clock of twimaster.c
+#ifndef SIM_TRANSACTION_US
+#define SIM_TRANSACTION_US 5    // start and stop conditions
+#endif
+#ifndef SIM_BYTE_US
+#define SIM_BYTE_US 23          // 8 bits and the acknowledge
+#endif
+
+typedef struct {
+    uint32_t starts;    // start and repeated start conditions
+    uint32_t bytes;     // address and data bytes
+    uint32_t nacks;     // addresses that weren't acknowledged
+    uint32_t busy_us;   // time on the bus and in _delay_us()
+} sim_stats_t;
+
+// Power on reset of the MCP23018, which plugs it in and clears the stats.
+// The firmware has to initialize it again.
+void sim_reset(void);
+void sim_set_bus_time(uint16_t transaction_us, uint16_t byte_us);
+void sim_mcp23018_connect(bool connected);
+uint8_t sim_mcp23018_register(uint8_t address);
+
+const sim_stats_t *sim_stats(void);
+void sim_clear_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -8,6 +8,8 @@
 **************************************************************************/
 #include <inttypes.h>
 #include <compat/twi.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
 
 #include <i2cmaster.h>
 
@@ -19,6 +21,17 @@
 /* I2C clock in Hz */
 #define SCL_CLOCK  400000L
 
+/* TWCR value used while the interrupt driven engine owns the bus */
+#define TWCR_ASYNC ((1<<TWINT) | (1<<TWEN) | (1<<TWIE))
+
+/* transactions queued by i2c_submit(), the one at the tail is in flight */
+static i2c_transaction_t *i2c_queue[I2C_QUEUE_SIZE];
+static volatile uint8_t i2c_queue_head = 0;
+static volatile uint8_t i2c_queue_tail = 0;
+
+/* index of the next byte to write or read in the current transaction */
+static uint8_t i2c_index;
+
 
 /*************************************************************************
  Initialization of the I2C bus interface. Need to be called only once
@@ -47,6 +60,9 @@ unsigned char i2c_start(unsigned char address)
 {
     uint8_t   twst;
 
+  // let any submitted transactions finish first
+  i2c_wait_idle();
+
   // send START condition
   TWCR = (1<<TWINT) | (1<<TWSTA) | (1<<TWEN);
 
@@ -83,6 +99,7 @@ void i2c_start_wait(unsigned char address)
 {
     uint8_t   twst;
 
+    i2c_wait_idle();
 
     while ( 1 )
     {
@@ -205,3 +222,155 @@ unsigned char i2c_readNak(void)
   return TWDR;
 
 }/* i2c_readNak */
+
+
+/*************************************************************************
+ Start the transaction at the tail of the queue.
+ Must be called with interrupts disabled.
+*************************************************************************/
+static void i2c_begin(void)
+{
+  // a previous stop condition has to be executed before the next start
+  while(TWCR & (1<<TWSTO));
+
+  i2c_index = 0;
+  TWCR = TWCR_ASYNC | (1<<TWSTA);
+
+}/* i2c_begin */
+
+
+/*************************************************************************
+ Complete the current transaction, and start the next one if any.
+ Called from the TWI interrupt.
+*************************************************************************/
+static void i2c_finish(uint8_t status)
+{
+  i2c_transaction_t *transaction = i2c_queue[i2c_queue_tail];
+
+  i2c_queue_tail = (i2c_queue_tail + 1) % I2C_QUEUE_SIZE;
+  transaction->status = status;
+
+  if (i2c_queue_tail != i2c_queue_head) {
+    // stop condition directly followed by a start condition
+    i2c_index = 0;
+    TWCR = TWCR_ASYNC | (1<<TWSTO) | (1<<TWSTA);
+  } else {
+    // stop condition, and hand the bus back to the blocking functions
+    TWCR = (1<<TWINT) | (1<<TWEN) | (1<<TWSTO);
+  }
+
+  if (transaction->callback) transaction->callback(transaction);
+
+}/* i2c_finish */
+
+
+/*************************************************************************
+ Queue a transaction to be run by the TWI interrupt
+
+ Input:   descriptor of the transaction, it must stay valid until
+          its status is no longer I2C_PENDING
+ Return:  0 queued
+          1 the queue is full
+*************************************************************************/
+unsigned char i2c_submit(i2c_transaction_t *transaction)
+{
+  unsigned char ret = 1;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    uint8_t next = (i2c_queue_head + 1) % I2C_QUEUE_SIZE;
+    if (next != i2c_queue_tail) {
+      uint8_t idle = (i2c_queue_head == i2c_queue_tail);
+
+      transaction->status = I2C_PENDING;
+      i2c_queue[i2c_queue_head] = transaction;
+      i2c_queue_head = next;
+      if (idle) i2c_begin();
+      ret = 0;
+    }
+  }
+  return ret;
+
+}/* i2c_submit */
+
+
+/*************************************************************************
+ Return:  1 if any submitted transaction hasn't completed yet
+*************************************************************************/
+unsigned char i2c_busy(void)
+{
+  return i2c_queue_head != i2c_queue_tail;
+
+}/* i2c_busy */
+
+
+/*************************************************************************
+ Wait until all submitted transactions have completed
+*************************************************************************/
+void i2c_wait_idle(void)
+{
+  while(i2c_busy());
+
+  // wait until the last stop condition is executed and bus released
+  while(TWCR & (1<<TWSTO));
+
+}/* i2c_wait_idle */
+
+
+/*************************************************************************
+ TWI state machine for submitted transactions
+*************************************************************************/
+ISR(TWI_vect)
+{
+  i2c_transaction_t *transaction = i2c_queue[i2c_queue_tail];
+
+  switch (TW_STATUS & 0xF8) {
+  case TW_START:
+    // write phase first, if there is one
+    i2c_index = 0;
+    TWDR = (transaction->address<<1) | (transaction->write_length ? I2C_WRITE : I2C_READ);
+    TWCR = TWCR_ASYNC;
+    break;
+
+  case TW_REP_START:
+    // only issued to switch to the read phase
+    i2c_index = 0;
+    TWDR = (transaction->address<<1) | I2C_READ;
+    TWCR = TWCR_ASYNC;
+    break;
+
+  case TW_MT_SLA_ACK:
+  case TW_MT_DATA_ACK:
+    if (i2c_index < transaction->write_length) {
+      TWDR = transaction->write_data[i2c_index++];
+      TWCR = TWCR_ASYNC;
+    } else if (transaction->read_length) {
+      TWCR = TWCR_ASYNC | (1<<TWSTA);
+    } else {
+      i2c_finish(0);
+    }
+    break;
+
+  case TW_MR_DATA_ACK:
+    transaction->read_data[i2c_index++] = TWDR;
+    // fall through
+  case TW_MR_SLA_ACK:
+    // ACK every byte but the last one
+    if (i2c_index + 1 < transaction->read_length) {
+      TWCR = TWCR_ASYNC | (1<<TWEA);
+    } else {
+      TWCR = TWCR_ASYNC;
+    }
+    break;
+
+  case TW_MR_DATA_NACK:
+    transaction->read_data[i2c_index++] = TWDR;
+    i2c_finish(0);
+    break;
+
+  default:
+    // no acknowledge from the device, or lost arbitration
+    i2c_finish(1);
+    break;
+  }
+
+}/* ISR(TWI_vect) */
@@ -0,0 +1,23 @@
+# Build stage for KEYMAP_BITMAP_ENABLE. The keymap is compiled as usual, then
+# util/keymap_bitmap.sh reads keymaps[] back from the object file and
+# generates keymap_bitmap.c, which marks every entry that isn't KC_TRNS.
+#
+# Expects KEYMAP_BITMAP_OUTPUT, the output the keymap is compiled in, and
+# KEYMAP_BITMAP_KEYMAP_C, the keymap source. Has to be included before
+# $(TMK_PATH)/rules.mk.
+
+KEYMAP_BITMAP_C := $(KEYMAP_BITMAP_OUTPUT)/keymap_bitmap.c
+KEYMAP_BITMAP_OBJ := $(KEYMAP_BITMAP_OUTPUT)/keymap_bitmap.o
+KEYMAP_BITMAP_KEYMAP_OBJ := $(KEYMAP_BITMAP_OUTPUT)/$(KEYMAP_BITMAP_KEYMAP_C:.c=.o)
+
+$(KEYMAP_BITMAP_OUTPUT)_OBJ += $(KEYMAP_BITMAP_OBJ)
+
+$(KEYMAP_BITMAP_C): $(KEYMAP_BITMAP_KEYMAP_OBJ)
+	@$(SILENT) || printf "$(MSG_GENERATING) $@" | $(AWK_CMD)
+	$(eval CMD=$(SHELL) util/keymap_bitmap.sh $(OBJDUMP) $(OBJCOPY) $< $(KEYMAP_BITMAP_KEYMAP_C) > $@ || (rm -f $@; exit 1))
+	@$(BUILD_CMD)
+
+$(KEYMAP_BITMAP_OBJ): $(KEYMAP_BITMAP_C) $(KEYMAP_BITMAP_OUTPUT)/cflags.txt
+	@$(SILENT) || printf "$(MSG_COMPILING) $<" | $(AWK_CMD)
+	$(eval CMD=$(CC) -c $($(KEYMAP_BITMAP_OUTPUT)_CFLAGS) $< -o $@)
+	@$(BUILD_CMD)
@@ -850,12 +850,12 @@ const macro_t *action_get_macro(keyrecord_t *record, uint8_t id, uint8_t opt)
 		if (record->event.pressed) {
 			start = timer_read();
 			if (layer_state == (1<<JPKAZARI)) {
-				layer_state = (1<<JPTOPROW)| (1<<JPTRKZ);
+				layer_state_set((1<<JPTOPROW)| (1<<JPTRKZ));
 			} else {
-				layer_state = (1<<JPTOPROW);							
+				layer_state_set((1<<JPTOPROW));							
 			} 
       } else {
-			layer_state = (0<<JPTOPROW);
+			layer_state_set((0<<JPTOPROW));
 			clear_keyboard_but_mods();
 			if (timer_elapsed(start) < 100) {
 				return MACRO( I(1), T(SPC), END);
@@ -866,14 +866,14 @@ const macro_t *action_get_macro(keyrecord_t *record, uint8_t id, uint8_t opt)
 		if (record->event.pressed) {
 			start = timer_read();
 			if (layer_state == (1<<JPTOPROW)) {
-				layer_state = (1<<JPKAZARI)| (1<<JPTRKZ);
+				layer_state_set((1<<JPKAZARI)| (1<<JPTRKZ));
 			} else {
-				layer_state = (1<<JPKAZARI);							
+				layer_state_set((1<<JPKAZARI));							
 			} 
 			break;
       } else {
-		  	layer_state = (0<<JPKAZARI);
-			layer_state = (0<<JPTRKZ);
+		  	layer_state_set((0<<JPKAZARI));
+			layer_state_set((0<<JPTRKZ));
 		if (timer_elapsed(start) < 100) {
           return MACRO( T(ENTER), END);
         }
@@ -882,9 +882,9 @@ const macro_t *action_get_macro(keyrecord_t *record, uint8_t id, uint8_t opt)
 		case JPFN:
 			if (record->event.pressed) {
 				start = timer_read();
-				layer_state = (1<<JPXON);
+				layer_state_set((1<<JPXON));
 			} else {
-				layer_state = (0<<JPXON);
+				layer_state_set((0<<JPXON));
 				if (timer_elapsed(start) < 100) {
 					return MACRO( T(F7), END);
 				}
@@ -893,9 +893,9 @@ const macro_t *action_get_macro(keyrecord_t *record, uint8_t id, uint8_t opt)
 		case TOJPLOUT:
 			if (record->event.pressed) {
 				if (default_layer_state == (1<<JP)) {
-					default_layer_state = (0<<JP);
+					default_layer_set((0<<JP));
 				} else {
-					default_layer_state = (1<<JP);
+					default_layer_set((1<<JP));
 				}
 				return MACRO( T(ZKHK), END);
 			}
@@ -907,14 +907,14 @@ const macro_t *action_get_macro(keyrecord_t *record, uint8_t id, uint8_t opt)
 		// TOJPLOUT works in the same way but is used for switching engines on external systems.
 		case TOJPL:
 			if (record->event.pressed) {
-				default_layer_state = (1<<JP);
+				default_layer_set((1<<JP));
 				return MACRO( D(LCTL), T(END), U(LCTL), END);
 				//return MACRO( D(LCTL), T(END), U(LCTL), W(250), W(250), W(250), T(SPACE), END);
 			}
 			break;
 		case TOENL:
 			if (record->event.pressed) {
-				default_layer_state = (1<<BASE);
+				default_layer_set((1<<BASE));
 				return MACRO( D(LCTL), T(HOME), U(LCTL), END);
 			//return MACRO( D(LCTL), T(HOME), U(LCTL), W(250), W(250), W(250), T(SPACE), END);
 			}
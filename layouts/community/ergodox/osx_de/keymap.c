@@ -156,8 +156,8 @@ switch(id) {
 case M_TOGGLE_5:
 //Macro: M_TOGGLE_5//-----------------------
  if (record->event.pressed){
-           layer_state ^= (1<<5);
-           layer_state &= (1<<5);
+           layer_xor(1<<5);
+           layer_and(1<<5);
         }
 
 break;
@@ -390,11 +390,11 @@ case SMLY_TOG_QUOT:
 //Macro: SMLY_TOG_QUOT//-----------------------
 if (record->event.pressed) {
 			start = timer_read();
-           layer_state ^= (1<<SMLY);
-           layer_state &= (1<<SMLY);
+           layer_xor(1<<SMLY);
+           layer_and(1<<SMLY);
 			return MACRO_NONE; 		} else {
-           layer_state ^= (1<<SMLY);
-           layer_state &= (1<<SMLY);
+           layer_xor(1<<SMLY);
+           layer_and(1<<SMLY);
 			if (timer_elapsed(start) >150) {
 				return MACRO_NONE;
 			} else {
@@ -406,8 +406,8 @@ break;
 case M_TOGGLE_5:
 //Macro: M_TOGGLE_5//-----------------------
  if (record->event.pressed){
-           layer_state ^= (1<<5);
-           layer_state &= (1<<5);
+           layer_xor(1<<5);
+           layer_and(1<<5);
         }
 
 break;
@@ -415,12 +415,12 @@ case TGH_NUM:
 //Macro: TGH_NUM//-----------------------
 if (record->event.pressed){
          start = timer_read();
-         layer_state ^=(1<<NUMB);
-         layer_state &=(1<<NUMB);
+         layer_xor(1<<NUMB);
+         layer_and(1<<NUMB);
  } else {
          if (timer_elapsed(start) > 150) {
-                 layer_state^=(1<<NUMB);
-                 layer_state&=(1<<NUMB);
+                 layer_xor(1<<NUMB);
+                 layer_and(1<<NUMB);
          }
  }
 return MACRO_NONE;
@@ -495,12 +495,12 @@ case TOG_HLD_MDIA:
 //Macro: TOG_HLD_MDIA//-----------------------
 if (record->event.pressed){
          start = timer_read();
-         layer_state ^=(1<<MDIA);
-         layer_state &=(1<<MDIA);
+         layer_xor(1<<MDIA);
+         layer_and(1<<MDIA);
  } else {
          if (timer_elapsed(start) > 150) {
-                 layer_state^=(1<<MDIA);
-                 layer_state&=(1<<MDIA);
+                 layer_xor(1<<MDIA);
+                 layer_and(1<<MDIA);
          }
  }
 return MACRO_NONE;
@@ -21,6 +21,7 @@
   #include <avr/pgmspace.h>
   #include <avr/interrupt.h>
   #include <avr/io.h>
+  #include <util/atomic.h>
 #endif
 #include "print.h"
 #include "audio.h"
@@ -28,8 +29,7 @@
 #include "wait.h"
 
 #include "eeconfig.h"
-
-#define CPU_PRESCALER 8
+#include "synth.h"
 
 // -----------------------------------------------------------------------------
 // Timer Abstractions
@@ -78,37 +78,50 @@
 
 int voices = 0;
 int voice_place = 0;
-float frequency = 0;
-float frequency_alt = 0;
+uint16_t pitch = 0;
+uint16_t pitch_alt = 0;
 int volume = 0;
 long position = 0;
 
-float frequencies[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+uint16_t pitches[8] = {0, 0, 0, 0, 0, 0, 0, 0};
 int volumes[8] = {0, 0, 0, 0, 0, 0, 0, 0};
 bool sliding = false;
 
-float place = 0;
+uint32_t place = 0;
 
 uint8_t * sample;
 uint16_t sample_length = 0;
 
 bool     playing_notes = false;
 bool     playing_note = false;
-float    note_frequency = 0;
-float    note_length = 0;
+uint16_t note_pitch = 0;
+uint32_t note_duration = 0;
+uint32_t note_elapsed = 0;
+uint16_t note_ticks = 0;
 uint8_t  note_tempo = TEMPO_DEFAULT;
-float    note_timbre = TIMBRE_DEFAULT;
 uint16_t note_position = 0;
 float (* notes_pointer)[][2];
 uint16_t notes_count;
 bool     notes_repeat;
 bool     note_resting = false;
 
-uint8_t current_note = 0;
 uint8_t rest_counter = 0;
 
+// audio_task() converts the song a few notes ahead, so that the ISRs only
+// load integers at note boundaries
+#ifndef AUDIO_SONG_LOOKAHEAD
+#define AUDIO_SONG_LOOKAHEAD 8
+#endif
+
+static synth_note_t song_notes[AUDIO_SONG_LOOKAHEAD];
+// the next note for the ISRs, and how many are converted from there on
+static volatile uint8_t song_head = 0;
+static volatile uint8_t song_count = 0;
+// the next note of the song to convert, and whether the last one is
+static uint16_t song_next = 0;
+static volatile bool song_converted = false;
+
 #ifdef VIBRATO_ENABLE
-float vibrato_counter = 0;
 float vibrato_strength = .5;
 float vibrato_rate = 0.125;
 #endif
@@ -119,9 +132,6 @@ static bool audio_initialized = false;
 
 audio_config_t audio_config;
 
-uint16_t envelope_index = 0;
-bool glissando = true;
-
 #ifndef STARTUP_SONG
     #define STARTUP_SONG SONG(STARTUP_SOUND)
 #endif
@@ -185,8 +195,8 @@ void audio_init()
             TCCR1A = (0 << COM1A1) | (0 << COM1A0) | (1 << WGM11) | (0 << WGM10);
             TCCR1B = (1 << WGM13)  | (1 << WGM12)  | (0 << CS12)  | (1 << CS11) | (0 << CS10);
 
-            TIMER_1_PERIOD = (uint16_t)(((float)F_CPU) / (440 * CPU_PRESCALER));
-            TIMER_1_DUTY_CYCLE = (uint16_t)((((float)F_CPU) / (440 * CPU_PRESCALER)) * note_timbre);
+            TIMER_1_PERIOD = synth_period(SYNTH_PITCH(69));
+            TIMER_1_DUTY_CYCLE = ((uint32_t)TIMER_1_PERIOD * note_timbre) >> 8;
         #endif
 
         audio_initialized = true;
@@ -220,13 +230,13 @@ void stop_all_notes()
 
     playing_notes = false;
     playing_note = false;
-    frequency = 0;
-    frequency_alt = 0;
+    pitch = 0;
+    pitch_alt = 0;
     volume = 0;
 
     for (uint8_t i = 0; i < 8; i++)
     {
-        frequencies[i] = 0;
+        pitches[i] = 0;
         volumes[i] = 0;
     }
 }
@@ -239,13 +249,14 @@ void stop_note(float freq)
         if (!audio_initialized) {
             audio_init();
         }
+        uint16_t freq_pitch = synth_pitch_from_frequency(freq);
         for (int i = 7; i >= 0; i--) {
-            if (frequencies[i] == freq) {
-                frequencies[i] = 0;
+            if (pitches[i] == freq_pitch) {
+                pitches[i] = 0;
                 volumes[i] = 0;
                 for (int j = i; (j < 7); j++) {
-                    frequencies[j] = frequencies[j+1];
-                    frequencies[j+1] = 0;
+                    pitches[j] = pitches[j+1];
+                    pitches[j+1] = 0;
                     volumes[j] = volumes[j+1];
                     volumes[j+1] = 0;
                 }
@@ -267,160 +278,106 @@ void stop_note(float freq)
                 DISABLE_AUDIO_COUNTER_1_ISR;
                 DISABLE_AUDIO_COUNTER_1_OUTPUT;
             #endif
-            frequency = 0;
-            frequency_alt = 0;
+            pitch = 0;
+            pitch_alt = 0;
             volume = 0;
             playing_note = false;
         }
     }
 }
 
-#ifdef VIBRATO_ENABLE
-
-float mod(float a, int b)
+// Starts the next converted note
+static void song_load_next(void)
 {
-    float r = fmod(a, b);
-    return r < 0 ? r + b : r;
+    note_pitch = song_notes[song_head].pitch;
+    note_duration = song_notes[song_head].duration;
+    note_ticks = song_notes[song_head].ticks;
+    note_elapsed = 0;
+    song_head = (song_head + 1) % AUDIO_SONG_LOOKAHEAD;
+    song_count--;
 }
 
-float vibrato(float average_freq) {
-    #ifdef VIBRATO_STRENGTH_ENABLE
-        float vibrated_freq = average_freq * pow(vibrato_lut[(int)vibrato_counter], vibrato_strength);
-    #else
-        float vibrated_freq = average_freq * vibrato_lut[(int)vibrato_counter];
-    #endif
-    vibrato_counter = mod((vibrato_counter + vibrato_rate * (1.0 + 440.0/average_freq)), VIBRATO_LUT_LENGTH);
-    return vibrated_freq;
+// Moves the song on at the end of a note, or of the rest of one tick after
+// it, and returns false when the song is over
+static bool song_advance(void)
+{
+    if (!note_resting) {
+        if (song_count == 0 && song_converted) {
+            return false;
+        }
+        // the rest is silent when the next note has the same pitch
+        note_resting = true;
+        if (song_count == 0 || song_notes[song_head].pitch == note_pitch) {
+            note_pitch = 0;
+        }
+        note_ticks = 1;
+    } else if (song_count > 0) {
+        note_resting = false;
+        synth_reset_envelope();
+        song_load_next();
+    } else if (song_converted) {
+        return false;
+    }
+    // otherwise the rest lasts until audio_task() has converted the next note
+    return true;
 }
 
-#endif
-
 #ifdef C6_AUDIO
 ISR(TIMER3_COMPA_vect)
 {
-    float freq;
+    uint16_t period;
+    uint16_t duty;
 
     if (playing_note) {
         if (voices > 0) {
 
             #ifdef B5_AUDIO
-            float freq_alt = 0;
                 if (voices > 1) {
-                    if (polyphony_rate == 0) {
+                    if (polyphony_period == 0) {
                         if (glissando) {
-                            if (frequency_alt != 0 && frequency_alt < frequencies[voices - 2] && frequency_alt < frequencies[voices - 2] * pow(2, -440/frequencies[voices - 2]/12/2)) {
-                                frequency_alt = frequency_alt * pow(2, 440/frequency_alt/12/2);
-                            } else if (frequency_alt != 0 && frequency_alt > frequencies[voices - 2] && frequency_alt > frequencies[voices - 2] * pow(2, 440/frequencies[voices - 2]/12/2)) {
-                                frequency_alt = frequency_alt * pow(2, -440/frequency_alt/12/2);
-                            } else {
-                                frequency_alt = frequencies[voices - 2];
-                            }
+                            pitch_alt = synth_glide(pitch_alt, pitches[voices - 2], TIMER_1_PERIOD);
                         } else {
-                            frequency_alt = frequencies[voices - 2];
+                            pitch_alt = pitches[voices - 2];
                         }
-
-                        #ifdef VIBRATO_ENABLE
-                            if (vibrato_strength > 0) {
-                                freq_alt = vibrato(frequency_alt);
-                            } else {
-                                freq_alt = frequency_alt;
-                            }
-                        #else
-                            freq_alt = frequency_alt;
-                        #endif
-                    }
-
-                    if (envelope_index < 65535) {
-                        envelope_index++;
                     }
 
-                    freq_alt = voice_envelope(freq_alt);
-
-                    if (freq_alt < 30.517578125) {
-                        freq_alt = 30.52;
-                    }
-
-                    TIMER_1_PERIOD = (uint16_t)(((float)F_CPU) / (freq_alt * CPU_PRESCALER));
-                    TIMER_1_DUTY_CYCLE = (uint16_t)((((float)F_CPU) / (freq_alt * CPU_PRESCALER)) * note_timbre);
+                    period = synth_tick(pitch_alt, TIMER_1_PERIOD, &duty);
+                    TIMER_1_PERIOD = period;
+                    TIMER_1_DUTY_CYCLE = duty;
                 }
             #endif
 
-            if (polyphony_rate > 0) {
+            if (polyphony_period > 0) {
                 if (voices > 1) {
                     voice_place %= voices;
-                    if (place++ > (frequencies[voice_place] / polyphony_rate / CPU_PRESCALER)) {
+                    place += TIMER_3_PERIOD;
+                    if (place > polyphony_period) {
                         voice_place = (voice_place + 1) % voices;
-                        place = 0.0;
+                        place = 0;
                     }
                 }
 
-                #ifdef VIBRATO_ENABLE
-                    if (vibrato_strength > 0) {
-                        freq = vibrato(frequencies[voice_place]);
-                    } else {
-                        freq = frequencies[voice_place];
-                    }
-                #else
-                    freq = frequencies[voice_place];
-                #endif
+                period = synth_tick(pitches[voice_place], TIMER_3_PERIOD, &duty);
             } else {
                 if (glissando) {
-                    if (frequency != 0 && frequency < frequencies[voices - 1] && frequency < frequencies[voices - 1] * pow(2, -440/frequencies[voices - 1]/12/2)) {
-                        frequency = frequency * pow(2, 440/frequency/12/2);
-                    } else if (frequency != 0 && frequency > frequencies[voices - 1] && frequency > frequencies[voices - 1] * pow(2, 440/frequencies[voices - 1]/12/2)) {
-                        frequency = frequency * pow(2, -440/frequency/12/2);
-                    } else {
-                        frequency = frequencies[voices - 1];
-                    }
+                    pitch = synth_glide(pitch, pitches[voices - 1], TIMER_3_PERIOD);
                 } else {
-                    frequency = frequencies[voices - 1];
+                    pitch = pitches[voices - 1];
                 }
 
-                #ifdef VIBRATO_ENABLE
-                    if (vibrato_strength > 0) {
-                        freq = vibrato(frequency);
-                    } else {
-                        freq = frequency;
-                    }
-                #else
-                    freq = frequency;
-                #endif
-            }
-
-            if (envelope_index < 65535) {
-                envelope_index++;
-            }
-
-            freq = voice_envelope(freq);
-
-            if (freq < 30.517578125) {
-                freq = 30.52;
+                period = synth_tick(pitch, TIMER_3_PERIOD, &duty);
             }
 
-            TIMER_3_PERIOD = (uint16_t)(((float)F_CPU) / (freq * CPU_PRESCALER));
-            TIMER_3_DUTY_CYCLE = (uint16_t)((((float)F_CPU) / (freq * CPU_PRESCALER)) * note_timbre);
+            TIMER_3_PERIOD = period;
+            TIMER_3_DUTY_CYCLE = duty;
         }
     }
 
     if (playing_notes) {
-        if (note_frequency > 0) {
-            #ifdef VIBRATO_ENABLE
-                if (vibrato_strength > 0) {
-                    freq = vibrato(note_frequency);
-                } else {
-                    freq = note_frequency;
-                }
-            #else
-                    freq = note_frequency;
-            #endif
-
-            if (envelope_index < 65535) {
-                envelope_index++;
-            }
-            freq = voice_envelope(freq);
-
-            TIMER_3_PERIOD = (uint16_t)(((float)F_CPU) / (freq * CPU_PRESCALER));
-            TIMER_3_DUTY_CYCLE = (uint16_t)((((float)F_CPU) / (freq * CPU_PRESCALER)) * note_timbre);
+        if (note_pitch > 0) {
+            period = synth_tick(note_pitch, TIMER_3_PERIOD, &duty);
+            TIMER_3_PERIOD = period;
+            TIMER_3_DUTY_CYCLE = duty;
         } else {
             TIMER_3_PERIOD = 0;
             TIMER_3_DUTY_CYCLE = 0;
@@ -428,44 +385,20 @@ ISR(TIMER3_COMPA_vect)
 
         note_position++;
         bool end_of_note = false;
-        if (TIMER_3_PERIOD > 0) {
-            if (!note_resting) 
-                end_of_note = (note_position >= (note_length / TIMER_3_PERIOD * 0xFFFF - 1));
-            else
-                end_of_note = (note_position >= (note_length));
+        if (TIMER_3_PERIOD > 0 && !note_resting) {
+            note_elapsed += TIMER_3_PERIOD;
+            end_of_note = (note_elapsed >= note_duration);
         } else {
-            end_of_note = (note_position >= (note_length));
+            end_of_note = (note_position >= note_ticks);
         }
 
         if (end_of_note) {
-            current_note++;
-            if (current_note >= notes_count) {
-                if (notes_repeat) {
-                    current_note = 0;
-                } else {
-                    DISABLE_AUDIO_COUNTER_3_ISR;
-                    DISABLE_AUDIO_COUNTER_3_OUTPUT;
-                    playing_notes = false;
-                    return;
-                }
-            }
-            if (!note_resting) {
-                note_resting = true;
-                current_note--;
-                if ((*notes_pointer)[current_note][0] == (*notes_pointer)[current_note + 1][0]) {
-                    note_frequency = 0;
-                    note_length = 1;
-                } else {
-                    note_frequency = (*notes_pointer)[current_note][0];
-                    note_length = 1;
-                }
-            } else {
-                note_resting = false;
-                envelope_index = 0;
-                note_frequency = (*notes_pointer)[current_note][0];
-                note_length = ((*notes_pointer)[current_note][1] / 4) * (((float)note_tempo) / 100);
+            if (!song_advance()) {
+                DISABLE_AUDIO_COUNTER_3_ISR;
+                DISABLE_AUDIO_COUNTER_3_OUTPUT;
+                playing_notes = false;
+                return;
             }
-
             note_position = 0;
         }
     }
@@ -481,86 +414,42 @@ ISR(TIMER3_COMPA_vect)
 ISR(TIMER1_COMPA_vect)
 {
     #if defined(B5_AUDIO) && !defined(C6_AUDIO)
-    float freq = 0;
+    uint16_t period;
+    uint16_t duty;
 
     if (playing_note) {
         if (voices > 0) {
-            if (polyphony_rate > 0) {
+            if (polyphony_period > 0) {
                 if (voices > 1) {
                     voice_place %= voices;
-                    if (place++ > (frequencies[voice_place] / polyphony_rate / CPU_PRESCALER)) {
+                    place += TIMER_1_PERIOD;
+                    if (place > polyphony_period) {
                         voice_place = (voice_place + 1) % voices;
-                        place = 0.0;
+                        place = 0;
                     }
                 }
 
-                #ifdef VIBRATO_ENABLE
-                    if (vibrato_strength > 0) {
-                        freq = vibrato(frequencies[voice_place]);
-                    } else {
-                        freq = frequencies[voice_place];
-                    }
-                #else
-                    freq = frequencies[voice_place];
-                #endif
+                period = synth_tick(pitches[voice_place], TIMER_1_PERIOD, &duty);
             } else {
                 if (glissando) {
-                    if (frequency != 0 && frequency < frequencies[voices - 1] && frequency < frequencies[voices - 1] * pow(2, -440/frequencies[voices - 1]/12/2)) {
-                        frequency = frequency * pow(2, 440/frequency/12/2);
-                    } else if (frequency != 0 && frequency > frequencies[voices - 1] && frequency > frequencies[voices - 1] * pow(2, 440/frequencies[voices - 1]/12/2)) {
-                        frequency = frequency * pow(2, -440/frequency/12/2);
-                    } else {
-                        frequency = frequencies[voices - 1];
-                    }
+                    pitch = synth_glide(pitch, pitches[voices - 1], TIMER_1_PERIOD);
                 } else {
-                    frequency = frequencies[voices - 1];
+                    pitch = pitches[voices - 1];
                 }
 
-                #ifdef VIBRATO_ENABLE
-                    if (vibrato_strength > 0) {
-                        freq = vibrato(frequency);
-                    } else {
-                        freq = frequency;
-                    }
-                #else
-                    freq = frequency;
-                #endif
-            }
-
-            if (envelope_index < 65535) {
-                envelope_index++;
-            }
-
-            freq = voice_envelope(freq);
-
-            if (freq < 30.517578125) {
-                freq = 30.52;
+                period = synth_tick(pitch, TIMER_1_PERIOD, &duty);
             }
 
-            TIMER_1_PERIOD = (uint16_t)(((float)F_CPU) / (freq * CPU_PRESCALER));
-            TIMER_1_DUTY_CYCLE = (uint16_t)((((float)F_CPU) / (freq * CPU_PRESCALER)) * note_timbre);
+            TIMER_1_PERIOD = period;
+            TIMER_1_DUTY_CYCLE = duty;
         }
     }
 
     if (playing_notes) {
-        if (note_frequency > 0) {
-            #ifdef VIBRATO_ENABLE
-                if (vibrato_strength > 0) {
-                    freq = vibrato(note_frequency);
-                } else {
-                    freq = note_frequency;
-                }
-            #else
-                    freq = note_frequency;
-            #endif
-
-            if (envelope_index < 65535) {
-                envelope_index++;
-            }
-            freq = voice_envelope(freq);
-
-            TIMER_1_PERIOD = (uint16_t)(((float)F_CPU) / (freq * CPU_PRESCALER));
-            TIMER_1_DUTY_CYCLE = (uint16_t)((((float)F_CPU) / (freq * CPU_PRESCALER)) * note_timbre);
+        if (note_pitch > 0) {
+            period = synth_tick(note_pitch, TIMER_1_PERIOD, &duty);
+            TIMER_1_PERIOD = period;
+            TIMER_1_DUTY_CYCLE = duty;
         } else {
             TIMER_1_PERIOD = 0;
             TIMER_1_DUTY_CYCLE = 0;
@@ -568,44 +457,20 @@ ISR(TIMER1_COMPA_vect)
 
         note_position++;
         bool end_of_note = false;
-        if (TIMER_1_PERIOD > 0) {
-            if (!note_resting) 
-                end_of_note = (note_position >= (note_length / TIMER_1_PERIOD * 0xFFFF - 1));
-            else
-                end_of_note = (note_position >= (note_length));
+        if (TIMER_1_PERIOD > 0 && !note_resting) {
+            note_elapsed += TIMER_1_PERIOD;
+            end_of_note = (note_elapsed >= note_duration);
         } else {
-            end_of_note = (note_position >= (note_length));
+            end_of_note = (note_position >= note_ticks);
         }
 
         if (end_of_note) {
-            current_note++;
-            if (current_note >= notes_count) {
-                if (notes_repeat) {
-                    current_note = 0;
-                } else {
-                    DISABLE_AUDIO_COUNTER_1_ISR;
-                    DISABLE_AUDIO_COUNTER_1_OUTPUT;
-                    playing_notes = false;
-                    return;
-                }
-            }
-            if (!note_resting) {
-                note_resting = true;
-                current_note--;
-                if ((*notes_pointer)[current_note][0] == (*notes_pointer)[current_note + 1][0]) {
-                    note_frequency = 0;
-                    note_length = 1;
-                } else {
-                    note_frequency = (*notes_pointer)[current_note][0];
-                    note_length = 1;
-                }
-            } else {
-                note_resting = false;
-                envelope_index = 0;
-                note_frequency = (*notes_pointer)[current_note][0];
-                note_length = ((*notes_pointer)[current_note][1] / 4) * (((float)note_tempo) / 100);
+            if (!song_advance()) {
+                DISABLE_AUDIO_COUNTER_1_ISR;
+                DISABLE_AUDIO_COUNTER_1_OUTPUT;
+                playing_notes = false;
+                return;
             }
-
             note_position = 0;
         }
     }
@@ -640,10 +505,10 @@ void play_note(float freq, int vol) {
 
         playing_note = true;
 
-        envelope_index = 0;
+        synth_reset_envelope();
 
         if (freq > 0) {
-            frequencies[voices] = freq;
+            pitches[voices] = synth_pitch_from_frequency(freq);
             volumes[voices] = vol;
             voices++;
         }
@@ -694,10 +559,14 @@ void play_notes(float (*np)[][2], uint16_t n_count, bool n_repeat)
         notes_repeat = n_repeat;
 
         place = 0;
-        current_note = 0;
 
-        note_frequency = (*notes_pointer)[current_note][0];
-        note_length = ((*notes_pointer)[current_note][1] / 4) * (((float)note_tempo) / 100);
+        song_head = 0;
+        song_count = 0;
+        song_next = 0;
+        song_converted = false;
+        audio_task();
+        note_resting = false;
+        song_load_next();
         note_position = 0;
 
 
@@ -715,7 +584,32 @@ void play_notes(float (*np)[][2], uint16_t n_count, bool n_repeat)
 
 }
 
+// Converts the notes of the song ahead of the ISRs, from the main loop
+void audio_task(void)
+{
+    while (playing_notes && !song_converted && song_count < AUDIO_SONG_LOOKAHEAD) {
+        uint8_t slot;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            slot = (song_head + song_count) % AUDIO_SONG_LOOKAHEAD;
+        }
+        synth_note_from_song((*notes_pointer)[song_next][0], (*notes_pointer)[song_next][1],
+                             note_tempo, &song_notes[slot]);
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            song_count++;
+        }
+        if (++song_next >= notes_count) {
+            if (notes_repeat) {
+                song_next = 0;
+            } else {
+                song_converted = true;
+            }
+        }
+    }
+}
+
 bool is_playing_notes(void) {
+    // code that waits for a song polls this
+    audio_task();
     return playing_notes;
 }
 
@@ -751,28 +645,34 @@ void audio_off(void) {
 
 void set_vibrato_rate(float rate) {
     vibrato_rate = rate;
+    synth_set_vibrato(vibrato_rate, vibrato_strength);
 }
 
 void increase_vibrato_rate(float change) {
     vibrato_rate *= change;
+    synth_set_vibrato(vibrato_rate, vibrato_strength);
 }
 
 void decrease_vibrato_rate(float change) {
     vibrato_rate /= change;
+    synth_set_vibrato(vibrato_rate, vibrato_strength);
 }
 
 #ifdef VIBRATO_STRENGTH_ENABLE
 
 void set_vibrato_strength(float strength) {
     vibrato_strength = strength;
+    synth_set_vibrato(vibrato_rate, vibrato_strength);
 }
 
 void increase_vibrato_strength(float change) {
     vibrato_strength *= change;
+    synth_set_vibrato(vibrato_rate, vibrato_strength);
 }
 
 void decrease_vibrato_strength(float change) {
     vibrato_strength /= change;
+    synth_set_vibrato(vibrato_rate, vibrato_strength);
 }
 
 #endif  /* VIBRATO_STRENGTH_ENABLE */
@@ -781,30 +681,44 @@ void decrease_vibrato_strength(float change) {
 
 // Polyphony functions
 
+// The ISRs count the time on each voice in timer ticks
+static void update_polyphony_period(void) {
+    if (polyphony_rate > 0) {
+        polyphony_period = AUDIO_TIMER_HZ / (polyphony_rate * CPU_PRESCALER);
+    } else {
+        polyphony_period = 0;
+    }
+}
+
 void set_polyphony_rate(float rate) {
     polyphony_rate = rate;
+    update_polyphony_period();
 }
 
 void enable_polyphony() {
     polyphony_rate = 5;
+    update_polyphony_period();
 }
 
 void disable_polyphony() {
     polyphony_rate = 0;
+    update_polyphony_period();
 }
 
 void increase_polyphony_rate(float change) {
     polyphony_rate *= change;
+    update_polyphony_period();
 }
 
 void decrease_polyphony_rate(float change) {
     polyphony_rate /= change;
+    update_polyphony_period();
 }
 
 // Timbre function
 
 void set_timbre(float timbre) {
-    note_timbre = timbre;
+    note_timbre = SYNTH_TIMBRE(timbre);
 }
 
 // Tempo functions
@@ -33,7 +33,7 @@
 
 // #define VIBRATO_ENABLE
 
-// Enable vibrato strength/amplitude - slows down ISR too much
+// Enable vibrato strength/amplitude
 // #define VIBRATO_STRENGTH_ENABLE
 
 typedef union {
@@ -90,6 +90,8 @@ void play_note(float freq, int vol);
 void stop_note(float freq);
 void stop_all_notes(void);
 void play_notes(float (*np)[][2], uint16_t n_count, bool n_repeat);
+// Converts the playing song ahead of the audio interrupts; call it often
+void audio_task(void);
 
 #define SCALE (int8_t []){ 0 + (12*0), 2 + (12*0), 4 + (12*0), 5 + (12*0), 7 + (12*0), 9 + (12*0), 11 + (12*0), \
                            0 + (12*1), 2 + (12*1), 4 + (12*1), 5 + (12*1), 7 + (12*1), 9 + (12*1), 11 + (12*1), \
@@ -499,6 +499,10 @@ void play_notes(float (*np)[][2], uint16_t n_count, bool n_repeat)
 
 }
 
+// Songs are played from their floats here, so there is nothing to convert
+void audio_task(void) {
+}
+
 bool is_playing_notes(void) {
     return playing_notes;
 }
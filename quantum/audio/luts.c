@@ -15,6 +15,7 @@
  */
 
 #include "luts.h"
+#include "synth.h"
 
 const float vibrato_lut[VIBRATO_LUT_LENGTH] =
 {
@@ -40,6 +41,51 @@ const float vibrato_lut[VIBRATO_LUT_LENGTH] =
 	1.0000000000000,
 };
 
+const int8_t vibrato_pitch_lut[VIBRATO_LUT_LENGTH] PROGMEM =
+{
+	10,
+	19,
+	26,
+	30,
+	32,
+	30,
+	26,
+	19,
+	10,
+	0,
+	-10,
+	-19,
+	-26,
+	-30,
+	-32,
+	-30,
+	-26,
+	-19,
+	-10,
+	0,
+};
+
+// The lowest octave in timer ticks at F_CPU / CPU_PRESCALER, every octave
+// above it halves the periods
+#define NOTE_PERIOD(frequency) ((uint32_t)(AUDIO_TIMER_HZ / (frequency) + 0.5))
+
+const uint32_t note_period_lut[13] PROGMEM =
+{
+	NOTE_PERIOD(8.1757989156),
+	NOTE_PERIOD(8.6619572180),
+	NOTE_PERIOD(9.1770239974),
+	NOTE_PERIOD(9.7227182413),
+	NOTE_PERIOD(10.3008611535),
+	NOTE_PERIOD(10.9133822323),
+	NOTE_PERIOD(11.5623257097),
+	NOTE_PERIOD(12.2498573744),
+	NOTE_PERIOD(12.9782717994),
+	NOTE_PERIOD(13.7500000000),
+	NOTE_PERIOD(14.5676175474),
+	NOTE_PERIOD(15.4338531643),
+	NOTE_PERIOD(16.3515978313),
+};
+
 const uint16_t frequency_lut[FREQUENCY_LUT_LENGTH] =
 {
 	0x8E0B,
@@ -18,10 +18,12 @@
     #include <avr/io.h>
     #include <avr/interrupt.h>
     #include <avr/pgmspace.h>
-#else
+#elif defined(PROTOCOL_CHIBIOS)
     #include "ch.h"
     #include "hal.h"
 #endif
+#include <stdint.h>
+#include "progmem.h"
 
 #ifndef LUTS_H
 #define LUTS_H
@@ -33,4 +35,9 @@
 extern const float vibrato_lut[VIBRATO_LUT_LENGTH];
 extern const uint16_t frequency_lut[FREQUENCY_LUT_LENGTH];
 
+// vibrato_lut as pitch offsets, in 1/256 semitones
+extern const int8_t vibrato_pitch_lut[VIBRATO_LUT_LENGTH];
+// Timer periods of MIDI notes 0 to 12, see synth_period()
+extern const uint32_t note_period_lut[13];
+
 #endif /* LUTS_H */
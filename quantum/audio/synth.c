@@ -0,0 +1,189 @@
+/* Copyright 2017
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "synth.h"
+#include "voices.h"
+#include "luts.h"
+#include "progmem.h"
+#include "musical_notes.h"
+
+uint8_t  note_timbre = SYNTH_TIMBRE(TIMBRE_DEFAULT);
+bool     glissando = true;
+uint16_t envelope_index = 0;
+uint16_t envelope_time = 0;
+uint32_t polyphony_period = 0;
+
+// Q16.16 version of envelope_time
+static uint32_t envelope_accumulator = 0;
+
+// Pitch change of a glissando step per timer tick of the current period, in
+// 1/65536 of a pitch unit.  The original stepped 220 / f semitones per tick.
+#define GLIDE_SCALE ((uint32_t)(((uint64_t)SYNTH_GLIDE_RATE << 24) / AUDIO_TIMER_HZ))
+
+// Envelope time per timer tick, in 1/880 s Q8.24
+#define ENVELOPE_SCALE ((uint32_t)(((uint64_t)880 << 24) / AUDIO_TIMER_HZ))
+
+uint16_t synth_period(uint16_t pitch) {
+    // held notes keep their pitch for most ticks
+    static uint16_t last_pitch = 0;
+    static uint16_t last_period = 0;
+    if (pitch == last_pitch && last_period) {
+        return last_period;
+    }
+
+    uint8_t note = pitch >> 8;
+    uint8_t octave = note / 12;
+    uint8_t step = note % 12;
+    uint32_t low = pgm_read_dword(&note_period_lut[step]);
+    uint32_t high = pgm_read_dword(&note_period_lut[step + 1]);
+
+    // linear interpolation between the semitones is within 0.05% of the
+    // exponential curve
+    uint32_t period = (low - (((low - high) * (pitch & 0xFF)) >> 8)) >> octave;
+    if (period > 0xFFFF) {
+        period = 0xFFFF;
+    } else if (period == 0) {
+        period = 1;
+    }
+    last_pitch = pitch;
+    last_period = period;
+    return period;
+}
+
+uint16_t synth_pitch_from_frequency(float frequency) {
+    if (frequency <= 0) {
+        return 0;
+    }
+    // Q4 so that high notes, with short periods, keep their fraction
+    uint32_t period = (uint32_t)(AUDIO_TIMER_HZ * 16.0f / frequency + 0.5f);
+    uint32_t lowest = pgm_read_dword(&note_period_lut[0]) << 4;
+    if (period >= lowest) {
+        return 1;
+    }
+
+    // find the octave, then the semitone, comparing the period scaled up to
+    // the lowest octave so that no precision is lost
+    uint8_t octave = 0;
+    while (octave < 10 && (period << (octave + 1)) <= lowest) {
+        octave++;
+    }
+    uint32_t scaled = period << octave;
+    uint8_t step = 0;
+    while (step < 11 && scaled <= (pgm_read_dword(&note_period_lut[step + 1]) << 4)) {
+        step++;
+    }
+    uint32_t low = pgm_read_dword(&note_period_lut[step]) << 4;
+    uint32_t high = pgm_read_dword(&note_period_lut[step + 1]) << 4;
+    uint32_t fraction = 0;
+    if (scaled < high) {
+        fraction = 255;
+    } else if (scaled < low) {
+        fraction = ((uint64_t)(low - scaled) * 256 + (low - high) / 2) / (low - high);
+        if (fraction > 255) {
+            fraction = 255;
+        }
+    }
+    return SYNTH_PITCH(octave * 12 + step) + fraction;
+}
+
+void synth_note_from_song(float frequency, float length, uint8_t tempo, synth_note_t *note) {
+    float note_length = (length / 4) * (((float)tempo) / 100);
+
+    note->pitch = synth_pitch_from_frequency(frequency);
+    note->duration = note_length * 0xFFFF;
+    note->ticks = note_length;
+}
+
+uint16_t synth_glide(uint16_t pitch, uint16_t target, uint16_t period) {
+    if (pitch == 0) {
+        return target;
+    }
+    uint16_t step = ((uint32_t)period * GLIDE_SCALE) >> 16;
+    if (step == 0) {
+        step = 1;
+    }
+    if ((uint32_t)pitch + step < target) {
+        return pitch + step;
+    }
+    if (pitch > (uint32_t)target + step) {
+        return pitch - step;
+    }
+    return target;
+}
+
+void synth_reset_envelope(void) {
+    envelope_index = 0;
+    envelope_time = 0;
+    envelope_accumulator = 0;
+}
+
+#ifdef VIBRATO_ENABLE
+
+// Q8.8 position in vibrato_pitch_lut and its advance per tick
+static uint16_t vibrato_counter = 0;
+static uint16_t vibrato_rate = 32;
+// Q8.8, the LUT holds the offsets of full strength
+static uint16_t vibrato_strength = 128;
+
+// Extra advance of the counter at low notes: rate * 440 / f per tick
+#define VIBRATO_SCALE ((uint32_t)(((uint64_t)440 << 24) / AUDIO_TIMER_HZ))
+
+void synth_set_vibrato(float rate, float strength) {
+    vibrato_rate = rate * 256;
+    vibrato_strength = strength * 256;
+}
+
+uint16_t synth_vibrato(uint16_t pitch, uint16_t period) {
+    int16_t offset = (int8_t)pgm_read_byte(&vibrato_pitch_lut[vibrato_counter >> 8]);
+    #ifdef VIBRATO_STRENGTH_ENABLE
+        offset = ((int32_t)offset * vibrato_strength) >> 8;
+    #endif
+    vibrato_counter += vibrato_rate + ((((uint32_t)vibrato_rate * period) >> 8) * VIBRATO_SCALE >> 16);
+    while (vibrato_counter >= (VIBRATO_LUT_LENGTH << 8)) {
+        vibrato_counter -= (VIBRATO_LUT_LENGTH << 8);
+    }
+    return pitch + offset;
+}
+
+#endif
+
+// Advances the envelope by one period of the timer and returns the next one,
+// with its duty cycle in 'duty'.  'previous_period' is the period that just
+// elapsed, which is what the time based parts of the envelope count.
+uint16_t synth_tick(uint16_t pitch, uint16_t previous_period, uint16_t *duty) {
+    #ifdef VIBRATO_ENABLE
+        if (vibrato_strength > 0) {
+            pitch = synth_vibrato(pitch, previous_period);
+        }
+    #endif
+
+    if (envelope_index < 0xFFFF) {
+        envelope_index++;
+    }
+    uint32_t elapsed = ((uint32_t)previous_period * ENVELOPE_SCALE) >> 8;
+    if (envelope_accumulator < 0xFFFFFFFF - elapsed) {
+        envelope_accumulator += elapsed;
+    } else {
+        envelope_accumulator = 0xFFFFFFFF;
+    }
+    envelope_time = envelope_accumulator >> 16;
+
+    pitch = voice_envelope(pitch);
+
+    uint16_t period = synth_period(pitch);
+    *duty = ((uint32_t)period * note_timbre) >> 8;
+    return period;
+}
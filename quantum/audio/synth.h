@@ -0,0 +1,76 @@
+/* Copyright 2017
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SYNTH_H
+#define SYNTH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Fixed point tone generation for the audio ISRs.
+//
+// Pitches are Q8.8 semitones: the MIDI note number in the high byte and a
+// fraction of a semitone in the low byte, so A4 (440 Hz) is 69 << 8. Glide,
+// vibrato and the voices all work on pitches, where they are additions, and
+// synth_period() turns the result into a timer period with a table lookup.
+// Floats are only converted outside the ISRs: when a note is started, by
+// audio_task() for the notes of a song, and in the setters of audio.c.
+
+#ifndef CPU_PRESCALER
+    #define CPU_PRESCALER 8
+#endif
+
+// Timer ticks per second
+#define AUDIO_TIMER_HZ ((uint32_t)(F_CPU / CPU_PRESCALER))
+
+#define SYNTH_PITCH(note) ((uint16_t)(note) << 8)
+
+// Timbres are Q0.8 duty cycles
+#define SYNTH_TIMBRE(t) ((uint8_t)((t) >= 1.0 ? 255 : (t) * 256))
+
+// Glide speed of glissando, in semitones per second
+#define SYNTH_GLIDE_RATE 220
+
+extern uint8_t  note_timbre;
+extern bool     glissando;
+extern uint16_t envelope_index;
+// Time since the note started, in 1/880 s, see synth_tick()
+extern uint16_t envelope_time;
+// Timer ticks spent on one voice before polyphony moves on, 0 disables it
+extern uint32_t polyphony_period;
+
+// A note of a song, converted from its floats before the ISRs play it
+typedef struct {
+    uint16_t pitch;
+    // calls of the ISR while the note rests
+    uint16_t ticks;
+    // timer ticks while it sounds
+    uint32_t duration;
+} synth_note_t;
+
+uint16_t synth_pitch_from_frequency(float frequency);
+// 'length' is in the unit of the songs, tempo as in set_tempo()
+void synth_note_from_song(float frequency, float length, uint8_t tempo, synth_note_t *note);
+uint16_t synth_period(uint16_t pitch);
+uint16_t synth_glide(uint16_t pitch, uint16_t target, uint16_t period);
+void synth_reset_envelope(void);
+uint16_t synth_tick(uint16_t pitch, uint16_t previous_period, uint16_t *duty);
+
+#ifdef VIBRATO_ENABLE
+void synth_set_vibrato(float rate, float strength);
+uint16_t synth_vibrato(uint16_t pitch, uint16_t period);
+#endif
+
+#endif
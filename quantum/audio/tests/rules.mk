@@ -0,0 +1,7 @@
+audio_synth_SRC := \
+	$(QUANTUM_PATH)/audio/tests/synth_tests.cpp \
+	$(QUANTUM_PATH)/audio/synth.c \
+	$(QUANTUM_PATH)/audio/voices.c \
+	$(QUANTUM_PATH)/audio/luts.c
+audio_synth_DEFS := -DF_CPU=16000000UL -DAUDIO_VOICES -DVIBRATO_ENABLE -DVIBRATO_STRENGTH_ENABLE
+audio_synth_INC := $(QUANTUM_PATH)/audio $(TMK_PATH)/common
@@ -0,0 +1,384 @@
+/* Copyright 2017
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// The fixed point synth is compared with a float copy of the per tick code
+// that the audio ISRs used before it, which is also the baseline of the
+// benchmark at the end.
+
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+extern "C" {
+#include "synth.h"
+#include "voices.h"
+#include "luts.h"
+#include "musical_notes.h"
+extern voice_type voice;
+}
+
+namespace reference {
+    uint16_t envelope_index = 0;
+    float note_timbre = TIMBRE_DEFAULT;
+    bool glissando = true;
+    float vibrato_counter = 0;
+    float vibrato_strength = .5;
+    float vibrato_rate = 0.125;
+
+    float mod(float a, int b) {
+        float r = fmod(a, b);
+        return r < 0 ? r + b : r;
+    }
+
+    float vibrato(float average_freq) {
+        float vibrated_freq = average_freq * pow(vibrato_lut[(int)vibrato_counter], vibrato_strength);
+        vibrato_counter = mod((vibrato_counter + vibrato_rate * (1.0 + 440.0/average_freq)), VIBRATO_LUT_LENGTH);
+        return vibrated_freq;
+    }
+
+    float glide(float frequency, float target) {
+        if (frequency != 0 && frequency < target && frequency < target * pow(2, -440/target/12/2)) {
+            return frequency * pow(2, 440/frequency/12/2);
+        } else if (frequency != 0 && frequency > target && frequency > target * pow(2, 440/target/12/2)) {
+            return frequency * pow(2, -440/frequency/12/2);
+        }
+        return target;
+    }
+
+    float voice_envelope(float frequency) {
+        uint16_t compensated_index = (uint16_t)((float)envelope_index * (880.0 / frequency));
+
+        switch (voice) {
+            case default_voice:
+                glissando = false;
+                note_timbre = TIMBRE_50;
+                break;
+            case something:
+                glissando = false;
+                switch (compensated_index) {
+                    case 0 ... 9: note_timbre = TIMBRE_12; break;
+                    case 10 ... 19: note_timbre = TIMBRE_25; break;
+                    case 20 ... 200: note_timbre = .125 + .125; break;
+                    default: note_timbre = .125; break;
+                }
+                break;
+            case drums:
+                glissando = false;
+                if (frequency < 80.0) {
+                } else if (frequency < 160.0) {
+                    frequency = (rand() % (int)(40)) + 60;
+                    switch (envelope_index) {
+                        case 0 ... 10: note_timbre = 0.5; break;
+                        case 11 ... 20: note_timbre = 0.5 * (21 - envelope_index) / 10; break;
+                        default: note_timbre = 0; break;
+                    }
+                } else if (frequency < 320.0) {
+                    frequency = (rand() % (int)(1000)) + 1000;
+                    switch (envelope_index) {
+                        case 0 ... 5: note_timbre = 0.5; break;
+                        case 6 ... 20: note_timbre = 0.5 * (21 - envelope_index) / 15; break;
+                        default: note_timbre = 0; break;
+                    }
+                } else if (frequency < 640.0) {
+                    frequency = (rand() % (int)(2000)) + 3000;
+                    switch (envelope_index) {
+                        case 0 ... 15: note_timbre = 0.5; break;
+                        case 16 ... 20: note_timbre = 0.5 * (21 - envelope_index) / 5; break;
+                        default: note_timbre = 0; break;
+                    }
+                } else if (frequency < 1280.0) {
+                    frequency = (rand() % (int)(2000)) + 3000;
+                    switch (envelope_index) {
+                        case 0 ... 35: note_timbre = 0.5; break;
+                        case 36 ... 50: note_timbre = 0.5 * (51 - envelope_index) / 15; break;
+                        default: note_timbre = 0; break;
+                    }
+                }
+                break;
+            case butts_fader:
+                glissando = true;
+                switch (compensated_index) {
+                    case 0 ... 9: frequency = frequency / 4; note_timbre = TIMBRE_12; break;
+                    case 10 ... 19: frequency = frequency / 2; note_timbre = TIMBRE_12; break;
+                    case 20 ... 200: note_timbre = .125 - pow(((float)compensated_index - 20) / (200 - 20), 2)*.125; break;
+                    default: note_timbre = 0; break;
+                }
+                break;
+            case duty_osc:
+                glissando = true;
+                note_timbre = (float)abs((compensated_index*10 % 3000) - 1500) * ( .25 / 1500 ) + (1 - .25) / 2;
+                break;
+            case duty_octave_down:
+                glissando = true;
+                note_timbre = (envelope_index % 2) * .125 + .375 * 2;
+                if ((envelope_index % 4) == 0)
+                    note_timbre = 0.5;
+                if ((envelope_index % 8) == 0)
+                    note_timbre = 0;
+                break;
+            case delayed_vibrato:
+                glissando = true;
+                note_timbre = TIMBRE_50;
+                switch (compensated_index) {
+                    case 0 ... 150: break;
+                    default:
+                        frequency = frequency * vibrato_lut[(int)fmod((((float)compensated_index - (150 + 1))/1000*50), VIBRATO_LUT_LENGTH)];
+                        break;
+                }
+                break;
+            default:
+                break;
+        }
+        return frequency;
+    }
+
+    // What TIMER3_COMPA_vect did for a single note
+    uint16_t tick(float frequency, uint16_t *duty) {
+        float freq = vibrato_strength > 0 ? vibrato(frequency) : frequency;
+        if (envelope_index < 65535) {
+            envelope_index++;
+        }
+        freq = voice_envelope(freq);
+        if (freq < 30.517578125) {
+            freq = 30.52;
+        }
+        *duty = (uint16_t)((((float)F_CPU) / (freq * CPU_PRESCALER)) * note_timbre);
+        return (uint16_t)(((float)F_CPU) / (freq * CPU_PRESCALER));
+    }
+}
+
+namespace {
+    double note_frequency(double note) {
+        return 440.0 * pow(2.0, (note - 69) / 12);
+    }
+
+    double expected_period(uint16_t pitch) {
+        return (double)AUDIO_TIMER_HZ / note_frequency(pitch / 256.0);
+    }
+
+    uint64_t cycles() {
+    #if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+    #else
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+    #endif
+    }
+}
+
+class Synth : public ::testing::Test {
+public:
+    Synth() {
+        set_voice(default_voice);
+        synth_set_vibrato(0.125, 0);
+        synth_reset_envelope();
+        reference::vibrato_strength = 0;
+        reference::envelope_index = 0;
+        srand(1);
+    }
+};
+
+TEST_F(Synth, PeriodsFollowTheEqualTemperedScale) {
+    for (uint16_t pitch = SYNTH_PITCH(24); pitch <= SYNTH_PITCH(108); pitch += 16) {
+        double expected = expected_period(pitch);
+        EXPECT_NEAR(synth_period(pitch), expected, expected * 0.0006 + 1) << "pitch " << pitch;
+    }
+}
+
+TEST_F(Synth, LowNotesAreClampedToTheLongestPeriod) {
+    EXPECT_EQ(synth_period(SYNTH_PITCH(12)), 0xFFFF);
+    EXPECT_EQ(synth_period(1), 0xFFFF);
+}
+
+TEST_F(Synth, FrequenciesConvertToThePitchesOfTheirNotes) {
+    // within 1/256 semitone, the rounding of the period of the frequency
+    EXPECT_NEAR(synth_pitch_from_frequency(NOTE_A4), SYNTH_PITCH(69), 1);
+    EXPECT_NEAR(synth_pitch_from_frequency(NOTE_C2), SYNTH_PITCH(36), 1);
+    EXPECT_NEAR(synth_pitch_from_frequency(NOTE_C8), SYNTH_PITCH(108), 1);
+    EXPECT_EQ(synth_pitch_from_frequency(NOTE_REST), 0);
+    for (float frequency = 32; frequency < NOTE_C8; frequency *= 1.01) {
+        double period = AUDIO_TIMER_HZ / frequency;
+        EXPECT_NEAR(synth_period(synth_pitch_from_frequency(frequency)), period, period * 0.002 + 1) << frequency << " Hz";
+    }
+}
+
+TEST_F(Synth, SongNotesConvertLikeTheISRDid) {
+    float lengths[] = {1, 4, 8, 16, 64};
+    uint8_t tempos[] = {100, 120, 255};
+    for (float length : lengths) {
+        for (uint8_t tempo : tempos) {
+            synth_note_t note;
+            synth_note_from_song(NOTE_A4, length, tempo, &note);
+            float note_length = (length / 4) * (((float)tempo) / 100);
+            EXPECT_EQ(note.pitch, synth_pitch_from_frequency(NOTE_A4));
+            EXPECT_EQ(note.duration, (uint32_t)(note_length * 0xFFFF)) << length << " at " << (int)tempo;
+            EXPECT_EQ(note.ticks, (uint16_t)note_length) << length << " at " << (int)tempo;
+        }
+    }
+    synth_note_t rest;
+    synth_note_from_song(NOTE_REST, 4, 100, &rest);
+    EXPECT_EQ(rest.pitch, 0);
+}
+
+TEST_F(Synth, GlideTakesAsLongAsTheFloatVersion) {
+    uint16_t target = SYNTH_PITCH(81);
+    uint16_t pitch = SYNTH_PITCH(69);
+    uint32_t ticks = 0;
+    uint32_t timer_ticks = 0;
+    while (pitch != target && ticks < 100000) {
+        uint16_t period = synth_period(pitch);
+        pitch = synth_glide(pitch, target, period);
+        timer_ticks += period;
+        ticks++;
+    }
+
+    float frequency = NOTE_A4;
+    float float_seconds = 0;
+    while (frequency != NOTE_A5) {
+        float_seconds += 1 / frequency;
+        frequency = reference::glide(frequency, NOTE_A5);
+    }
+
+    double seconds = (double)timer_ticks / AUDIO_TIMER_HZ;
+    EXPECT_NEAR(seconds, 12.0 / SYNTH_GLIDE_RATE, 0.05 * 12 / SYNTH_GLIDE_RATE);
+    EXPECT_NEAR(seconds, float_seconds, 0.05 * float_seconds);
+
+    // and back down
+    ticks = 0;
+    while (pitch != SYNTH_PITCH(69) && ticks < 100000) {
+        pitch = synth_glide(pitch, SYNTH_PITCH(69), synth_period(pitch));
+        ticks++;
+    }
+    EXPECT_EQ(pitch, SYNTH_PITCH(69));
+}
+
+TEST_F(Synth, VibratoSwingsLikeTheFloatVersion) {
+    synth_set_vibrato(0.125, 1.0);
+    reference::vibrato_strength = 1.0;
+    uint16_t period = synth_period(SYNTH_PITCH(69));
+    int min_offset = 0, max_offset = 0;
+    int crossings = 0, float_crossings = 0;
+    int last = 0;
+    float float_last = 1;
+
+    for (int i = 0; i < 8000; i++) {
+        int offset = (int)synth_vibrato(SYNTH_PITCH(69), period) - SYNTH_PITCH(69);
+        min_offset = std::min(min_offset, offset);
+        max_offset = std::max(max_offset, offset);
+        crossings += last <= 0 && offset > 0;
+        last = offset;
+
+        float ratio = reference::vibrato(NOTE_A4) / NOTE_A4;
+        float_crossings += float_last <= 1 && ratio > 1;
+        float_last = ratio;
+    }
+    // 1.0072 is an eighth of a semitone
+    EXPECT_EQ(max_offset, 32);
+    EXPECT_EQ(min_offset, -32);
+    EXPECT_NEAR(crossings, float_crossings, float_crossings * 0.03 + 1);
+}
+
+TEST_F(Synth, VoicesShapeTheirNotesLikeTheFloatVersion) {
+    const float frequencies[] = {NOTE_C4, NOTE_A4, NOTE_C6};
+    for (int v = 0; v < number_of_voices; v++) {
+        for (float frequency : frequencies) {
+            set_voice((voice_type)v);
+            synth_reset_envelope();
+            reference::envelope_index = 0;
+            uint16_t pitch = synth_pitch_from_frequency(frequency);
+            uint16_t period = synth_period(pitch);
+            int timbre_mismatches = 0;
+            int period_mismatches = 0;
+            const int ticks = 3000;
+
+            for (int i = 0; i < ticks; i++) {
+                uint16_t duty, float_duty;
+                period = synth_tick(pitch, period, &duty);
+                uint16_t float_period = reference::tick(frequency, &float_duty);
+                if (fabs((double)duty / period - (double)float_duty / float_period) > 1.0 / 64) {
+                    timbre_mismatches++;
+                }
+                // drums pick random pitches
+                if (v != drums && fabs(period - (double)float_period) > float_period * 0.003 + 1) {
+                    period_mismatches++;
+                }
+            }
+            EXPECT_LE(timbre_mismatches, ticks / 100) << "voice " << v << " at " << frequency << " Hz";
+            EXPECT_LE(period_mismatches, ticks / 100) << "voice " << v << " at " << frequency << " Hz";
+        }
+    }
+}
+
+// Not a pass/fail test: prints the cost of a timer tick of a held note for
+// every voice, for the float code and the fixed point one, without and with
+// vibrato.  The host has an FPU, the AVR emulates every float operation in
+// software, so the difference is a lot larger on the keyboard.
+TEST_F(Synth, Benchmark) {
+    const float notes[] = {NOTE_A4, NOTE_E5, NOTE_C4, NOTE_G5};
+    const int ticks = 200000;
+    const int ticks_per_note = 5000;
+    volatile uint32_t sink = 0;
+
+    std::cout << "cycles per tick:      float   fixed   float+vibrato   fixed+vibrato" << std::endl;
+    for (int v = 0; v < number_of_voices; v++) {
+        double result[2][2];
+        for (int vibrato = 0; vibrato < 2; vibrato++) {
+            synth_set_vibrato(0.125, vibrato ? .5 : 0);
+            reference::vibrato_strength = vibrato ? .5 : 0;
+            set_voice((voice_type)v);
+
+            uint64_t start = cycles();
+            float frequency = 0;
+            for (int i = 0; i < ticks; i++) {
+                float target = notes[(i / ticks_per_note) % 4];
+                if (i % ticks_per_note == 0) {
+                    reference::envelope_index = 0;
+                }
+                frequency = reference::glissando ? reference::glide(frequency, target) : target;
+                uint16_t duty;
+                sink += reference::tick(frequency, &duty) + duty;
+            }
+            result[vibrato][0] = (double)(cycles() - start) / ticks;
+
+            start = cycles();
+            uint16_t pitch = 0;
+            uint16_t period = 0;
+            uint16_t targets[4];
+            for (int n = 0; n < 4; n++) {
+                targets[n] = synth_pitch_from_frequency(notes[n]);
+            }
+            for (int i = 0; i < ticks; i++) {
+                uint16_t target = targets[(i / ticks_per_note) % 4];
+                if (i % ticks_per_note == 0) {
+                    synth_reset_envelope();
+                }
+                pitch = glissando ? synth_glide(pitch, target, period) : target;
+                uint16_t duty;
+                period = synth_tick(pitch, period, &duty);
+                sink += period + duty;
+            }
+            result[vibrato][1] = (double)(cycles() - start) / ticks;
+        }
+        std::cout << "voice " << v << ":" << std::fixed << std::setprecision(1)
+            << std::setw(20) << result[0][0] << std::setw(8) << result[0][1]
+            << std::setw(16) << result[1][0] << std::setw(16) << result[1][1] << std::endl;
+    }
+    (void)sink;
+}
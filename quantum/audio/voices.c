@@ -14,15 +14,11 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "voices.h"
-#include "audio.h"
+#include "synth.h"
+#include "musical_notes.h"
+#include "progmem.h"
 #include "stdlib.h"
 
-// these are imported from audio.c
-extern uint16_t envelope_index;
-extern float note_timbre;
-extern float polyphony_rate;
-extern bool glissando;
-
 voice_type voice = default_voice;
 
 void set_voice(voice_type v) {
@@ -37,45 +33,49 @@ void voice_deiterate() {
     voice = (voice - 1 + number_of_voices) % number_of_voices;
 }
 
-float voice_envelope(float frequency) {
-    // envelope_index ranges from 0 to 0xFFFF, which is preserved at 880.0 Hz
+// Pitches of the drum ranges, an octave apart from 80 Hz up
+#define DRUM_PITCH(octave) (10109 + SYNTH_PITCH(12 * (octave)))
+
+uint16_t voice_envelope(uint16_t pitch) {
+    // time since the start of the note in 1/880 s, which is what
+    // envelope_index counts at 880.0 Hz
     __attribute__ ((unused))
-    uint16_t compensated_index = (uint16_t)((float)envelope_index * (880.0 / frequency));
+    uint16_t compensated_index = envelope_time;
 
     switch (voice) {
         case default_voice:
             glissando = false;
-            note_timbre = TIMBRE_50;
-            polyphony_rate = 0;
+            note_timbre = SYNTH_TIMBRE(TIMBRE_50);
+            polyphony_period = 0;
 	        break;
 
     #ifdef AUDIO_VOICES
 
         case something:
             glissando = false;
-            polyphony_rate = 0;
+            polyphony_period = 0;
             switch (compensated_index) {
                 case 0 ... 9:
-                    note_timbre = TIMBRE_12;
+                    note_timbre = SYNTH_TIMBRE(TIMBRE_12);
                     break;
 
                 case 10 ... 19:
-                    note_timbre = TIMBRE_25;
+                    note_timbre = SYNTH_TIMBRE(TIMBRE_25);
                     break;
 
                 case 20 ... 200:
-                    note_timbre = .125 + .125;
+                    note_timbre = SYNTH_TIMBRE(.125 + .125);
                     break;
 
                 default:
-                    note_timbre = .125;
+                    note_timbre = SYNTH_TIMBRE(.125);
                     break;
             }
             break;
 
         case drums:
             glissando = false;
-            polyphony_rate = 0;
+            polyphony_period = 0;
                 // switch (compensated_index) {
                 //     case 0 ... 10:
                 //         note_timbre = 0.5;
@@ -89,67 +89,67 @@ float voice_envelope(float frequency) {
                 // }
                 // frequency = (rand() % (int)(frequency * 1.2 - frequency)) + (frequency * 0.8);
 
-            if (frequency < 80.0) {
+            if (pitch < DRUM_PITCH(0)) {
 
-            } else if (frequency < 160.0) {
+            } else if (pitch < DRUM_PITCH(1)) {
 
                 // Bass drum: 60 - 100 Hz
-                frequency = (rand() % (int)(40)) + 60;
+                pitch = (rand() % (11098 - 8834)) + 8834;
                 switch (envelope_index) {
                     case 0 ... 10:
-                        note_timbre = 0.5;
+                        note_timbre = 128;
                         break;
                     case 11 ... 20:
-                        note_timbre = 0.5 * (21 - envelope_index) / 10;
+                        note_timbre = 128 * (21 - envelope_index) / 10;
                         break;
                     default:
                         note_timbre = 0;
                         break;
                 }
 
-            } else if (frequency < 320.0) {
+            } else if (pitch < DRUM_PITCH(2)) {
 
 
                 // Snare drum: 1 - 2 KHz
-                frequency = (rand() % (int)(1000)) + 1000;
+                pitch = (rand() % (24375 - 21303)) + 21303;
                 switch (envelope_index) {
                     case 0 ... 5:
-                        note_timbre = 0.5;
+                        note_timbre = 128;
                         break;
                     case 6 ... 20:
-                        note_timbre = 0.5 * (21 - envelope_index) / 15;
+                        note_timbre = 128 * (21 - envelope_index) / 15;
                         break;
                     default:
                         note_timbre = 0;
                         break;
                 }
 
-            } else if (frequency < 640.0) {
+            } else if (pitch < DRUM_PITCH(3)) {
 
                 // Closed Hi-hat: 3 - 5 KHz
-                frequency = (rand() % (int)(2000)) + 3000;
+                pitch = (rand() % (28436 - 26172)) + 26172;
                 switch (envelope_index) {
                     case 0 ... 15:
-                        note_timbre = 0.5;
+                        note_timbre = 128;
                         break;
                     case 16 ... 20:
-                        note_timbre = 0.5 * (21 - envelope_index) / 5;
+                        note_timbre = 128 * (21 - envelope_index) / 5;
                         break;
                     default:
                         note_timbre = 0;
                         break;
                 }
 
-            } else if (frequency < 1280.0) {
+            } else if (pitch < DRUM_PITCH(4)) {
 
                 // Open Hi-hat: 3 - 5 KHz
-                frequency = (rand() % (int)(2000)) + 3000;
+                pitch = (rand() % (28436 - 26172)) + 26172;
                 switch (envelope_index) {
                     case 0 ... 35:
-                        note_timbre = 0.5;
+                        note_timbre = 128;
                         break;
                     case 36 ... 50:
-                        note_timbre = 0.5 * (51 - envelope_index) / 15;
+                        note_timbre = 128 * (51 - envelope_index) / 15;
                         break;
                     default:
                         note_timbre = 0;
@@ -160,20 +160,20 @@ float voice_envelope(float frequency) {
             break;
         case butts_fader:
             glissando = true;
-            polyphony_rate = 0;
+            polyphony_period = 0;
             switch (compensated_index) {
                 case 0 ... 9:
-                    frequency = frequency / 4;
-                    note_timbre = TIMBRE_12;
+                    pitch = pitch > SYNTH_PITCH(24) ? pitch - SYNTH_PITCH(24) : 1;
+                    note_timbre = SYNTH_TIMBRE(TIMBRE_12);
 	                break;
 
                 case 10 ... 19:
-                    frequency = frequency / 2;
-                    note_timbre = TIMBRE_12;
+                    pitch = pitch > SYNTH_PITCH(12) ? pitch - SYNTH_PITCH(12) : 1;
+                    note_timbre = SYNTH_TIMBRE(TIMBRE_12);
 	                break;
 
                 case 20 ... 200:
-                    note_timbre = .125 - pow(((float)compensated_index - 20) / (200 - 20), 2)*.125;
+                    note_timbre = 32 - (uint32_t)(compensated_index - 20) * (compensated_index - 20) * 32 / ((200 - 20) * (200 - 20));
 	                break;
 
                 default:
@@ -183,24 +183,24 @@ float voice_envelope(float frequency) {
     	    break;
 
         // case octave_crunch:
-        //     polyphony_rate = 0;
+        //     polyphony_period = 0;
         //     switch (compensated_index) {
         //         case 0 ... 9:
         //         case 20 ... 24:
         //         case 30 ... 32:
         //             frequency = frequency / 2;
-        //             note_timbre = TIMBRE_12;
+        //             note_timbre = SYNTH_TIMBRE(TIMBRE_12);
         //         break;
 
         //         case 10 ... 19:
         //         case 25 ... 29:
         //         case 33 ... 35:
         //             frequency = frequency * 2;
-        //             note_timbre = TIMBRE_12;
+        //             note_timbre = SYNTH_TIMBRE(TIMBRE_12);
 	       //          break;
 
         //         default:
-        //             note_timbre = TIMBRE_12;
+        //             note_timbre = SYNTH_TIMBRE(TIMBRE_12);
         //         	break;
         //     }
 	       //  break;
@@ -208,7 +208,7 @@ float voice_envelope(float frequency) {
         case duty_osc:
             // This slows the loop down a substantial amount, so higher notes may freeze
             glissando = true;
-            polyphony_rate = 0;
+            polyphony_period = 0;
             switch (compensated_index) {
                 default:
                     #define OCS_SPEED 10
@@ -216,36 +216,36 @@ float voice_envelope(float frequency) {
                     // sine wave is slow
                     // note_timbre = (sin((float)compensated_index/10000*OCS_SPEED) * OCS_AMP / 2) + .5;
                     // triangle wave is a bit faster
-                    note_timbre = (float)abs((compensated_index*OCS_SPEED % 3000) - 1500) * ( OCS_AMP / 1500 ) + (1 - OCS_AMP) / 2;
+                    note_timbre = abs((int16_t)((uint32_t)compensated_index * OCS_SPEED % 3000) - 1500) * SYNTH_TIMBRE(OCS_AMP) / 1500 + SYNTH_TIMBRE((1 - OCS_AMP) / 2);
                 	break;
             }
 	        break;
 
         case duty_octave_down:
             glissando = true;
-            polyphony_rate = 0;
-            note_timbre = (envelope_index % 2) * .125 + .375 * 2;
+            polyphony_period = 0;
+            note_timbre = (envelope_index % 2) * SYNTH_TIMBRE(.125) + SYNTH_TIMBRE(.375 * 2);
             if ((envelope_index % 4) == 0)
-                note_timbre = 0.5;
+                note_timbre = SYNTH_TIMBRE(0.5);
             if ((envelope_index % 8) == 0)
                 note_timbre = 0;
             break;
         case delayed_vibrato:
             glissando = true;
-            polyphony_rate = 0;
-            note_timbre = TIMBRE_50;
+            polyphony_period = 0;
+            note_timbre = SYNTH_TIMBRE(TIMBRE_50);
             #define VOICE_VIBRATO_DELAY 150
             #define VOICE_VIBRATO_SPEED 50
             switch (compensated_index) {
                 case 0 ... VOICE_VIBRATO_DELAY:
                     break;
                 default:
-                    frequency = frequency * vibrato_lut[(int)fmod((((float)compensated_index - (VOICE_VIBRATO_DELAY + 1))/1000*VOICE_VIBRATO_SPEED), VIBRATO_LUT_LENGTH)];
+                    pitch += (int8_t)pgm_read_byte(&vibrato_pitch_lut[((compensated_index - (VOICE_VIBRATO_DELAY + 1)) / (1000 / VOICE_VIBRATO_SPEED)) % VIBRATO_LUT_LENGTH]);
                     break;
             }
             break;
         // case delayed_vibrato_octave:
-        //     polyphony_rate = 0;
+        //     polyphony_period = 0;
         //     if ((envelope_index % 2) == 1) {
         //         note_timbre = 0.55;
         //     } else {
@@ -292,5 +292,5 @@ float voice_envelope(float frequency) {
    			break;
     }
 
-    return frequency;
+    return pitch;
 }
@@ -24,7 +24,7 @@
 #ifndef VOICES_H
 #define VOICES_H
 
-float voice_envelope(float frequency);
+uint16_t voice_envelope(uint16_t pitch);
 
 typedef enum {
     default_voice,
@@ -0,0 +1,55 @@
+/* Copyright 2017
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "matrix.h"
+
+// The debounce algorithm is selected with DEBOUNCE_TYPE in rules.mk, see
+// quantum/debounce/ for the available ones. All of them keep their state a
+// whole matrix row at a time, so a scan costs O(rows) rather than O(keys).
+
+/* Debounce time in milliseconds, DEBOUNCING_DELAY is the old name */
+#ifndef DEBOUNCE
+#   ifdef DEBOUNCING_DELAY
+#       define DEBOUNCE DEBOUNCING_DELAY
+#   else
+#       define DEBOUNCE 5
+#   endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* reset the debounce state, no key is considered pressed */
+void debounce_init(uint8_t num_rows);
+/* Update the debounced matrix (cooked) from the state read by the latest
+ * scan (raw). raw_changed tells whether raw differs from the previous scan.
+ * Returns true if cooked changed.
+ */
+bool debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool raw_changed);
+/* whether any change is still waiting for its debounce time */
+bool debounce_active(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,160 @@
+/* Copyright 2017
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Asymmetric, per-key debouncing: eager on press, deferred on release.
+ *
+ * A press is reported on the first scan that sees it. A release is only
+ * reported once the key has read as released for DEBOUNCE ms, and reading
+ * it as pressed again in the meantime restarts the count. So press bounce
+ * and release bounce are both absorbed by the release deferral, without
+ * adding any latency to presses.
+ *
+ * Every key has its own counter of milliseconds spent released, stored as
+ * a vertical counter: bit n of the count of every key in a row lives in
+ * counter[n][row], so a whole row is counted and compared with a handful
+ * of bitwise operations.
+ */
+
+#include "debounce.h"
+#include "timer.h"
+
+#if DEBOUNCE > 0
+
+#if DEBOUNCE < 2
+#   define DEBOUNCE_COUNTER_BITS 1
+#elif DEBOUNCE < 4
+#   define DEBOUNCE_COUNTER_BITS 2
+#elif DEBOUNCE < 8
+#   define DEBOUNCE_COUNTER_BITS 3
+#elif DEBOUNCE < 16
+#   define DEBOUNCE_COUNTER_BITS 4
+#elif DEBOUNCE < 32
+#   define DEBOUNCE_COUNTER_BITS 5
+#elif DEBOUNCE < 64
+#   define DEBOUNCE_COUNTER_BITS 6
+#elif DEBOUNCE < 128
+#   define DEBOUNCE_COUNTER_BITS 7
+#elif DEBOUNCE < 256
+#   define DEBOUNCE_COUNTER_BITS 8
+#else
+#   error "DEBOUNCE must be less than 256 ms"
+#endif
+
+static matrix_row_t counter[DEBOUNCE_COUNTER_BITS][MATRIX_ROWS];
+// keys whose release is being deferred
+static matrix_row_t releasing[MATRIX_ROWS];
+static uint8_t rows_releasing = 0;
+static uint16_t last_time;
+
+// Advance the counters of the given keys by one, and return the keys that
+// have reached DEBOUNCE.
+static matrix_row_t count_row(uint8_t row, matrix_row_t keys)
+{
+    matrix_row_t carry = keys;
+    matrix_row_t done = keys;
+
+    for (uint8_t bit = 0; bit < DEBOUNCE_COUNTER_BITS; bit++) {
+        matrix_row_t plane = counter[bit][row];
+        counter[bit][row] = plane ^ carry;
+        carry &= plane;
+        done &= (DEBOUNCE & (1 << bit)) ? counter[bit][row] : ~counter[bit][row];
+    }
+    return done;
+}
+
+#endif
+
+void debounce_init(uint8_t num_rows)
+{
+#if DEBOUNCE > 0
+    for (uint8_t i = 0; i < num_rows; i++) {
+        for (uint8_t bit = 0; bit < DEBOUNCE_COUNTER_BITS; bit++) {
+            counter[bit][i] = 0;
+        }
+        releasing[i] = 0;
+    }
+    rows_releasing = 0;
+    last_time = timer_read();
+#endif
+}
+
+bool debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool raw_changed)
+{
+    bool cooked_changed = false;
+
+#if DEBOUNCE > 0
+    uint16_t now = timer_read();
+    uint16_t elapsed = TIMER_DIFF_16(now, last_time);
+    last_time = now;
+
+    if (!raw_changed && !rows_releasing) {
+        return false;
+    }
+    if (elapsed > DEBOUNCE) {
+        elapsed = DEBOUNCE;
+    }
+
+    rows_releasing = 0;
+    for (uint8_t i = 0; i < num_rows; i++) {
+        matrix_row_t pressed = raw[i] & ~cooked[i];
+        matrix_row_t released = cooked[i] & ~raw[i];
+        // only keys that were already released at the last scan have
+        // accumulated time, the others start counting from zero
+        matrix_row_t counting = released & releasing[i];
+
+        if (pressed) {
+            cooked[i] |= pressed;
+            cooked_changed = true;
+        }
+        for (uint8_t bit = 0; bit < DEBOUNCE_COUNTER_BITS; bit++) {
+            counter[bit][i] &= counting;
+        }
+        for (uint16_t tick = 0; tick < elapsed && counting; tick++) {
+            matrix_row_t done = count_row(i, counting);
+            if (done) {
+                cooked[i] &= ~done;
+                cooked_changed = true;
+                counting &= ~done;
+                released &= ~done;
+                for (uint8_t bit = 0; bit < DEBOUNCE_COUNTER_BITS; bit++) {
+                    counter[bit][i] &= ~done;
+                }
+            }
+        }
+
+        releasing[i] = released;
+        if (released) {
+            rows_releasing++;
+        }
+    }
+#else
+    for (uint8_t i = 0; i < num_rows; i++) {
+        cooked_changed |= (cooked[i] != raw[i]);
+        cooked[i] = raw[i];
+    }
+#endif
+    return cooked_changed;
+}
+
+bool debounce_active(void)
+{
+#if DEBOUNCE > 0
+    return rows_releasing != 0;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,71 @@
+/* Copyright 2017
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Symmetric, deferred, global debouncing.
+ *
+ * Any change anywhere in the matrix restarts a single timer, and the whole
+ * matrix is reported once nothing has changed for more than DEBOUNCE ms, as
+ * the matrix code did before. Cheapest in RAM, but a bouncing key delays
+ * every other key.
+ */
+
+#include "debounce.h"
+#include "timer.h"
+
+#if DEBOUNCE > 0
+static bool debouncing = false;
+static uint16_t debouncing_time;
+#endif
+
+void debounce_init(uint8_t num_rows)
+{
+#if DEBOUNCE > 0
+    debouncing = false;
+#endif
+}
+
+bool debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool raw_changed)
+{
+    bool cooked_changed = false;
+
+#if DEBOUNCE > 0
+    if (raw_changed) {
+        debouncing = true;
+        debouncing_time = timer_read();
+        return false;
+    }
+    if (!debouncing || timer_elapsed(debouncing_time) <= DEBOUNCE) {
+        return false;
+    }
+    debouncing = false;
+#endif
+
+    for (uint8_t i = 0; i < num_rows; i++) {
+        cooked_changed |= (cooked[i] != raw[i]);
+        cooked[i] = raw[i];
+    }
+    return cooked_changed;
+}
+
+bool debounce_active(void)
+{
+#if DEBOUNCE > 0
+    return debouncing;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,88 @@
+/* Copyright 2017
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Symmetric, deferred, per-row debouncing.
+ *
+ * Like sym_defer_g, but every row has its own timer. A row is reported once
+ * it hasn't changed for DEBOUNCE ms, so a bouncing key only delays the keys
+ * sharing its row.
+ */
+
+#include "debounce.h"
+#include "timer.h"
+
+#if DEBOUNCE > 0
+static matrix_row_t raw_prev[MATRIX_ROWS];
+static uint16_t row_time[MATRIX_ROWS];
+static bool row_debouncing[MATRIX_ROWS];
+static uint8_t rows_debouncing = 0;
+#endif
+
+void debounce_init(uint8_t num_rows)
+{
+#if DEBOUNCE > 0
+    for (uint8_t i = 0; i < num_rows; i++) {
+        raw_prev[i] = 0;
+        row_debouncing[i] = false;
+    }
+    rows_debouncing = 0;
+#endif
+}
+
+bool debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool raw_changed)
+{
+    bool cooked_changed = false;
+
+#if DEBOUNCE > 0
+    if (!raw_changed && !rows_debouncing) {
+        return false;
+    }
+
+    uint16_t now = timer_read();
+    for (uint8_t i = 0; i < num_rows; i++) {
+        if (raw[i] != raw_prev[i]) {
+            // the row is still bouncing, restart its timer
+            raw_prev[i] = raw[i];
+            row_time[i] = now;
+            if (!row_debouncing[i]) {
+                row_debouncing[i] = true;
+                rows_debouncing++;
+            }
+        } else if (row_debouncing[i] && TIMER_DIFF_16(now, row_time[i]) >= DEBOUNCE) {
+            cooked_changed |= (cooked[i] != raw[i]);
+            cooked[i] = raw[i];
+            row_debouncing[i] = false;
+            rows_debouncing--;
+        }
+    }
+#else
+    for (uint8_t i = 0; i < num_rows; i++) {
+        cooked_changed |= (cooked[i] != raw[i]);
+        cooked[i] = raw[i];
+    }
+#endif
+    return cooked_changed;
+}
+
+bool debounce_active(void)
+{
+#if DEBOUNCE > 0
+    return rows_debouncing != 0;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,260 @@
+/* Copyright 2017
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// The same tests are built once for every debounce algorithm, see rules.mk.
+// Synthetic switch waveforms are fed through debounce() one scan per ms, and
+// the debounced edges are compared with the real ones.
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+extern "C" {
+#include "debounce.h"
+#include "timer.h"
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+}
+
+namespace {
+    // A level change of the raw switch signal
+    struct edge {
+        uint32_t time;
+        bool pressed;
+    };
+
+    // Press at 'press', release at 'release', with 'bounces' short pulses of
+    // 1 ms after each of them.
+    std::vector<edge> keystroke(uint32_t press, uint32_t release, uint8_t bounces) {
+        std::vector<edge> result;
+        for (uint32_t i = 0; i <= 2 * bounces; i++) {
+            result.push_back({press + i, i % 2 == 0});
+        }
+        for (uint32_t i = 0; i <= 2 * bounces; i++) {
+            result.push_back({release + i, i % 2 == 1});
+        }
+        return result;
+    }
+
+    struct result {
+        std::vector<uint32_t> press_latency;
+        std::vector<uint32_t> release_latency;
+        unsigned extra_edges = 0;
+        unsigned missed_edges = 0;
+    };
+}
+
+class Debounce : public ::testing::Test {
+public:
+    Debounce() {
+        set_time(1000);
+        std::fill(raw, raw + MATRIX_ROWS, 0);
+        std::fill(cooked, cooked + MATRIX_ROWS, 0);
+        std::fill(raw_prev, raw_prev + MATRIX_ROWS, 0);
+        debounce_init(MATRIX_ROWS);
+    }
+
+    void scan() {
+        bool changed = !std::equal(raw, raw + MATRIX_ROWS, raw_prev);
+        std::copy(raw, raw + MATRIX_ROWS, raw_prev);
+        debounce(raw, cooked, MATRIX_ROWS, changed);
+        advance_time(1);
+    }
+
+    bool is_cooked(uint8_t row, uint8_t col) {
+        return cooked[row] & ((matrix_row_t)1 << col);
+    }
+
+    // Play the waveform of a single key, scanning once per ms, and return
+    // the debounced edges.
+    std::vector<edge> play(uint8_t row, uint8_t col, const std::vector<edge>& wave, uint32_t until) {
+        std::vector<edge> result;
+        matrix_row_t bit = (matrix_row_t)1 << col;
+        size_t next = 0;
+        bool last_cooked = is_cooked(row, col);
+
+        for (uint32_t t = 0; t < until; t++) {
+            while (next < wave.size() && wave[next].time == t) {
+                if (wave[next].pressed) raw[row] |= bit; else raw[row] &= ~bit;
+                next++;
+            }
+            scan();
+            bool now = is_cooked(row, col);
+            if (now != last_cooked) {
+                result.push_back({t, now});
+                last_cooked = now;
+            }
+        }
+        return result;
+    }
+
+    // Play a keystroke and compare the debounced edges with the first raw
+    // edge of the press and of the release.
+    result play_keystroke(uint8_t row, uint8_t col, uint32_t press, uint32_t release, uint8_t bounces, uint32_t until) {
+        result r;
+        std::vector<edge> edges = play(row, col, keystroke(press, release, bounces), until);
+        bool pressed = false;
+        bool released = false;
+        for (auto& e: edges) {
+            if (e.pressed && !pressed && !released) {
+                r.press_latency.push_back(e.time - press);
+                pressed = true;
+            } else if (!e.pressed && pressed && !released && e.time >= release) {
+                r.release_latency.push_back(e.time - release);
+                released = true;
+            } else {
+                r.extra_edges++;
+            }
+        }
+        r.missed_edges = !pressed + !released;
+        return r;
+    }
+
+    matrix_row_t raw[MATRIX_ROWS];
+    matrix_row_t cooked[MATRIX_ROWS];
+    matrix_row_t raw_prev[MATRIX_ROWS];
+};
+
+TEST_F(Debounce, CleanKeystrokeIsReportedWithinTheDebounceTime) {
+    result r = play_keystroke(1, 3, 10, 60, 0, 100);
+    ASSERT_EQ(r.press_latency.size(), 1u);
+    ASSERT_EQ(r.release_latency.size(), 1u);
+    EXPECT_LE(r.press_latency[0], DEBOUNCE + 1u);
+    EXPECT_LE(r.release_latency[0], DEBOUNCE + 1u);
+    EXPECT_EQ(r.extra_edges, 0u);
+    EXPECT_EQ(r.missed_edges, 0u);
+    EXPECT_FALSE(debounce_active());
+}
+
+TEST_F(Debounce, BouncesShorterThanTheDebounceTimeAreRejected) {
+    result r = play_keystroke(2, 7, 10, 60, 2, 100);
+    EXPECT_EQ(r.press_latency.size(), 1u);
+    EXPECT_EQ(r.release_latency.size(), 1u);
+    EXPECT_EQ(r.extra_edges, 0u);
+    EXPECT_EQ(r.missed_edges, 0u);
+}
+
+TEST_F(Debounce, KeysAreDebouncedIndependently) {
+    // press two keys on different rows, release one of them
+    raw[0] = 1;
+    raw[5] = 1 << 4;
+    for (int i = 0; i < DEBOUNCE + 2; i++) scan();
+    EXPECT_EQ(cooked[0], 1u);
+    EXPECT_EQ(cooked[5], 1u << 4);
+
+    raw[0] = 0;
+    for (int i = 0; i < DEBOUNCE + 2; i++) scan();
+    EXPECT_EQ(cooked[0], 0u);
+    EXPECT_EQ(cooked[5], 1u << 4);
+}
+
+TEST_F(Debounce, DebounceIsActiveWhileAChangeIsPending) {
+    raw[3] = 1;
+    scan();
+    raw[3] = 0;
+    scan();
+    EXPECT_TRUE(debounce_active());
+    for (int i = 0; i < DEBOUNCE + 2; i++) scan();
+    EXPECT_FALSE(debounce_active());
+    EXPECT_EQ(cooked[3], 0u);
+}
+
+#ifdef DEBOUNCE_TEST_EAGER_PRESS
+TEST_F(Debounce, PressIsReportedOnTheFirstScan) {
+    result r = play_keystroke(0, 0, 10, 60, 3, 100);
+    ASSERT_EQ(r.press_latency.size(), 1u);
+    EXPECT_EQ(r.press_latency[0], 0u);
+    EXPECT_EQ(r.extra_edges, 0u);
+}
+#else
+TEST_F(Debounce, SingleScanGlitchIsRejected) {
+    std::vector<edge> glitch = {{10, true}, {11, false}};
+    EXPECT_TRUE(play(0, 0, glitch, 50).empty());
+}
+#endif
+
+#ifdef DEBOUNCE_TEST_GLOBAL
+// Like the matrix code before the debounce module, which waited for more than
+// DEBOUNCING_DELAY ms
+TEST_F(Debounce, SettlesAfterMoreThanTheDebounceTime) {
+    result r = play_keystroke(2, 5, 10, 60, 0, 100);
+    ASSERT_EQ(r.press_latency.size(), 1u);
+    ASSERT_EQ(r.release_latency.size(), 1u);
+    EXPECT_EQ(r.press_latency[0], DEBOUNCE + 1u);
+    EXPECT_EQ(r.release_latency[0], DEBOUNCE + 1u);
+}
+#endif
+
+// Not a pass/fail test: types a few hundred keystrokes with random bounce,
+// and prints the latency the algorithm adds, how much chatter gets through,
+// and what a scan of the whole matrix costs.
+TEST_F(Debounce, Benchmark) {
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> bounces(0, 2);
+    std::uniform_int_distribution<int> hold(30, 120);
+    result total;
+    unsigned keystrokes = 0;
+
+    for (int i = 0; i < 300; i++) {
+        uint32_t press = 5;
+        uint32_t release = press + hold(rng);
+        result r = play_keystroke(i % MATRIX_ROWS, i % MATRIX_COLS, press, release, bounces(rng), release + 40);
+        total.press_latency.insert(total.press_latency.end(), r.press_latency.begin(), r.press_latency.end());
+        total.release_latency.insert(total.release_latency.end(), r.release_latency.begin(), r.release_latency.end());
+        total.extra_edges += r.extra_edges;
+        total.missed_edges += r.missed_edges;
+        keystrokes++;
+    }
+
+    // glitches are single scan pulses on an idle key
+    unsigned glitches_passed = 0;
+    for (int i = 0; i < 100; i++) {
+        std::vector<edge> glitch = {{5, true}, {6, false}};
+        if (!play(i % MATRIX_ROWS, i % MATRIX_COLS, glitch, 40).empty()) {
+            glitches_passed++;
+        }
+    }
+
+    auto stats = [](const char* name, std::vector<uint32_t>& v) {
+        std::sort(v.begin(), v.end());
+        double sum = 0;
+        for (auto x: v) sum += x;
+        std::cout << name << " latency ms: mean " << (v.empty() ? 0 : sum / v.size())
+            << ", max " << (v.empty() ? 0 : v.back()) << std::endl;
+    };
+    std::cout << "DEBOUNCE " << DEBOUNCE << " ms, " << keystrokes << " keystrokes" << std::endl;
+    stats("press", total.press_latency);
+    stats("release", total.release_latency);
+    std::cout << "chatter edges: " << total.extra_edges << ", missed edges: " << total.missed_edges << std::endl;
+    std::cout << "single scan glitches reported: " << glitches_passed << " of 100" << std::endl;
+
+    // cost of a scan while every key is pressed and bouncing
+    const unsigned scans = 100000;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < scans; i++) {
+        std::fill(raw, raw + MATRIX_ROWS, (i & 1) ? (matrix_row_t)~0 : 0);
+        debounce(raw, cooked, MATRIX_ROWS, true);
+        if ((i & 7) == 0) advance_time(1);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / scans;
+    std::cout << MATRIX_ROWS << "x" << MATRIX_COLS << " matrix: " << ns << " ns per scan on the host" << std::endl;
+
+    EXPECT_EQ(total.extra_edges, 0u);
+    EXPECT_EQ(total.missed_edges, 0u);
+}
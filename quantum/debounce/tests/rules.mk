@@ -0,0 +1,24 @@
+DEBOUNCE_TEST_PATH := $(QUANTUM_PATH)/debounce
+DEBOUNCE_TEST_DEFS := -DMATRIX_ROWS=8 -DMATRIX_COLS=16 -DDEBOUNCE=5
+DEBOUNCE_TEST_INC := $(TMK_PATH)/common
+
+debounce_sym_defer_g_SRC := \
+	$(DEBOUNCE_TEST_PATH)/tests/debounce_tests.cpp \
+	$(DEBOUNCE_TEST_PATH)/sym_defer_g.c \
+	$(TMK_PATH)/common/test/timer.c
+debounce_sym_defer_g_DEFS := $(DEBOUNCE_TEST_DEFS) -DDEBOUNCE_TEST_GLOBAL
+debounce_sym_defer_g_INC := $(DEBOUNCE_TEST_INC)
+
+debounce_sym_defer_pr_SRC := \
+	$(DEBOUNCE_TEST_PATH)/tests/debounce_tests.cpp \
+	$(DEBOUNCE_TEST_PATH)/sym_defer_pr.c \
+	$(TMK_PATH)/common/test/timer.c
+debounce_sym_defer_pr_DEFS := $(DEBOUNCE_TEST_DEFS)
+debounce_sym_defer_pr_INC := $(DEBOUNCE_TEST_INC)
+
+debounce_asym_eager_defer_pk_SRC := \
+	$(DEBOUNCE_TEST_PATH)/tests/debounce_tests.cpp \
+	$(DEBOUNCE_TEST_PATH)/asym_eager_defer_pk.c \
+	$(TMK_PATH)/common/test/timer.c
+debounce_asym_eager_defer_pk_DEFS := $(DEBOUNCE_TEST_DEFS) -DDEBOUNCE_TEST_EAGER_PRESS
+debounce_asym_eager_defer_pk_INC := $(DEBOUNCE_TEST_INC)
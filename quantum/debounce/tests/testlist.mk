@@ -0,0 +1,4 @@
+TEST_LIST +=\
+	debounce_sym_defer_g\
+	debounce_sym_defer_pr\
+	debounce_asym_eager_defer_pk
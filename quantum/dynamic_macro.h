@@ -106,7 +106,7 @@ void dynamic_macro_play(
 
     clear_keyboard();
 
-    layer_state = saved_layer_state;
+    layer_state_set(saved_layer_state);
 }
 
 /**
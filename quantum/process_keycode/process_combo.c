@@ -16,16 +16,13 @@
 
 #include "process_combo.h"
 #include "print.h"
+#include "debug.h"
+#include "timeout.h"
 
 
-#define COMBO_TIMER_ELAPSED -1
+#define COMBO_TIMER_ELAPSED ((uint16_t)-1)
 
 
-__attribute__ ((weak))
-combo_t key_combos[] = {
-
-};
-
 __attribute__ ((weak))
 void process_combo_event(uint8_t combo_index, bool pressed) {
 
@@ -33,6 +30,9 @@ void process_combo_event(uint8_t combo_index, bool pressed) {
 
 static uint8_t current_combo_index = 0;
 
+/* Runs matrix_scan_combo() when the first of the combo timers runs out */
+static timeout_t combo_timeout;
+
 static inline void send_combo(uint16_t action, bool pressed)
 {
     if (action) {
@@ -46,24 +46,75 @@ static inline void send_combo(uint16_t action, bool pressed)
     }
 }
 
-#define ALL_COMBO_KEYS_ARE_DOWN     (((1<<count)-1) == combo->state)
+/*
+ * Index from keycode to the combos containing it, sorted by keycode and
+ * then by combo. The keycode itself isn't stored, it's read from the key
+ * list of the combo.
+ */
+typedef struct {
+    uint8_t combo;
+    uint8_t key;
+} combo_index_entry_t;
+
+static combo_index_entry_t combo_index[COMBO_INDEX_SIZE];
+static uint16_t combo_index_size = 0;
+static enum { INDEX_NONE, INDEX_BUILT, INDEX_OVERFLOW } combo_index_state = INDEX_NONE;
+
+static inline uint16_t combo_key(uint8_t combo, uint8_t key)
+{
+    return pgm_read_word(&key_combos[combo].keys[key]);
+}
+
+static inline uint16_t combo_index_keycode(uint16_t i)
+{
+    return combo_key(combo_index[i].combo, combo_index[i].key);
+}
+
+void combo_index_rebuild(void)
+{
+    combo_index_size = 0;
+    combo_index_state = INDEX_BUILT;
+
+    for (uint8_t c = 0; c < COMBO_COUNT; c++) {
+        uint8_t count = 0;
+        while (combo_key(c, count) != COMBO_END) {
+            count++;
+        }
+        key_combos[c].count = count;
+
+        for (uint8_t k = 0; k < count; k++) {
+            uint16_t keycode = combo_key(c, k);
+            /* insertion sort, entries of the same keycode stay in combo order */
+            uint16_t i = combo_index_size;
+            while (i > 0 && combo_index_keycode(i - 1) > keycode) {
+                i--;
+            }
+            if (i > 0 && combo_index[i - 1].combo == c && combo_index_keycode(i - 1) == keycode) {
+                /* the same key twice in a combo, the last one counts */
+                combo_index[i - 1].key = k;
+                continue;
+            }
+            if (combo_index_size >= COMBO_INDEX_SIZE) {
+                dprintf("combo: index full, increase COMBO_INDEX_SIZE\n");
+                combo_index_state = INDEX_OVERFLOW;
+                continue;
+            }
+            for (uint16_t j = combo_index_size; j > i; j--) {
+                combo_index[j] = combo_index[j - 1];
+            }
+            combo_index[i].combo = c;
+            combo_index[i].key = k;
+            combo_index_size++;
+        }
+    }
+}
+
+#define ALL_COMBO_KEYS_ARE_DOWN     ((((uint32_t)1<<combo->count)-1) == combo->state)
 #define NO_COMBO_KEYS_ARE_DOWN      (0 == combo->state)
 #define KEY_STATE_DOWN(key)         do{ combo->state |= (1<<key); } while(0)
 #define KEY_STATE_UP(key)           do{ combo->state &= ~(1<<key); } while(0)
-static bool process_single_combo(combo_t *combo, uint16_t keycode, keyrecord_t *record) 
+static bool process_single_combo(combo_t *combo, uint8_t index, uint16_t keycode, keyrecord_t *record)
 {
-    uint8_t count = 0;
-    uint8_t index = -1;
-    /* Find index of keycode and number of combo keys */
-    for (const uint16_t *keys = combo->keys; ;++count) {
-        uint16_t key = pgm_read_word(&keys[count]);
-        if (keycode == key) index = count;
-        if (COMBO_END == key) break;
-    }
-
-    /* Return if not a combo key */
-    if (-1 == (int8_t)index) return false;
-
     /* The combos timer is used to signal whether the combo is active */
     bool is_combo_active = COMBO_TIMER_ELAPSED == combo->timer ? false : true;
 
@@ -76,6 +127,9 @@ static bool process_single_combo(combo_t *combo, uint16_t keycode, keyrecord_t *
                 combo->timer = COMBO_TIMER_ELAPSED;
             } else { /* Combo key was pressed */
                 combo->timer = timer_read();
+                if (!timeout_pending(&combo_timeout)) {
+                    timeout_start(&combo_timeout, COMBO_TERM + 1, matrix_scan_combo);
+                }
 #ifdef COMBO_ALLOW_ACTION_KEYS
                 combo->prev_record = *record;
 #else
@@ -112,26 +166,66 @@ static bool process_single_combo(combo_t *combo, uint16_t keycode, keyrecord_t *
     return is_combo_active;
 }
 
-bool process_combo(uint16_t keycode, keyrecord_t *record)
+/* Without the index every combo is searched for the keycode */
+static bool process_combo_linear(uint16_t keycode, keyrecord_t *record)
 {
     bool is_combo_key = false;
 
     for (current_combo_index = 0; current_combo_index < COMBO_COUNT; ++current_combo_index) {
         combo_t *combo = &key_combos[current_combo_index];
-        is_combo_key |= process_single_combo(combo, keycode, record);
-    }    
+        uint8_t index = -1;
+        /* Find index of keycode */
+        for (uint8_t k = 0; k < combo->count; k++) {
+            if (keycode == combo_key(current_combo_index, k)) index = k;
+        }
+
+        /* Skip if not a combo key */
+        if (-1 == (int8_t)index) continue;
+
+        is_combo_key |= process_single_combo(combo, index, keycode, record);
+    }
+
+    return !is_combo_key;
+}
+
+bool process_combo(uint16_t keycode, keyrecord_t *record)
+{
+    bool is_combo_key = false;
+    uint16_t first = 0;
+    uint16_t last = combo_index_size;
+
+    if (combo_index_state == INDEX_NONE) {
+        combo_index_rebuild();
+    }
+    if (combo_index_state == INDEX_OVERFLOW) {
+        return process_combo_linear(keycode, record);
+    }
+
+    /* first entry of the keycode */
+    while (first < last) {
+        uint16_t middle = first + (last - first) / 2;
+        if (combo_index_keycode(middle) < keycode) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+
+    for (uint16_t i = first; i < combo_index_size && combo_index_keycode(i) == keycode; i++) {
+        current_combo_index = combo_index[i].combo;
+        is_combo_key |= process_single_combo(&key_combos[current_combo_index], combo_index[i].key, keycode, record);
+    }
 
     return !is_combo_key;
 }
 
 void matrix_scan_combo(void)
 {
+    uint16_t longest = 0;
+    bool running = false;
+
     for (int i = 0; i < COMBO_COUNT; ++i) {
-        // Do not treat the (weak) key_combos too strict.
-        #pragma GCC diagnostic push
-        #pragma GCC diagnostic ignored "-Warray-bounds"
         combo_t *combo = &key_combos[i];
-        #pragma GCC diagnostic pop
         if (combo->timer &&
             combo->timer != COMBO_TIMER_ELAPSED && 
             timer_elapsed(combo->timer) > COMBO_TERM) {
@@ -149,6 +243,18 @@ void matrix_scan_combo(void)
             unregister_code16(combo->prev_key);
             register_code16(combo->prev_key);
 #endif
+        } else if (combo->timer && combo->timer != COMBO_TIMER_ELAPSED) {
+            uint16_t elapsed = timer_elapsed(combo->timer);
+            if (!running || elapsed > longest) {
+                longest = elapsed;
+            }
+            running = true;
         }
     }
+
+    if (running) {
+        timeout_start(&combo_timeout, COMBO_TERM + 1 - longest, matrix_scan_combo);
+    } else {
+        timeout_cancel(&combo_timeout);
+    }
 }
@@ -33,6 +33,7 @@ typedef struct
     uint8_t state;
 #endif
     uint16_t timer;
+    uint8_t count;          // number of keys, filled in when the index is built
 #ifdef COMBO_ALLOW_ACTION_KEYS
     keyrecord_t prev_record;
 #else
@@ -51,8 +52,18 @@ typedef struct
 #ifndef COMBO_TERM
 #define COMBO_TERM TAPPING_TERM
 #endif
+/* Entries of the keycode to combo index, one per key of each combo. Combos
+ * are scanned one by one instead if they don't fit. */
+#ifndef COMBO_INDEX_SIZE
+#define COMBO_INDEX_SIZE (COMBO_COUNT * 3)
+#endif
+
+/* Defined by the keymap, COMBO_COUNT entries */
+extern combo_t key_combos[];
 
 bool process_combo(uint16_t keycode, keyrecord_t *record);
+/* Build the index again, needed if key_combos[] is changed at runtime */
+void combo_index_rebuild(void);
 void matrix_scan_combo(void);
 void process_combo_event(uint8_t combo_index, bool pressed);
 
@@ -17,6 +17,7 @@
 #ifndef DISABLE_LEADER
 
 #include "process_leader.h"
+#include "timeout.h"
 
 __attribute__ ((weak))
 void leader_start(void) {}
@@ -31,6 +32,91 @@ uint16_t leader_time = 0;
 uint16_t leader_sequence[5] = {0, 0, 0, 0, 0};
 uint8_t leader_sequence_size = 0;
 
+#ifdef LEADER_COUNT
+
+__attribute__ ((weak))
+void process_leader_event(uint16_t index) {}
+
+/* runs matrix_scan_leader() once LEADER_TIMEOUT has passed */
+static timeout_t leader_timeout;
+
+#if defined(__AVR__)
+#  define leader_keys(i) ((const uint16_t *)pgm_read_word(&leader_sequences[i].keys))
+#else
+#  define leader_keys(i) (leader_sequences[i].keys)
+#endif
+
+/* The sequences starting with the keys typed so far are
+ * leader_sequences[leader_first] to leader_sequences[leader_last - 1],
+ * since the table is sorted. Each key narrows them down. */
+static uint16_t leader_first;
+static uint16_t leader_last;
+static uint16_t leader_depth;
+
+static inline uint16_t leader_key(uint16_t index, uint16_t depth) {
+  return pgm_read_word(&leader_keys(index)[depth]);
+}
+
+/* First sequence with a key at leader_depth greater or equal to keycode,
+ * or only greater with 'after' */
+static uint16_t leader_search(uint16_t first, uint16_t last, uint16_t keycode, bool after) {
+  while (first < last) {
+    uint16_t middle = first + (last - first) / 2;
+    uint16_t key = leader_key(middle, leader_depth);
+    if (key < keycode || (after && key == keycode)) {
+      first = middle + 1;
+    } else {
+      last = middle;
+    }
+  }
+  return first;
+}
+
+static bool leader_complete(void) {
+  return leader_depth > 0 && leader_first < leader_last &&
+    leader_key(leader_first, leader_depth) == LEADER_END;
+}
+
+static void leader_finish(bool fire) {
+  leading = false;
+  timeout_cancel(&leader_timeout);
+  leader_end();
+  if (fire) {
+    uint16_t keycode = pgm_read_word(&leader_sequences[leader_first].keycode);
+    if (keycode) {
+      register_code16(keycode);
+      unregister_code16(keycode);
+    } else {
+      process_leader_event(leader_first);
+    }
+  }
+}
+
+static void leader_advance(uint16_t keycode) {
+  /* KC_NO would match the LEADER_END of the sequences that are complete, and
+   * send the search past their end */
+  if (keycode == KC_NO) {
+    return;
+  }
+  if (leader_key(leader_last - 1, leader_depth) == LEADER_END) {
+    /* all the sequences left end here, so none continues with this key */
+    leader_finish(false);
+    return;
+  }
+  leader_first = leader_search(leader_first, leader_last, keycode, false);
+  leader_last = leader_search(leader_first, leader_last, keycode, true);
+  leader_depth++;
+
+  if (leader_first == leader_last) {
+    /* no sequence starts like this */
+    leader_finish(false);
+  } else if (leader_last - leader_first == 1 && leader_complete()) {
+    leader_finish(true);
+  }
+}
+
+#endif
+
 bool process_leader(uint16_t keycode, keyrecord_t *record) {
   // Leader key set-up
   if (record->event.pressed) {
@@ -44,15 +130,40 @@ bool process_leader(uint16_t keycode, keyrecord_t *record) {
       leader_sequence[2] = 0;
       leader_sequence[3] = 0;
       leader_sequence[4] = 0;
+#ifdef LEADER_COUNT
+      leader_first = 0;
+      leader_last = LEADER_COUNT;
+      leader_depth = 0;
+      timeout_start(&leader_timeout, LEADER_TIMEOUT + 1, matrix_scan_leader);
+#endif
       return false;
     }
     if (leading && timer_elapsed(leader_time) < LEADER_TIMEOUT) {
-      leader_sequence[leader_sequence_size] = keycode;
-      leader_sequence_size++;
+      if (leader_sequence_size < sizeof(leader_sequence) / sizeof(leader_sequence[0])) {
+        leader_sequence[leader_sequence_size] = keycode;
+        leader_sequence_size++;
+      }
+#ifdef LEADER_PER_KEY_TIMING
+      leader_time = timer_read();
+#ifdef LEADER_COUNT
+      timeout_start(&leader_timeout, LEADER_TIMEOUT + 1, matrix_scan_leader);
+#endif
+#endif
+#ifdef LEADER_COUNT
+      leader_advance(keycode);
+#endif
       return false;
     }
   }
   return true;
 }
 
+void matrix_scan_leader(void) {
+#ifdef LEADER_COUNT
+  if (leading && timer_elapsed(leader_time) > LEADER_TIMEOUT) {
+    leader_finish(leader_complete());
+  }
+#endif
+}
+
 #endif
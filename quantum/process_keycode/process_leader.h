@@ -36,4 +36,34 @@ void leader_end(void);
 #define LEADER_EXTERNS() extern bool leading; extern uint16_t leader_time; extern uint16_t leader_sequence[5]; extern uint8_t leader_sequence_size
 #define LEADER_DICTIONARY() if (leading && timer_elapsed(leader_time) > LEADER_TIMEOUT)
 
+/*
+ * Instead of LEADER_DICTIONARY(), the sequences can be listed in a table,
+ * with LEADER_COUNT defined to the number of entries:
+ *
+ *   const uint16_t PROGMEM leader_gg[] = {KC_G, KC_G, LEADER_END};
+ *   const leader_t PROGMEM leader_sequences[] = {
+ *     LEADER_SEQ(leader_gg, KC_HOME),
+ *   };
+ *
+ * The table must be sorted by keycode, key by key, with a sequence before
+ * the longer ones it is the start of. A sequence fires as soon as no other
+ * one starts with it, otherwise when LEADER_TIMEOUT runs out.
+ */
+typedef struct {
+  const uint16_t *keys;
+  uint16_t keycode;
+} leader_t;
+
+#define LEADER_END 0
+#define LEADER_SEQ(seq, kc)     {.keys = &(seq)[0], .keycode = (kc)}
+#define LEADER_SEQ_ACTION(seq)  {.keys = &(seq)[0]}
+
+#ifdef LEADER_COUNT
+extern const leader_t leader_sequences[];
+#endif
+
+void matrix_scan_leader(void);
+/* Called for the sequences added with LEADER_SEQ_ACTION() */
+void process_leader_event(uint16_t index);
+
 #endif
@@ -15,11 +15,52 @@
  */
 #include "quantum.h"
 #include "action_tapping.h"
+#include <string.h>
+#include "timeout.h"
 
 uint8_t get_oneshot_mods(void);
 
 static uint16_t last_td;
-static int8_t highest_td = -1;
+
+/* The dances with a count, earliest deadline first, so a scan only looks at
+ * the head while nothing is due. Held dances stay after their deadline until
+ * they are released and reset. */
+static uint8_t active_td[TAP_DANCE_MAX_ACTIVE];
+static uint16_t active_deadline[TAP_DANCE_MAX_ACTIVE];
+static uint8_t active_count = 0;
+
+/* runs matrix_scan_tap_dance() at the first deadline that can finish a dance */
+static timeout_t tap_dance_timeout;
+
+static uint16_t tap_dance_term(qk_tap_dance_action_t *action) {
+  return action->custom_tapping_term > 0 ? action->custom_tapping_term : TAPPING_TERM;
+}
+
+static void active_remove(uint8_t idx) {
+  for (uint8_t i = 0; i < active_count; i++) {
+    if (active_td[i] == idx) {
+      active_count--;
+      for (; i < active_count; i++) {
+        active_td[i] = active_td[i + 1];
+        active_deadline[i] = active_deadline[i + 1];
+      }
+      return;
+    }
+  }
+}
+
+static void active_insert(uint8_t idx, uint16_t deadline) {
+  uint8_t i = active_count;
+
+  while (i > 0 && (int16_t)(active_deadline[i - 1] - deadline) > 0) {
+    active_td[i] = active_td[i - 1];
+    active_deadline[i] = active_deadline[i - 1];
+    i--;
+  }
+  active_td[i] = idx;
+  active_deadline[i] = deadline;
+  active_count++;
+}
 
 void qk_tap_dance_pair_finished (qk_tap_dance_state_t *state, void *user_data) {
   qk_tap_dance_pair_t *pair = (qk_tap_dance_pair_t *)user_data;
@@ -90,6 +131,21 @@ static inline void process_tap_dance_action_on_reset (qk_tap_dance_action_t *act
   send_keyboard_report();
 }
 
+/* Held dances past their deadline wait for their release, which schedules
+ * them again */
+static void tap_dance_schedule(void) {
+  uint16_t now = timer_read();
+
+  for (uint8_t i = 0; i < active_count; i++) {
+    int16_t left = active_deadline[i] - now;
+    if (left < 0 && tap_dance_actions[active_td[i]].state.pressed)
+      continue;
+    timeout_start(&tap_dance_timeout, left > 0 ? left + 1 : 1, matrix_scan_tap_dance);
+    return;
+  }
+  timeout_cancel(&tap_dance_timeout);
+}
+
 bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
   uint16_t idx = keycode - QK_TAP_DANCE;
   qk_tap_dance_action_t *action;
@@ -100,8 +156,6 @@ bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
 
   switch(keycode) {
   case QK_TAP_DANCE ... QK_TAP_DANCE_MAX:
-    if ((int16_t)idx > highest_td)
-      highest_td = idx;
     action = &tap_dance_actions[idx];
 
     action->state.pressed = record->event.pressed;
@@ -110,6 +164,19 @@ bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
       action->state.count++;
       action->state.timer = timer_read();
       action->state.oneshot_mods = get_oneshot_mods();
+
+      // every tap moves the deadline
+      active_remove(idx);
+      if (active_count == TAP_DANCE_MAX_ACTIVE) {
+        // interrupt the dance that is due first
+        qk_tap_dance_action_t *oldest = &tap_dance_actions[active_td[0]];
+        oldest->state.interrupted = true;
+        process_tap_dance_action_on_dance_finished (oldest);
+        oldest->state.pressed = false;
+        reset_tap_dance (&oldest->state);
+      }
+      active_insert(idx, action->state.timer + tap_dance_term(action));
+
       process_tap_dance_action_on_each_tap (action);
 
       if (last_td && last_td != keycode) {
@@ -128,11 +195,15 @@ bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
     if (!record->event.pressed)
       return true;
 
-    if (highest_td == -1)
+    if (active_count == 0)
       return true;
 
-    for (int i = 0; i <= highest_td; i++) {
-      action = &tap_dance_actions[i];
+    // resetting removes the dances from the set
+    uint8_t interrupted[TAP_DANCE_MAX_ACTIVE];
+    uint8_t count = active_count;
+    memcpy(interrupted, active_td, count);
+    for (uint8_t i = 0; i < count; i++) {
+      action = &tap_dance_actions[interrupted[i]];
       if (action->state.count == 0)
         continue;
       action->state.interrupted = true;
@@ -142,29 +213,31 @@ bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
     break;
   }
 
+  tap_dance_schedule();
   return true;
 }
 
 
 
 void matrix_scan_tap_dance () {
-  if (highest_td == -1)
+  if (active_count == 0)
     return;
-  uint16_t tap_user_defined;
-
-for (uint8_t i = 0; i <= highest_td; i++) {
-    qk_tap_dance_action_t *action = &tap_dance_actions[i];
-    if(action->custom_tapping_term > 0 ) {
-      tap_user_defined = action->custom_tapping_term;
-    }
-    else{
-      tap_user_defined = TAPPING_TERM;
-    }
-    if (action->state.count && timer_elapsed (action->state.timer) > tap_user_defined) {
-      process_tap_dance_action_on_dance_finished (action);
-      reset_tap_dance (&action->state);
+  uint16_t now = timer_read();
+
+  // the dances past their deadline, the held ones among them are skipped
+  // until they are released
+  for (uint8_t i = 0; i < active_count && (int16_t)(now - active_deadline[i]) > 0; ) {
+    qk_tap_dance_action_t *action = &tap_dance_actions[active_td[i]];
+    if (action->state.count == 0) {
+      active_remove(active_td[i]);
+      continue;
     }
+    process_tap_dance_action_on_dance_finished (action);
+    reset_tap_dance (&action->state);
+    if (action->state.count)
+      i++;
   }
+  tap_dance_schedule();
 }
 
 void reset_tap_dance (qk_tap_dance_state_t *state) {
@@ -177,6 +250,7 @@ void reset_tap_dance (qk_tap_dance_state_t *state) {
 
   process_tap_dance_action_on_reset (action);
 
+  active_remove(state->keycode - QK_TAP_DANCE);
   state->count = 0;
   state->interrupted = false;
   state->finished = false;
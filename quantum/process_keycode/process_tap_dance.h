@@ -21,6 +21,12 @@
 #include <stdbool.h>
 #include <inttypes.h>
 
+/* dances that can have a count at the same time, a tap of another one
+ * interrupts the one that is due first */
+#ifndef TAP_DANCE_MAX_ACTIVE
+#define TAP_DANCE_MAX_ACTIVE 8
+#endif
+
 typedef struct
 {
   uint8_t count;
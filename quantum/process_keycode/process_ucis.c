@@ -56,7 +56,7 @@ void qk_ucis_symbol_fallback (void) {
     uint8_t code = qk_ucis_state.codes[i];
     register_code(code);
     unregister_code(code);
-    wait_ms(UNICODE_TYPE_DELAY);
+    send_queue_wait(UNICODE_TYPE_DELAY);
   }
 }
 
@@ -83,7 +83,7 @@ void register_ucis(const char *hex) {
     if (kc) {
       register_code (kc);
       unregister_code (kc);
-      wait_ms (UNICODE_TYPE_DELAY);
+      send_queue_wait(UNICODE_TYPE_DELAY);
     }
   }
 }
@@ -121,7 +121,7 @@ bool process_ucis (uint16_t keycode, keyrecord_t *record) {
     for (i = qk_ucis_state.count; i > 0; i--) {
       register_code (KC_BSPC);
       unregister_code (KC_BSPC);
-      wait_ms(UNICODE_TYPE_DELAY);
+      send_queue_wait(UNICODE_TYPE_DELAY);
     }
 
     if (keycode == KC_ESC) {
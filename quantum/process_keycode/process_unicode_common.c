@@ -18,7 +18,6 @@
 #include "eeprom.h"
 
 static uint8_t input_mode;
-uint8_t mods;
 
 void set_unicode_input_mode(uint8_t os_target)
 {
@@ -32,18 +31,9 @@ uint8_t get_unicode_input_mode(void) {
 
 __attribute__((weak))
 void unicode_input_start (void) {
-  // save current mods
-  mods = keyboard_report->mods;
-
-  // unregister all mods to start from clean state
-  if (mods & MOD_BIT(KC_LSFT)) unregister_code(KC_LSFT);
-  if (mods & MOD_BIT(KC_RSFT)) unregister_code(KC_RSFT);
-  if (mods & MOD_BIT(KC_LCTL)) unregister_code(KC_LCTL);
-  if (mods & MOD_BIT(KC_RCTL)) unregister_code(KC_RCTL);
-  if (mods & MOD_BIT(KC_LALT)) unregister_code(KC_LALT);
-  if (mods & MOD_BIT(KC_RALT)) unregister_code(KC_RALT);
-  if (mods & MOD_BIT(KC_LGUI)) unregister_code(KC_LGUI);
-  if (mods & MOD_BIT(KC_RGUI)) unregister_code(KC_RGUI);
+  // save current mods and unregister them to start from clean state, after
+  // the characters that are still being typed
+  send_queue_step(SEND_QUEUE_SAVE_MODS, 0);
 
   switch(input_mode) {
   case UC_OSX:
@@ -71,7 +61,7 @@ void unicode_input_start (void) {
     register_code(KC_U);
     unregister_code(KC_U);
   }
-  wait_ms(UNICODE_TYPE_DELAY);
+  send_queue_wait(UNICODE_TYPE_DELAY);
 }
 
 __attribute__((weak))
@@ -91,14 +81,7 @@ void unicode_input_finish (void) {
   }
 
   // reregister previously set mods
-  if (mods & MOD_BIT(KC_LSFT)) register_code(KC_LSFT);
-  if (mods & MOD_BIT(KC_RSFT)) register_code(KC_RSFT);
-  if (mods & MOD_BIT(KC_LCTL)) register_code(KC_LCTL);
-  if (mods & MOD_BIT(KC_RCTL)) register_code(KC_RCTL);
-  if (mods & MOD_BIT(KC_LALT)) register_code(KC_LALT);
-  if (mods & MOD_BIT(KC_RALT)) register_code(KC_RALT);
-  if (mods & MOD_BIT(KC_LGUI)) register_code(KC_LGUI);
-  if (mods & MOD_BIT(KC_RGUI)) register_code(KC_RGUI);
+  send_queue_step(SEND_QUEUE_RESTORE_MODS, 0);
 }
 
 __attribute__((weak))
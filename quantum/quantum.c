@@ -18,6 +18,7 @@
 #ifdef PROTOCOL_LUFA
 #include "outputselect.h"
 #endif
+#include "latency_trace.h"
 
 #ifndef TAPPING_TERM
 #define TAPPING_TERM 200
@@ -82,23 +83,19 @@ static void do_code16 (uint16_t code, void (*f) (uint8_t)) {
 }
 
 static inline void qk_register_weak_mods(uint8_t kc) {
-    add_weak_mods(MOD_BIT(kc));
-    send_keyboard_report();
+    register_weak_mods(MOD_BIT(kc));
 }
 
 static inline void qk_unregister_weak_mods(uint8_t kc) {
-    del_weak_mods(MOD_BIT(kc));
-    send_keyboard_report();
+    unregister_weak_mods(MOD_BIT(kc));
 }
 
 static inline void qk_register_mods(uint8_t kc) {
-    add_weak_mods(MOD_BIT(kc));
-    send_keyboard_report();
+    register_weak_mods(MOD_BIT(kc));
 }
 
 static inline void qk_unregister_mods(uint8_t kc) {
-    del_weak_mods(MOD_BIT(kc));
-    send_keyboard_report();
+    unregister_weak_mods(MOD_BIT(kc));
 }
 
 void register_code16 (uint16_t code) {
@@ -136,6 +133,7 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
 
 void reset_keyboard(void) {
   clear_keyboard();
+  host_keyboard_flush();
 #if defined(MIDI_ENABLE) && defined(MIDI_BASIC)
   process_midi_all_notes_off();
 #endif  
@@ -181,6 +179,8 @@ static bool grave_esc_was_shifted = false;
 
 bool process_record_quantum(keyrecord_t *record) {
 
+  latency_trace_process_record(record->event.time);
+
   /* This gets the keycode from the key pressed */
   keypos_t key = record->event.key;
   uint16_t keycode;
@@ -712,8 +712,8 @@ void send_string_with_delay(const char *str, uint8_t interval) {
           send_char(ascii_code);
         }
         ++str;
-        // interval
-        { uint8_t ms = interval; while (ms--) wait_ms(1); }
+        // interval, typed from keyboard_task()
+        send_queue_wait(interval);
     }
 }
 
@@ -738,8 +738,8 @@ void send_string_with_delay_P(const char *str, uint8_t interval) {
           send_char(ascii_code);
         }
         ++str;
-        // interval
-        { uint8_t ms = interval; while (ms--) wait_ms(1); }
+        // interval, typed from keyboard_task()
+        send_queue_wait(interval);
     }
 }
 
@@ -823,17 +823,10 @@ void matrix_init_quantum() {
 
 void matrix_scan_quantum() {
   #ifdef AUDIO_ENABLE
+    audio_task();
     matrix_scan_music();
   #endif
 
-  #ifdef TAP_DANCE_ENABLE
-    matrix_scan_tap_dance();
-  #endif
-
-  #ifdef COMBO_ENABLE
-    matrix_scan_combo();
-  #endif
-
   #if defined(BACKLIGHT_ENABLE) && defined(BACKLIGHT_PIN)
     backlight_task();
   #endif
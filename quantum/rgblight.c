@@ -14,6 +14,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <math.h>
+#include <string.h>
 #include <avr/eeprom.h>
 #include <avr/interrupt.h>
 #include <util/delay.h>
@@ -43,7 +44,9 @@ LED_TYPE led[RGBLED_NUM];
 uint8_t rgblight_inited = 0;
 bool rgblight_timer_enabled = false;
 
-void sethsv(uint16_t hue, uint8_t sat, uint8_t val, LED_TYPE *led1) {
+// 'sector' is the position on the hue wheel in 1/256 of its 6 sectors: the
+// high byte is the sector and the low byte the position within it
+static void sethsv_sector(uint16_t sector, uint8_t sat, uint8_t val, LED_TYPE *led1) {
   uint8_t r = 0, g = 0, b = 0, base, color;
 
   #ifdef RGBLIGHT_LIMIT_VAL
@@ -58,9 +61,9 @@ void sethsv(uint16_t hue, uint8_t sat, uint8_t val, LED_TYPE *led1) {
     b = val;
   } else {
     base = ((255 - sat) * val) >> 8;
-    color = (val - base) * (hue % 60) / 60;
+    color = ((uint16_t)(val - base) * (sector & 0xFF)) >> 8;
 
-    switch (hue / 60) {
+    switch (sector >> 8) {
       case 0:
         r = val;
         g = base + color;
@@ -100,6 +103,15 @@ void sethsv(uint16_t hue, uint8_t sat, uint8_t val, LED_TYPE *led1) {
   setrgb(r, g, b, led1);
 }
 
+void sethsv(uint16_t hue, uint8_t sat, uint8_t val, LED_TYPE *led1) {
+  // hue * 1536 / 360, the products fit 16 bits up to 359
+  sethsv_sector(hue * 4 + ((hue * 68) >> 8), sat, val, led1);
+}
+
+void sethsv_wheel(uint8_t hue, uint8_t sat, uint8_t val, LED_TYPE *led1) {
+  sethsv_sector(hue * 6, sat, val, led1);
+}
+
 void setrgb(uint8_t r, uint8_t g, uint8_t b, LED_TYPE *led1) {
   (*led1).r = r;
   (*led1).g = g;
@@ -417,25 +429,29 @@ void rgblight_sethsv_at(uint16_t hue, uint8_t sat, uint8_t val, uint8_t index) {
 }
 
 #ifndef RGBLIGHT_CUSTOM_DRIVER
+// The frame the LEDs show. Sending one keeps the interrupts disabled for
+// about 30us per LED, so frames that don't change anything aren't sent.
+static LED_TYPE led_sent[RGBLED_NUM];
+static bool led_sent_valid = false;
+
 void rgblight_set(void) {
-  if (rgblight_config.enable) {
-    #ifdef RGBW
-      ws2812_setleds_rgbw(led, RGBLED_NUM);
-    #else
-      ws2812_setleds(led, RGBLED_NUM);
-    #endif
-  } else {
+  if (!rgblight_config.enable) {
     for (uint8_t i = 0; i < RGBLED_NUM; i++) {
       led[i].r = 0;
       led[i].g = 0;
       led[i].b = 0;
     }
-    #ifdef RGBW
-      ws2812_setleds_rgbw(led, RGBLED_NUM);
-    #else
-      ws2812_setleds(led, RGBLED_NUM);
-    #endif
   }
+  if (led_sent_valid && memcmp(led, led_sent, sizeof(led)) == 0) {
+    return;
+  }
+  memcpy(led_sent, led, sizeof(led));
+  led_sent_valid = true;
+  #ifdef RGBW
+    ws2812_setleds_rgbw(led, RGBLED_NUM);
+  #else
+    ws2812_setleds(led, RGBLED_NUM);
+  #endif
 }
 #endif
 
@@ -505,10 +521,28 @@ void rgblight_task(void) {
 }
 
 // Effects
+// Breathing curve exp(sin(pos / 255 * pi)), scaled from 0 at 1 to 255 at e,
+// for the first half of the 256 steps; the second half mirrors it
+static const uint8_t breathing_curve[128] PROGMEM = {
+  0, 2, 4, 6, 7, 9, 11, 13, 15, 17, 19, 21, 24, 26, 28, 30,
+  32, 34, 37, 39, 41, 43, 46, 48, 50, 53, 55, 57, 60, 62, 65, 67,
+  69, 72, 74, 77, 80, 82, 85, 87, 90, 92, 95, 98, 100, 103, 105, 108,
+  111, 113, 116, 119, 121, 124, 127, 129, 132, 135, 137, 140, 143, 145, 148, 151,
+  153, 156, 158, 161, 164, 166, 169, 171, 174, 176, 179, 181, 184, 186, 188, 191,
+  193, 195, 198, 200, 202, 204, 207, 209, 211, 213, 215, 217, 219, 221, 223, 224,
+  226, 228, 229, 231, 233, 234, 236, 237, 239, 240, 241, 242, 244, 245, 246, 247,
+  248, 249, 249, 250, 251, 252, 252, 253, 253, 254, 254, 254, 255, 255, 255, 255,
+};
+
+// (exp(sin) - CENTER / e) * MAX / (e - 1 / e) rewritten as
+// curve * BREATHE_SCALE + BREATHE_OFFSET, in Q8, folded by the compiler
+#define BREATHE_SCALE ((int32_t)(256.0 * RGBLIGHT_EFFECT_BREATHE_MAX * M_E / ((M_E + 1) * 255) + 0.5))
+#define BREATHE_OFFSET ((int32_t)((1 - RGBLIGHT_EFFECT_BREATHE_CENTER / M_E) * RGBLIGHT_EFFECT_BREATHE_MAX / (M_E - 1 / M_E) * 256))
+
 void rgblight_effect_breathing(uint8_t interval) {
   static uint8_t pos = 0;
   static uint16_t last_timer = 0;
-  float val;
+  int32_t val;
 
   if (timer_elapsed(last_timer) < pgm_read_byte(&RGBLED_BREATHING_INTERVALS[interval])) {
     return;
@@ -517,9 +551,15 @@ void rgblight_effect_breathing(uint8_t interval) {
 
 
   // http://sean.voisen.org/blog/2011/10/breathing-led-with-arduino/
-  val = (exp(sin((pos/255.0)*M_PI)) - RGBLIGHT_EFFECT_BREATHE_CENTER/M_E)*(RGBLIGHT_EFFECT_BREATHE_MAX/(M_E-1/M_E));
+  val = pgm_read_byte(&breathing_curve[pos < 128 ? pos : 255 - pos]);
+  val = (val * BREATHE_SCALE + BREATHE_OFFSET + 128) >> 8;
+  if (val < 0) {
+    val = 0;
+  } else if (val > 255) {
+    val = 255;
+  }
   rgblight_sethsv_noeeprom(rgblight_config.hue, rgblight_config.sat, val);
-  pos = (pos + 1) % 256;
+  pos++;
 }
 void rgblight_effect_rainbow_mood(uint8_t interval) {
   static uint16_t current_hue = 0;
@@ -532,7 +572,11 @@ void rgblight_effect_rainbow_mood(uint8_t interval) {
   rgblight_sethsv_noeeprom(current_hue, rgblight_config.sat, rgblight_config.val);
   current_hue = (current_hue + 1) % 360;
 }
+// One degree of the hue wheel, in 1/256 of the 0-255 wheel of sethsv_wheel()
+#define RAINBOW_SWIRL_DEGREE (65536 / 360)
+
 void rgblight_effect_rainbow_swirl(uint8_t interval) {
+  // Q8.8 positions on the hue wheel, which wrap around by themselves
   static uint16_t current_hue = 0;
   static uint16_t last_timer = 0;
   uint16_t hue;
@@ -541,20 +585,17 @@ void rgblight_effect_rainbow_swirl(uint8_t interval) {
     return;
   }
   last_timer = timer_read();
+  hue = current_hue;
   for (i = 0; i < RGBLED_NUM; i++) {
-    hue = (360 / RGBLED_NUM * i + current_hue) % 360;
-    sethsv(hue, rgblight_config.sat, rgblight_config.val, (LED_TYPE *)&led[i]);
+    sethsv_wheel(hue >> 8, rgblight_config.sat, rgblight_config.val, (LED_TYPE *)&led[i]);
+    hue += 65536 / RGBLED_NUM;
   }
   rgblight_set();
 
   if (interval % 2) {
-    current_hue = (current_hue + 1) % 360;
+    current_hue += RAINBOW_SWIRL_DEGREE;
   } else {
-    if (current_hue - 1 < 0) {
-      current_hue = 359;
-    } else {
-      current_hue = current_hue - 1;
-    }
+    current_hue -= RAINBOW_SWIRL_DEGREE;
   }
 }
 void rgblight_effect_snake(uint8_t interval) {
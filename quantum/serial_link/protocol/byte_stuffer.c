@@ -26,6 +26,7 @@ SOFTWARE.
 #include "serial_link/protocol/frame_validator.h"
 #include "serial_link/protocol/physical.h"
 #include <stdbool.h>
+#include <string.h>
 
 // This implements the "Consistent overhead byte stuffing protocol"
 // https://en.wikipedia.org/wiki/Consistent_Overhead_Byte_Stuffing
@@ -93,6 +94,7 @@ void byte_stuffer_recv_byte(uint8_t link, uint8_t data) {
             else {
                 // Special case for zeroes
                 state->next_zero = data;
+                state->long_frame = data == 0xFF;
                 state->data[state->data_pos++] = 0;
             }
         }
@@ -102,6 +104,54 @@ void byte_stuffer_recv_byte(uint8_t link, uint8_t data) {
     }
 }
 
+// Decodes the frame in place, and returns its size, or 0 when it's invalid
+static uint16_t decode_in_place(uint8_t* data, uint16_t size) {
+    uint16_t read = 0;
+    uint16_t write = 0;
+    while (read < size) {
+        uint8_t code = data[read++];
+        if (code - 1 > size - read) {
+            // The frame ended before the block
+            return 0;
+        }
+        // Decoding only removes bytes, so the block never overlaps
+        // anything still to be read
+        memmove(data + write, data + read, code - 1);
+        write += code - 1;
+        read += code - 1;
+        if (code != 0xFF && read < size) {
+            data[write++] = 0;
+        }
+    }
+    return write;
+}
+
+void byte_stuffer_recv_block(uint8_t link, uint8_t* data, uint16_t size) {
+    byte_stuffer_state_t* state = &states[link];
+    uint8_t* end = data + size;
+    while (data < end) {
+        if (state->next_zero != 0) {
+            // Finish the frame that started in an earlier block
+            byte_stuffer_recv_byte(link, *data++);
+            continue;
+        }
+        uint8_t* zero = memchr(data, 0, end - data);
+        if (!zero || zero - data > MAX_FRAME_SIZE) {
+            // Frames that don't end in this block, or that are too long for
+            // the buffer, take the byte by byte way
+            byte_stuffer_recv_byte(link, *data++);
+            continue;
+        }
+        if (zero > data) {
+            uint16_t frame_size = decode_in_place(data, zero - data);
+            if (frame_size > 0) {
+                validator_recv_frame(link, data, frame_size);
+            }
+        }
+        data = zero + 1;
+    }
+}
+
 static void send_block(uint8_t link, uint8_t* start, uint8_t* end, uint8_t num_non_zero) {
     send_data(link, &num_non_zero, 1);
     if (end > start) {
@@ -32,6 +32,10 @@ SOFTWARE.
 
 void init_byte_stuffer(void);
 void byte_stuffer_recv_byte(uint8_t link, uint8_t data);
+// Receives the bytes like byte_stuffer_recv_byte(), but frames that are
+// completely in the block are decoded in place and passed on from there.
+// The block is modified.
+void byte_stuffer_recv_block(uint8_t link, uint8_t* data, uint16_t size);
 void byte_stuffer_send_frame(uint8_t link, uint8_t* data, uint16_t size);
 
 #endif
@@ -0,0 +1,43 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SERIAL_LINK_CRC_H
+#define SERIAL_LINK_CRC_H
+
+#include <stdint.h>
+
+// The CRCs of the frame validator. All the CRC32 variants compute the same
+// CRC, the table driven ones trade flash for speed: crc32_bytewise() uses a
+// 1 KB table, crc32_slicing4() 4 KB and crc32_slicing8() 8 KB.
+uint32_t crc32_bytewise(const uint8_t* data, uint32_t size);
+uint32_t crc32_slicing4(const uint8_t* data, uint32_t size);
+uint32_t crc32_slicing8(const uint8_t* data, uint32_t size);
+#ifdef SERIAL_LINK_CRC_HAL
+// The CRC unit of the MCU, through the CRC driver of ChibiOS-Contrib
+uint32_t crc32_hal(const uint8_t* data, uint32_t size);
+#endif
+// CRC-16/CCITT-FALSE with a 32 byte table, for short frames
+uint16_t crc16_ccitt(const uint8_t* data, uint32_t size);
+
+#endif
@@ -40,10 +40,18 @@ void route_incoming_frame(uint8_t link, uint8_t* data, uint16_t size){
     }
     else {
         if (link == UP_LINK) {
-            if (data[size-1] & 1) {
+            // The destination counts down the hops left to the target slave,
+            // broadcasts are received and passed on by every slave
+            uint8_t destination = data[size-1];
+            if (destination == ROUTER_BROADCAST || destination == 1) {
                 transport_recv_frame(0, data, size - 1);
             }
-            data[size-1] >>= 1;
+            if (destination != ROUTER_BROADCAST) {
+                if (destination <= 1) {
+                    return;
+                }
+                data[size-1]--;
+            }
             validator_send_frame(DOWN_LINK, data, size);
         }
         else {
@@ -31,6 +31,10 @@ SOFTWARE.
 #define UP_LINK 0
 #define DOWN_LINK 1
 
+// Destinations of router_send_frame(): the master is 0, the slaves are
+// numbered from 1 along the chain, and the broadcast reaches all of them
+#define ROUTER_BROADCAST 0xFF
+
 void router_set_master(bool master);
 void route_incoming_frame(uint8_t link, uint8_t* data, uint16_t size);
 void router_send_frame(uint8_t destination, uint8_t* data, uint16_t size);
@@ -27,8 +27,17 @@ SOFTWARE.
 
 #include <stdint.h>
 
+// Both sides of the link need the same CRC: the default CRC32 computed with
+// one of SERIAL_LINK_CRC_SLICING4, SERIAL_LINK_CRC_SLICING8 or
+// SERIAL_LINK_CRC_HAL, or the CRC-16 of SERIAL_LINK_CRC16.
+#ifdef SERIAL_LINK_CRC16
+#define SERIAL_LINK_CRC_SIZE 2
+#else
+#define SERIAL_LINK_CRC_SIZE 4
+#endif
+
 void validator_recv_frame(uint8_t link, uint8_t* data, uint16_t size);
-// The buffer pointed to by the data needs 4 additional bytes
+// The buffer pointed to by the data needs SERIAL_LINK_CRC_SIZE additional bytes
 void validator_send_frame(uint8_t link, uint8_t* data, uint16_t size);
 
 #endif
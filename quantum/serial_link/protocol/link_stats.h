@@ -0,0 +1,49 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SERIAL_LINK_LINK_STATS_H
+#define SERIAL_LINK_LINK_STATS_H
+
+#include <stdint.h>
+
+// Counters of the traffic and the errors on one link, indexed by UP_LINK and
+// DOWN_LINK. They wrap around, readers should look at the differences.
+typedef struct {
+    uint16_t frames_sent;
+    uint16_t frames_received;
+    uint16_t crc_errors;
+    // Times the UART lost received bytes because its queue was full
+    uint16_t overruns;
+    // Parity, framing and noise errors and breaks reported by the UART
+    uint16_t line_errors;
+    uint16_t retransmits;
+} serial_link_stats_t;
+
+#define NUM_LINKS 2
+
+extern serial_link_stats_t link_stats[NUM_LINKS];
+
+void init_link_stats(void);
+
+#endif
@@ -25,9 +25,20 @@ SOFTWARE.
 #include "serial_link/protocol/transport.h"
 #include "serial_link/protocol/frame_router.h"
 #include "serial_link/protocol/triple_buffered_object.h"
+#include "serial_link/protocol/link_stats.h"
+#include "timer.h"
 #include <string.h>
 
 #define MAX_REMOTE_OBJECTS 16
+
+// Frames of reliable objects end with the sequence number and the id, their
+// acknowledgements are the sequence number and the id with this flag
+#define RELIABLE_ACK 0x80
+
+// The channels of a reliable object: for master to single slave objects the
+// master sends to slave i on channel i and the slave receives on channel
+// NUM_SLAVES, for slave to master objects the slave sends on channel 0 and the
+// master receives from slave i on channel i + 1.
 static remote_object_t* remote_objects[MAX_REMOTE_OBJECTS];
 static uint32_t num_remote_objects = 0;
 
@@ -40,6 +51,9 @@ void add_remote_objects(remote_object_t** _remote_objects, uint32_t _num_remote_
     for(i=0;i<_num_remote_objects;i++) {
         remote_object_t* obj = _remote_objects[i];
         remote_objects[num_remote_objects++] = obj;
+        if (obj->channels) {
+            memset(obj->channels, 0, (NUM_SLAVES + 1) * sizeof(reliable_channel_t));
+        }
         if (obj->object_type == MASTER_TO_ALL_SLAVES) {
             triple_buffer_object_t* tb = (triple_buffer_object_t*)obj->buffer;
             triple_buffer_init(tb);
@@ -73,41 +87,153 @@ void add_remote_objects(remote_object_t** _remote_objects, uint32_t _num_remote_
     }
 }
 
+static void recv_ack(uint8_t from, uint8_t* data, uint16_t size) {
+    uint8_t id = data[size-1] & ~RELIABLE_ACK;
+    if (id >= num_remote_objects || size != 2) {
+        return;
+    }
+    remote_object_t* obj = remote_objects[id];
+    reliable_channel_t* channel;
+    if (!obj->channels) {
+        return;
+    }
+    else if (obj->object_type == MASTER_TO_SINGLE_SLAVE) {
+        if (from == 0 || from > NUM_SLAVES) {
+            return;
+        }
+        channel = &obj->channels[from - 1];
+    }
+    else {
+        channel = &obj->channels[0];
+    }
+    if (channel->frame && channel->seq == data[0]) {
+        channel->frame = NULL;
+    }
+}
+
 void transport_recv_frame(uint8_t from, uint8_t* data, uint16_t size) {
+    if (size == 0) {
+        return;
+    }
     uint8_t id = data[size-1];
+    if (id & RELIABLE_ACK) {
+        recv_ack(from, data, size);
+        return;
+    }
     if (id < num_remote_objects) {
         remote_object_t* obj = remote_objects[id];
-        if (obj->object_size == size - 1) {
+        uint16_t header_size = obj->channels ? 2 : 1;
+        if (obj->object_size == size - header_size) {
             uint8_t* start;
+            reliable_channel_t* channel = NULL;
             if (obj->object_type == MASTER_TO_ALL_SLAVES) {
                 start = obj->buffer + LOCAL_OBJECT_SIZE(obj->object_size);
             }
             else if(obj->object_type == SLAVE_TO_MASTER) {
+                // Slaves further down the chain than configured have no buffers
+                if (from == 0 || from > NUM_SLAVES) {
+                    return;
+                }
                 start = obj->buffer + LOCAL_OBJECT_SIZE(obj->object_size);
                 start += (from - 1) * REMOTE_OBJECT_SIZE(obj->object_size);
+                if (obj->channels) {
+                    channel = &obj->channels[from];
+                }
             }
             else {
                 start = obj->buffer + NUM_SLAVES * LOCAL_OBJECT_SIZE(obj->object_size);
+                if (obj->channels) {
+                    channel = &obj->channels[NUM_SLAVES];
+                }
+            }
+            if (channel) {
+                // Acknowledge repeated frames again, the first acknowledgement
+                // might have been lost, but don't deliver them twice. A sender
+                // that starts over sends 0 first.
+                uint8_t seq = data[size-2];
+                channel->ack_pending = true;
+                if (seq != 0 && seq == channel->received_seq) {
+                    return;
+                }
+                channel->received_seq = seq;
             }
             triple_buffer_object_t* tb = (triple_buffer_object_t*)start;
             void* ptr = triple_buffer_begin_write_internal(obj->object_size, tb);
-            memcpy(ptr, data, size - 1);
+            memcpy(ptr, data, obj->object_size);
             triple_buffer_end_write_internal(tb);
         }
     }
 }
 
+static uint8_t sender_link(remote_object_t* obj) {
+    return obj->object_type == SLAVE_TO_MASTER ? UP_LINK : DOWN_LINK;
+}
+
+static void send_object(uint8_t id, remote_object_t* obj, reliable_channel_t* channel,
+        uint8_t dest, uint8_t* ptr) {
+    if (ptr) {
+        if (channel) {
+            channel->seq = channel->started ? channel->seq % 255 + 1 : 0;
+            channel->started = true;
+            channel->frame = ptr;
+            channel->retransmits = 0;
+        }
+    }
+    else if (channel && channel->frame &&
+            timer_elapsed(channel->sent_time) >= SERIAL_LINK_RETRANSMIT_TIMEOUT) {
+        if (channel->retransmits == SERIAL_LINK_MAX_RETRANSMITS) {
+            // Give up, the next write is sent again
+            channel->frame = NULL;
+            return;
+        }
+        channel->retransmits++;
+        link_stats[sender_link(obj)].retransmits++;
+        ptr = channel->frame;
+    }
+    else {
+        return;
+    }
+    uint16_t size = obj->object_size;
+    if (channel) {
+        ptr[size++] = channel->seq;
+        channel->sent_time = timer_read();
+    }
+    ptr[size++] = id;
+    router_send_frame(dest, ptr, size);
+}
+
+static void send_ack(uint8_t id, reliable_channel_t* channel, uint8_t dest) {
+    if (channel->ack_pending) {
+        channel->ack_pending = false;
+        uint8_t ack[2 + LOCAL_OBJECT_EXTRA];
+        ack[0] = channel->received_seq;
+        ack[1] = id | RELIABLE_ACK;
+        router_send_frame(dest, ack, 2);
+    }
+}
+
 void update_transport(void) {
     unsigned int i;
     for(i=0;i<num_remote_objects;i++) {
         remote_object_t* obj = remote_objects[i];
-        if (obj->object_type == MASTER_TO_ALL_SLAVES || obj->object_type == SLAVE_TO_MASTER) {
+        uint16_t read_size = obj->object_size + LOCAL_OBJECT_EXTRA;
+        if (obj->object_type == MASTER_TO_ALL_SLAVES) {
             triple_buffer_object_t* tb = (triple_buffer_object_t*)obj->buffer;
-            uint8_t* ptr = (uint8_t*)triple_buffer_read_internal(obj->object_size + LOCAL_OBJECT_EXTRA, tb);
-            if (ptr) {
-                ptr[obj->object_size] = i;
-                uint8_t dest = obj->object_type == MASTER_TO_ALL_SLAVES ? 0xFF : 0;
-                router_send_frame(dest, ptr, obj->object_size + 1);
+            uint8_t* ptr = (uint8_t*)triple_buffer_read_internal(read_size, tb);
+            send_object(i, obj, NULL, ROUTER_BROADCAST, ptr);
+        }
+        else if (obj->object_type == SLAVE_TO_MASTER) {
+            triple_buffer_object_t* tb = (triple_buffer_object_t*)obj->buffer;
+            uint8_t* ptr = (uint8_t*)triple_buffer_read_internal(read_size, tb);
+            if (obj->channels) {
+                send_object(i, obj, &obj->channels[0], 0, ptr);
+                unsigned int j;
+                for (j=1;j<=NUM_SLAVES;j++) {
+                    send_ack(i, &obj->channels[j], j);
+                }
+            }
+            else {
+                send_object(i, obj, NULL, 0, ptr);
             }
         }
         else {
@@ -115,14 +241,29 @@ void update_transport(void) {
             unsigned int j;
             for (j=0;j<NUM_SLAVES;j++) {
                 triple_buffer_object_t* tb = (triple_buffer_object_t*)start;
-                uint8_t* ptr = (uint8_t*)triple_buffer_read_internal(obj->object_size + LOCAL_OBJECT_EXTRA, tb);
-                if (ptr) {
-                    ptr[obj->object_size] = i;
-                    uint8_t dest = j + 1;
-                    router_send_frame(dest, ptr, obj->object_size + 1);
-                }
+                uint8_t* ptr = (uint8_t*)triple_buffer_read_internal(read_size, tb);
+                send_object(i, obj, obj->channels ? &obj->channels[j] : NULL, j + 1, ptr);
                 start += LOCAL_OBJECT_SIZE(obj->object_size);
             }
+            if (obj->channels) {
+                send_ack(i, &obj->channels[NUM_SLAVES], 0);
+            }
+        }
+    }
+}
+
+bool transport_retransmit_pending(void) {
+    unsigned int i;
+    for(i=0;i<num_remote_objects;i++) {
+        remote_object_t* obj = remote_objects[i];
+        if (obj->channels) {
+            unsigned int j;
+            for (j=0;j<NUM_SLAVES;j++) {
+                if (obj->channels[j].frame) {
+                    return true;
+                }
+            }
         }
     }
+    return false;
 }
@@ -27,10 +27,33 @@ SOFTWARE.
 
 #include "serial_link/protocol/triple_buffered_object.h"
 #include "serial_link/system/serial_link.h"
+#include <stdbool.h>
+#include <stddef.h>
 
+// The number of slaves daisy chained on the down link of the master. Every
+// remote object reserves buffers for each of them, so keyboards with fewer
+// halves should define it in their config.h to save the RAM.
+#ifndef NUM_SLAVES
 #define NUM_SLAVES 8
+#endif
+
+// 0xFF is the broadcast address of the frame router
+#if NUM_SLAVES < 1 || NUM_SLAVES > 254
+#error "NUM_SLAVES must be between 1 and 254"
+#endif
+
 #define LOCAL_OBJECT_EXTRA 16
 
+// Reliable objects are resent when they are not acknowledged within the
+// timeout, at most SERIAL_LINK_MAX_RETRANSMITS times
+#ifndef SERIAL_LINK_RETRANSMIT_TIMEOUT
+#define SERIAL_LINK_RETRANSMIT_TIMEOUT 5
+#endif
+
+#ifndef SERIAL_LINK_MAX_RETRANSMITS
+#define SERIAL_LINK_MAX_RETRANSMITS 10
+#endif
+
 // master -> slave = 1 local(target all), 1 remote object
 // slave -> master = 1 local(target 0), multiple remote objects
 // master -> single slave (multiple local, target id), 1 remote object
@@ -40,10 +63,25 @@ typedef enum {
     SLAVE_TO_MASTER,
 } remote_object_type;
 
+// The state of one direction of a reliable object, the sender waits for the
+// acknowledgement of its last frame and the receiver drops repeated frames
+typedef struct {
+    // The frame waiting to be acknowledged, or NULL
+    uint8_t* frame;
+    uint16_t sent_time;
+    uint8_t seq;
+    uint8_t retransmits;
+    bool started;
+    uint8_t received_seq;
+    bool ack_pending;
+} reliable_channel_t;
+
 typedef struct {
     remote_object_type object_type;
     uint16_t object_size;
-    uint8_t buffer[] __attribute__((aligned(4)));
+    // NUM_SLAVES + 1 channels for reliable objects, NULL for the others
+    reliable_channel_t* channels;
+    uint8_t buffer[0] __attribute__((aligned(4)));
 } remote_object_t;
 
 #define REMOTE_OBJECT_SIZE(objectsize) \
@@ -85,12 +123,13 @@ typedef struct { \
         return (type*)triple_buffer_read_internal(obj->object_size, tb); \
     }
 
-#define MASTER_TO_SINGLE_SLAVE_OBJECT(name, type) \
+#define MASTER_TO_SINGLE_SLAVE_OBJECT_INTERNAL(name, type, reliable_channels) \
     REMOTE_OBJECT_HELPER(name, type, NUM_SLAVES, 1) \
     remote_object_##name##_t remote_object_##name = { \
         .object = { \
             .object_type = MASTER_TO_SINGLE_SLAVE, \
             .object_size = sizeof(type), \
+            .channels = reliable_channels, \
         } \
     }; \
     type* begin_write_##name(uint8_t slave) { \
@@ -115,12 +154,13 @@ typedef struct { \
         return (type*)triple_buffer_read_internal(obj->object_size, tb); \
     }
 
-#define SLAVE_TO_MASTER_OBJECT(name, type) \
+#define SLAVE_TO_MASTER_OBJECT_INTERNAL(name, type, reliable_channels) \
     REMOTE_OBJECT_HELPER(name, type, 1, NUM_SLAVES) \
     remote_object_##name##_t remote_object_##name = { \
         .object = { \
             .object_type = SLAVE_TO_MASTER, \
             .object_size = sizeof(type), \
+            .channels = reliable_channels, \
         } \
     }; \
     type* begin_write_##name(void) { \
@@ -142,11 +182,32 @@ typedef struct { \
         return (type*)triple_buffer_read_internal(obj->object_size, tb); \
     }
 
+#define MASTER_TO_SINGLE_SLAVE_OBJECT(name, type) \
+    MASTER_TO_SINGLE_SLAVE_OBJECT_INTERNAL(name, type, NULL)
+
+#define SLAVE_TO_MASTER_OBJECT(name, type) \
+    SLAVE_TO_MASTER_OBJECT_INTERNAL(name, type, NULL)
+
+// Reliable objects are for state that must not wait for the next periodic
+// write, like the LEDs or the layers. Every frame carries a sequence number
+// and is resent until the receiver acknowledges it. Like the other objects
+// they hold the latest value, a write replaces the one still being sent.
+#define RELIABLE_MASTER_TO_SINGLE_SLAVE_OBJECT(name, type) \
+    static reliable_channel_t reliable_channels_##name[NUM_SLAVES + 1]; \
+    MASTER_TO_SINGLE_SLAVE_OBJECT_INTERNAL(name, type, reliable_channels_##name)
+
+#define RELIABLE_SLAVE_TO_MASTER_OBJECT(name, type) \
+    static reliable_channel_t reliable_channels_##name[NUM_SLAVES + 1]; \
+    SLAVE_TO_MASTER_OBJECT_INTERNAL(name, type, reliable_channels_##name)
+
 #define REMOTE_OBJECT(name) (remote_object_t*)&remote_object_##name
 
 void add_remote_objects(remote_object_t** remote_objects, uint32_t num_remote_objects);
 void reinitialize_serial_link_transport(void);
 void transport_recv_frame(uint8_t from, uint8_t* data, uint16_t size);
 void update_transport(void);
+// Whether a reliable object waits for an acknowledgement, update_transport()
+// needs to be called again within SERIAL_LINK_RETRANSMIT_TIMEOUT then
+bool transport_retransmit_pending(void);
 
 #endif
@@ -0,0 +1,109 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "serial_link/system/matrix_sync.h"
+#include <string.h>
+
+void matrix_sync_init_sender(matrix_sync_sender_t* sender) {
+    memset(sender, 0, sizeof(*sender));
+}
+
+matrix_sync_result_t matrix_sync_encode(matrix_sync_sender_t* sender, const matrix_row_t* rows, matrix_delta_t* delta) {
+    bool overflow = false;
+    delta->count = 0;
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        matrix_row_t changes = rows[row] ^ sender->rows[row];
+        for (uint8_t col = 0; changes; col++, changes >>= 1) {
+            if (!(changes & 1)) {
+                continue;
+            }
+            if (delta->count == MATRIX_SYNC_MAX_EVENTS) {
+                overflow = true;
+                break;
+            }
+            matrix_sync_event_t* event = &delta->events[delta->count++];
+            event->row = row;
+            event->col = col;
+            if (rows[row] & ((matrix_row_t)1 << col)) {
+                event->col |= MATRIX_SYNC_PRESSED;
+            }
+        }
+    }
+    if (delta->count == 0) {
+        return MATRIX_SYNC_NONE;
+    }
+    memcpy(sender->rows, rows, sizeof(sender->rows));
+    delta->seq = ++sender->seq;
+    return overflow ? MATRIX_SYNC_SNAPSHOT : MATRIX_SYNC_DELTA;
+}
+
+void matrix_sync_snapshot(const matrix_sync_sender_t* sender, matrix_snapshot_t* snapshot) {
+    snapshot->seq = sender->seq;
+    memcpy(snapshot->rows, sender->rows, sizeof(snapshot->rows));
+}
+
+void matrix_sync_init_receiver(matrix_sync_receiver_t* receiver) {
+    memset(receiver, 0, sizeof(*receiver));
+}
+
+bool matrix_sync_apply_delta(matrix_sync_receiver_t* receiver, const matrix_delta_t* delta) {
+    if (!receiver->synced) {
+        return false;
+    }
+    uint8_t diff = delta->seq - receiver->seq;
+    // A delta that was sent after the snapshot that already has it
+    if (diff == 0) {
+        return true;
+    }
+    if (diff != 1 || delta->count > MATRIX_SYNC_MAX_EVENTS) {
+        receiver->synced = false;
+        return false;
+    }
+    for (uint8_t i = 0; i < delta->count; i++) {
+        const matrix_sync_event_t* event = &delta->events[i];
+        uint8_t col = event->col & ~MATRIX_SYNC_PRESSED;
+        if (event->row >= MATRIX_ROWS || col >= MATRIX_COLS) {
+            receiver->synced = false;
+            return false;
+        }
+        if (event->col & MATRIX_SYNC_PRESSED) {
+            receiver->rows[event->row] |= (matrix_row_t)1 << col;
+        } else {
+            receiver->rows[event->row] &= ~((matrix_row_t)1 << col);
+        }
+    }
+    receiver->seq = delta->seq;
+    return true;
+}
+
+void matrix_sync_apply_snapshot(matrix_sync_receiver_t* receiver, const matrix_snapshot_t* snapshot) {
+    // The transport can send a snapshot after the delta that followed it,
+    // the master has that state already
+    if (receiver->synced && (uint8_t)(receiver->seq - snapshot->seq) == 1) {
+        return;
+    }
+    memcpy(receiver->rows, snapshot->rows, sizeof(receiver->rows));
+    receiver->seq = snapshot->seq;
+    receiver->synced = true;
+}
@@ -0,0 +1,91 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SERIAL_LINK_MATRIX_SYNC_H
+#define SERIAL_LINK_MATRIX_SYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "matrix.h"
+
+// The slaves send the changes of their matrix instead of the whole matrix.
+// Every delta has a sequence number, and when the master sees one missing it
+// asks for a snapshot of the whole matrix, which the slaves also send now and
+// then, and when a scan changes more keys than a delta holds.
+
+// Key changes in a delta, every scan with changes sends one
+#ifndef MATRIX_SYNC_MAX_EVENTS
+#define MATRIX_SYNC_MAX_EVENTS 2
+#endif
+
+#define MATRIX_SYNC_PRESSED 0x80
+
+typedef struct {
+    uint8_t row;
+    // the column, or'ed with MATRIX_SYNC_PRESSED when pressed
+    uint8_t col;
+} matrix_sync_event_t;
+
+typedef struct {
+    uint8_t seq;
+    uint8_t count;
+    matrix_sync_event_t events[MATRIX_SYNC_MAX_EVENTS];
+} matrix_delta_t;
+
+typedef struct {
+    // the sequence number of the last delta it includes
+    uint8_t seq;
+    matrix_row_t rows[MATRIX_ROWS];
+} matrix_snapshot_t;
+
+typedef struct {
+    matrix_row_t rows[MATRIX_ROWS];
+    uint8_t seq;
+} matrix_sync_sender_t;
+
+typedef struct {
+    matrix_row_t rows[MATRIX_ROWS];
+    uint8_t seq;
+    // false until the first snapshot, and after a delta went missing
+    bool synced;
+} matrix_sync_receiver_t;
+
+typedef enum {
+    MATRIX_SYNC_NONE,
+    MATRIX_SYNC_DELTA,
+    // more keys changed than a delta holds
+    MATRIX_SYNC_SNAPSHOT,
+} matrix_sync_result_t;
+
+void matrix_sync_init_sender(matrix_sync_sender_t* sender);
+// Compares rows with what was sent before, and fills the delta of the changes
+matrix_sync_result_t matrix_sync_encode(matrix_sync_sender_t* sender, const matrix_row_t* rows, matrix_delta_t* delta);
+void matrix_sync_snapshot(const matrix_sync_sender_t* sender, matrix_snapshot_t* snapshot);
+
+void matrix_sync_init_receiver(matrix_sync_receiver_t* receiver);
+// Returns false if a snapshot is needed before the deltas can be applied
+bool matrix_sync_apply_delta(matrix_sync_receiver_t* receiver, const matrix_delta_t* delta);
+void matrix_sync_apply_snapshot(matrix_sync_receiver_t* receiver, const matrix_snapshot_t* snapshot);
+
+#endif
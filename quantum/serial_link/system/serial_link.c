@@ -28,6 +28,8 @@ SOFTWARE.
 #include "serial_link/protocol/byte_stuffer.h"
 #include "serial_link/protocol/transport.h"
 #include "serial_link/protocol/frame_router.h"
+#include "serial_link/protocol/link_stats.h"
+#include "serial_link/system/matrix_sync.h"
 #include "matrix.h"
 #include <stdbool.h>
 #include "print.h"
@@ -67,19 +69,23 @@ static SerialConfig config = {
 //#define DEBUG_LINK_ERRORS
 
 static uint32_t read_from_serial(SerialDriver* driver, uint8_t link) {
-    const uint32_t buffer_size = 16;
+    // Big enough for a few frames, those that fit completely are decoded
+    // in the buffer without copying them
+    const uint32_t buffer_size = 64;
     uint8_t buffer[buffer_size];
     uint32_t bytes_read = sdAsynchronousRead(driver, buffer, buffer_size);
-    uint8_t* current = buffer;
-    uint8_t* end = current + bytes_read;
-    while(current < end) {
-        byte_stuffer_recv_byte(link, *current);
-        current++;
-    }
+    byte_stuffer_recv_block(link, buffer, bytes_read);
     return bytes_read;
 }
 
 static void print_error(char* str, eventflags_t flags, SerialDriver* driver) {
+    uint8_t link = driver == &SD1 ? DOWN_LINK : UP_LINK;
+    if (flags & SD_OVERRUN_ERROR) {
+        link_stats[link].overruns++;
+    }
+    if (flags & (SD_PARITY_ERROR | SD_FRAMING_ERROR | SD_NOISE_ERROR | SD_BREAK_DETECTED)) {
+        link_stats[link].line_errors++;
+    }
 #ifdef DEBUG_LINK_ERRORS
     if (flags & SD_PARITY_ERROR) {
         print(str);
@@ -105,8 +111,6 @@ static void print_error(char* str, eventflags_t flags, SerialDriver* driver) {
     }
 #else
     (void)str;
-    (void)flags;
-    (void)driver;
 #endif
 }
 
@@ -137,7 +141,10 @@ static THD_FUNCTION(serialThread, arg) {
         eventflags_t flags1 = 0;
         eventflags_t flags2 = 0;
         if (need_wait) {
-            eventmask_t mask = chEvtWaitAnyTimeout(ALL_EVENTS, MS2ST(1000));
+            // Wake up in time to resend unacknowledged reliable objects
+            systime_t timeout = transport_retransmit_pending() ?
+                MS2ST(SERIAL_LINK_RETRANSMIT_TIMEOUT) : MS2ST(1000);
+            eventmask_t mask = chEvtWaitAnyTimeout(ALL_EVENTS, timeout);
             if (mask & EVENT_MASK(1)) {
                 flags1 = chEvtGetAndClearFlags(&sd1_listener);
                 print_error("DOWNLINK", flags1, &SD1);
@@ -168,24 +175,55 @@ void send_data(uint8_t link, const uint8_t* data, uint16_t size) {
     }
 }
 
-static systime_t last_update = 0;
-
-typedef struct {
-    matrix_row_t rows[MATRIX_ROWS];
-} matrix_object_t;
+// Full matrices are only sent this often, as a last resort for a master that
+// missed a delta, the deltas are sent reliably when the matrix changes
+#ifndef SERIAL_LINK_SNAPSHOT_INTERVAL
+#define SERIAL_LINK_SNAPSHOT_INTERVAL 500
+#endif
 
-static matrix_object_t last_matrix = {};
+#ifndef SERIAL_LINK_STATS_INTERVAL
+#define SERIAL_LINK_STATS_INTERVAL 1000
+#endif
 
-SLAVE_TO_MASTER_OBJECT(keyboard_matrix, matrix_object_t);
+typedef struct {
+    serial_link_stats_t links[NUM_LINKS];
+} serial_link_node_stats_t;
+
+static systime_t last_snapshot = 0;
+static systime_t last_stats = 0;
+static matrix_sync_sender_t matrix_sender;
+static matrix_sync_receiver_t remote_matrix[NUM_SLAVES];
+static uint8_t resync_requests[NUM_SLAVES];
+static serial_link_node_stats_t slave_stats[NUM_SLAVES];
+
+// The snapshot comes before the delta, so that the transport sends a snapshot
+// and the deltas written after it in that order
+SLAVE_TO_MASTER_OBJECT(keyboard_matrix, matrix_snapshot_t);
+// Resent until acknowledged, so that a lost last delta, usually a release,
+// doesn't leave the key down until the next snapshot. A delta that is
+// replaced before it arrives leaves a gap, which the master resyncs.
+RELIABLE_SLAVE_TO_MASTER_OBJECT(keyboard_matrix_delta, matrix_delta_t);
+// A lost resync request would leave the master waiting for the next snapshot
+RELIABLE_MASTER_TO_SINGLE_SLAVE_OBJECT(keyboard_matrix_resync, uint8_t);
 MASTER_TO_ALL_SLAVES_OBJECT(serial_link_connected, bool);
+SLAVE_TO_MASTER_OBJECT(serial_link_stats, serial_link_node_stats_t);
 
 static remote_object_t* remote_objects[] = {
     REMOTE_OBJECT(serial_link_connected),
     REMOTE_OBJECT(keyboard_matrix),
+    REMOTE_OBJECT(keyboard_matrix_delta),
+    REMOTE_OBJECT(keyboard_matrix_resync),
+    REMOTE_OBJECT(serial_link_stats),
 };
 
 void init_serial_link(void) {
     serial_link_connected = false;
+    matrix_sync_init_sender(&matrix_sender);
+    for (uint8_t i = 0; i < NUM_SLAVES; i++) {
+        matrix_sync_init_receiver(&remote_matrix[i]);
+        resync_requests[i] = 0;
+    }
+    init_link_stats();
     init_serial_link_hal();
     add_remote_objects(remote_objects, sizeof(remote_objects)/sizeof(remote_object_t*));
     init_byte_stuffer();
@@ -198,36 +236,80 @@ void init_serial_link(void) {
 
 void matrix_set_remote(matrix_row_t* rows, uint8_t index);
 
+static void send_connected(void) {
+    *begin_write_serial_link_connected() = true;
+    end_write_serial_link_connected();
+}
+
 void serial_link_update(void) {
     if (read_serial_link_connected()) {
         serial_link_connected = true;
     }
 
-    matrix_object_t matrix;
-    bool changed = false;
+    matrix_row_t rows[MATRIX_ROWS];
     for(uint8_t i=0;i<MATRIX_ROWS;i++) {
-        matrix.rows[i] = matrix_get_row(i);
-        changed |= matrix.rows[i] != last_matrix.rows[i];
+        rows[i] = matrix_get_row(i);
     }
 
     systime_t current_time = chVTGetSystemTimeX();
-    systime_t delta = current_time - last_update;
-    if (changed || delta > US2ST(5000)) {
-        last_update = current_time;
-        last_matrix = matrix;
-        matrix_object_t* m = begin_write_keyboard_matrix();
-        for(uint8_t i=0;i<MATRIX_ROWS;i++) {
-            m->rows[i] = matrix.rows[i];
-        }
+    systime_t delta_time = current_time - last_snapshot;
+    matrix_delta_t delta;
+    matrix_sync_result_t result = matrix_sync_encode(&matrix_sender, rows, &delta);
+    if (result == MATRIX_SYNC_DELTA) {
+        *begin_write_keyboard_matrix_delta() = delta;
+        end_write_keyboard_matrix_delta();
+        send_connected();
+    }
+    if (result == MATRIX_SYNC_SNAPSHOT || read_keyboard_matrix_resync() ||
+        delta_time > MS2ST(SERIAL_LINK_SNAPSHOT_INTERVAL)) {
+        last_snapshot = current_time;
+        matrix_sync_snapshot(&matrix_sender, begin_write_keyboard_matrix());
         end_write_keyboard_matrix();
-        *begin_write_serial_link_connected() = true;
-        end_write_serial_link_connected();
+        send_connected();
     }
 
-    matrix_object_t* m = read_keyboard_matrix(0);
-    if (m) {
-        matrix_set_remote(m->rows, 0);
+    if (!is_master && current_time - last_stats > MS2ST(SERIAL_LINK_STATS_INTERVAL)) {
+        last_stats = current_time;
+        serial_link_node_stats_t* stats = begin_write_serial_link_stats();
+        serial_link_get_stats(UP_LINK, &stats->links[UP_LINK]);
+        serial_link_get_stats(DOWN_LINK, &stats->links[DOWN_LINK]);
+        end_write_serial_link_stats();
     }
+
+    for (uint8_t slave = 0; slave < NUM_SLAVES; slave++) {
+        bool received = false;
+        matrix_snapshot_t* snapshot = read_keyboard_matrix(slave);
+        if (snapshot) {
+            matrix_sync_apply_snapshot(&remote_matrix[slave], snapshot);
+            received = true;
+        }
+        matrix_delta_t* remote_delta = read_keyboard_matrix_delta(slave);
+        if (remote_delta) {
+            if (!matrix_sync_apply_delta(&remote_matrix[slave], remote_delta)) {
+                *begin_write_keyboard_matrix_resync(slave) = ++resync_requests[slave];
+                end_write_keyboard_matrix_resync(slave);
+            }
+            received = true;
+        }
+        if (received && remote_matrix[slave].synced) {
+            matrix_set_remote(remote_matrix[slave].rows, slave);
+        }
+        serial_link_node_stats_t* stats = read_serial_link_stats(slave);
+        if (stats) {
+            slave_stats[slave] = *stats;
+        }
+    }
+}
+
+void serial_link_get_stats(uint8_t link, serial_link_stats_t* stats) {
+    // The serial thread updates the counters
+    serial_link_lock();
+    *stats = link_stats[link];
+    serial_link_unlock();
+}
+
+void serial_link_get_slave_stats(uint8_t slave, uint8_t link, serial_link_stats_t* stats) {
+    *stats = slave_stats[slave].links[link];
 }
 
 void signal_data_written(void) {
@@ -26,6 +26,7 @@ SOFTWARE.
 #define SERIAL_LINK_H
 
 #include "host_driver.h"
+#include "serial_link/protocol/link_stats.h"
 #include <stdbool.h>
 
 void init_serial_link(void);
@@ -34,6 +35,11 @@ bool is_serial_link_connected(void);
 bool is_serial_link_master(void);
 host_driver_t* get_serial_link_driver(void);
 void serial_link_update(void);
+// Copies the counters of a link of this keyboard, UP_LINK or DOWN_LINK
+void serial_link_get_stats(uint8_t link, serial_link_stats_t* stats);
+// Copies the counters that a slave, numbered from 0, sent last. Slaves send
+// them every SERIAL_LINK_STATS_INTERVAL ms.
+void serial_link_get_slave_stats(uint8_t slave, uint8_t link, serial_link_stats_t* stats);
 
 #if defined(PROTOCOL_CHIBIOS)
 #include "ch.h"
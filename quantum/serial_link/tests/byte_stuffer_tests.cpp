@@ -26,6 +26,9 @@ SOFTWARE.
 #include "gmock/gmock.h"
 #include <vector>
 #include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
 extern "C" {
 #include "serial_link/protocol/byte_stuffer.h"
 #include "serial_link/protocol/frame_validator.h"
@@ -53,6 +56,10 @@ public:
         std::copy(data, data + size, std::back_inserter(sent_data));
     }
     std::vector<uint8_t> sent_data;
+    // when set, the received frames are collected here instead of the mock
+    std::vector<std::vector<uint8_t>>* received_frames = nullptr;
+    // or only counted
+    unsigned* received_count = nullptr;
 
     static ByteStuffer* Instance;
 };
@@ -61,7 +68,13 @@ ByteStuffer* ByteStuffer::Instance = nullptr;
 
 extern "C" {
     void validator_recv_frame(uint8_t link, uint8_t* data, uint16_t size) {
-        ByteStuffer::Instance->validator_recv_frame(link, data, size);
+        if (ByteStuffer::Instance->received_count) {
+            (*ByteStuffer::Instance->received_count)++;
+        } else if (ByteStuffer::Instance->received_frames) {
+            ByteStuffer::Instance->received_frames->emplace_back(data, data + size);
+        } else {
+            ByteStuffer::Instance->validator_recv_frame(link, data, size);
+        }
     }
 
     void send_data(uint8_t link, const uint8_t* data, uint16_t size) {
@@ -481,3 +494,134 @@ TEST_F(ByteStuffer, sends_and_receives_full_roundtrip_254_bytes_and_then_zero) {
        byte_stuffer_recv_byte(1, d);
     }
 }
+
+TEST_F(ByteStuffer, sends_and_receives_full_roundtrip_zero_and_then_254_bytes) {
+    uint8_t original_data[257];
+    int i;
+    original_data[0] = 1;
+    original_data[1] = 0;
+    for(i=0;i<254;i++) {
+        original_data[i + 2] = i + 1;
+    }
+    original_data[256] = 5;
+    byte_stuffer_send_frame(0, original_data, sizeof(original_data));
+    EXPECT_CALL(*this, validator_recv_frame(_, _, _))
+        .With(Args<1, 2>(ElementsAreArray(original_data)));
+    for(auto& d : sent_data) {
+       byte_stuffer_recv_byte(1, d);
+    }
+}
+
+TEST_F(ByteStuffer, receives_frames_of_a_block_in_place) {
+    uint8_t block[] = {0, 2, 0x37, 0, 3, 1, 2, 1, 0};
+    uint8_t expected1[] = {0x37};
+    uint8_t expected2[] = {1, 2, 0};
+    testing::InSequence s;
+    EXPECT_CALL(*this, validator_recv_frame(_, block + 1, 1))
+        .With(Args<1, 2>(ElementsAreArray(expected1)));
+    EXPECT_CALL(*this, validator_recv_frame(_, block + 4, 3))
+        .With(Args<1, 2>(ElementsAreArray(expected2)));
+    byte_stuffer_recv_block(0, block, sizeof(block));
+}
+
+TEST_F(ByteStuffer, receives_a_frame_split_over_blocks) {
+    uint8_t block1[] = {2, 0x37, 3};
+    uint8_t block2[] = {1, 2, 0, 2};
+    uint8_t block3[] = {5, 0};
+    uint8_t expected1[] = {0x37, 0, 1, 2};
+    uint8_t expected2[] = {5};
+    testing::InSequence s;
+    EXPECT_CALL(*this, validator_recv_frame(_, _, _))
+        .With(Args<1, 2>(ElementsAreArray(expected1)));
+    EXPECT_CALL(*this, validator_recv_frame(_, _, _))
+        .With(Args<1, 2>(ElementsAreArray(expected2)));
+    byte_stuffer_recv_block(0, block1, sizeof(block1));
+    byte_stuffer_recv_block(0, block2, sizeof(block2));
+    byte_stuffer_recv_block(0, block3, sizeof(block3));
+}
+
+TEST_F(ByteStuffer, receives_the_same_frames_from_blocks_as_from_bytes) {
+    srand(1);
+    for (int i = 0; i < 300; i++) {
+        std::vector<uint8_t> frame(rand() % (i % 10 == 0 ? MAX_FRAME_SIZE + 10 : 40));
+        for (auto& b : frame) {
+            // mostly non-zero, for the long blocks
+            b = rand() % 8 == 0 ? 0 : rand();
+        }
+        byte_stuffer_send_frame(0, frame.data(), frame.size());
+        if (rand() % 5 == 0) {
+            // corrupt the stream now and then
+            sent_data[sent_data.size() - 1 - rand() % std::min<size_t>(sent_data.size(), 20)] = rand();
+        }
+    }
+
+    std::vector<std::vector<uint8_t>> by_byte;
+    received_frames = &by_byte;
+    for (auto& d : sent_data) {
+        byte_stuffer_recv_byte(1, d);
+    }
+
+    std::vector<std::vector<uint8_t>> by_block;
+    received_frames = &by_block;
+    std::vector<uint8_t> stream = sent_data;
+    for (size_t pos = 0; pos < stream.size();) {
+        size_t size = std::min<size_t>(1 + rand() % 64, stream.size() - pos);
+        byte_stuffer_recv_block(0, stream.data() + pos, size);
+        pos += size;
+    }
+    received_frames = nullptr;
+
+    EXPECT_GT(by_byte.size(), 200u);
+    EXPECT_EQ(by_block, by_byte);
+}
+
+TEST_F(ByteStuffer, benchmark_receiving) {
+    typedef std::chrono::steady_clock clock;
+    srand(2);
+    // frames the size of a matrix and of a long object
+    for (size_t frame_size : {20u, 200u}) {
+        std::vector<uint8_t> frame(frame_size);
+        for (auto& b : frame) {
+            b = rand();
+        }
+        sent_data.clear();
+        for (int i = 0; i < 64; i++) {
+            byte_stuffer_send_frame(0, frame.data(), frame.size());
+        }
+        const std::vector<uint8_t> stream = sent_data;
+        std::vector<uint8_t> block;
+        const unsigned iterations = 5000;
+        unsigned frames;
+        received_count = &frames;
+
+        auto report = [&](const char* name, clock::time_point start) {
+            double seconds = std::chrono::duration<double>(clock::now() - start).count();
+            std::cout << name << ", " << frame_size << " byte frames: "
+                << stream.size() * iterations / seconds / 1e6 << " MB/s" << std::endl;
+        };
+
+        frames = 0;
+        auto start = clock::now();
+        for (unsigned i = 0; i < iterations; i++) {
+            for (auto& d : stream) {
+                byte_stuffer_recv_byte(0, d);
+            }
+        }
+        report("byte by byte", start);
+        EXPECT_EQ(frames, 64 * iterations);
+
+        for (size_t block_size : {64u, 512u}) {
+            frames = 0;
+            start = clock::now();
+            for (unsigned i = 0; i < iterations; i++) {
+                block = stream;
+                for (size_t pos = 0; pos < block.size(); pos += block_size) {
+                    byte_stuffer_recv_block(0, block.data() + pos, std::min(block_size, block.size() - pos));
+                }
+            }
+            report(block_size == 64 ? "64 byte blocks" : "512 byte blocks", start);
+            EXPECT_EQ(frames, 64 * iterations);
+        }
+        received_count = nullptr;
+    }
+}
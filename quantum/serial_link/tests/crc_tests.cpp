@@ -0,0 +1,146 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+extern "C" {
+#include "serial_link/protocol/crc.h"
+}
+
+namespace {
+    typedef uint32_t (*crc32_t)(const uint8_t* data, uint32_t size);
+
+    const struct {
+        const char* name;
+        crc32_t crc;
+    } crc32_variants[] = {
+        {"bytewise", crc32_bytewise},
+        {"slicing4", crc32_slicing4},
+        {"slicing8", crc32_slicing8},
+    };
+
+    const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+
+    uint32_t crc32_bitwise(const uint8_t* data, uint32_t size) {
+        uint32_t crc = 0xFFFFFFFF;
+        while (size--) {
+            crc ^= *data++;
+            for (int i = 0; i < 8; i++) {
+                crc = (crc >> 1) ^ (crc & 1 ? 0xEDB88320 : 0);
+            }
+        }
+        return ~crc;
+    }
+
+    uint16_t crc16_bitwise(const uint8_t* data, uint32_t size) {
+        uint16_t crc = 0xFFFF;
+        while (size--) {
+            crc ^= *data++ << 8;
+            for (int i = 0; i < 8; i++) {
+                crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+            }
+        }
+        return crc;
+    }
+
+    std::vector<uint8_t> random_bytes(size_t size) {
+        std::vector<uint8_t> data(size);
+        for (auto& b : data) {
+            b = rand();
+        }
+        return data;
+    }
+}
+
+TEST(Crc, crc32_check_values) {
+    for (auto& v : crc32_variants) {
+        EXPECT_EQ(v.crc(check, sizeof(check)), 0xCBF43926) << v.name;
+        EXPECT_EQ(v.crc(check, 0), 0u) << v.name;
+    }
+}
+
+TEST(Crc, crc16_check_value) {
+    EXPECT_EQ(crc16_ccitt(check, sizeof(check)), 0x29B1);
+    EXPECT_EQ(crc16_ccitt(check, 0), 0xFFFF);
+}
+
+TEST(Crc, the_table_is_the_crc32) {
+    srand(1);
+    std::vector<uint8_t> data = random_bytes(300);
+    for (uint32_t size = 0; size < data.size(); size++) {
+        EXPECT_EQ(crc32_bytewise(data.data(), size), crc32_bitwise(data.data(), size)) << size;
+    }
+}
+
+TEST(Crc, crc32_variants_match_the_table_at_all_lengths_and_alignments) {
+    srand(2);
+    std::vector<uint8_t> data = random_bytes(300);
+    for (auto& v : crc32_variants) {
+        for (uint32_t offset = 0; offset < 8; offset++) {
+            for (uint32_t size = 0; size + offset < data.size(); size++) {
+                const uint8_t* p = data.data() + offset;
+                ASSERT_EQ(v.crc(p, size), crc32_bytewise(p, size)) << v.name << " offset " << offset << " size " << size;
+            }
+        }
+    }
+}
+
+TEST(Crc, crc16_matches_the_bitwise_crc) {
+    srand(3);
+    std::vector<uint8_t> data = random_bytes(300);
+    for (uint32_t size = 0; size < data.size(); size++) {
+        ASSERT_EQ(crc16_ccitt(data.data(), size), crc16_bitwise(data.data(), size)) << size;
+    }
+}
+
+TEST(Crc, benchmark) {
+    typedef std::chrono::steady_clock clock;
+    srand(4);
+    // a matrix snapshot sized frame, and a long stream
+    for (uint32_t size : {16u, 4096u}) {
+        std::vector<uint8_t> data = random_bytes(size);
+        const uint32_t bytes = 64 * 1024 * 1024;
+        const uint32_t iterations = bytes / size;
+        volatile uint32_t sink = 0;
+        auto report = [&](const char* name, clock::time_point start) {
+            double seconds = std::chrono::duration<double>(clock::now() - start).count();
+            std::cout << name << " " << size << " byte frames: " << bytes / seconds / 1e6 << " MB/s" << std::endl;
+        };
+        for (auto& v : crc32_variants) {
+            auto start = clock::now();
+            for (uint32_t i = 0; i < iterations; i++) {
+                sink = sink + v.crc(data.data(), size);
+            }
+            report(v.name, start);
+        }
+        auto start = clock::now();
+        for (uint32_t i = 0; i < iterations; i++) {
+            sink = sink + crc16_ccitt(data.data(), size);
+        }
+        report("crc16", start);
+    }
+}
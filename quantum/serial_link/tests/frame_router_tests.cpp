@@ -87,7 +87,7 @@ public:
         std::vector<uint8_t> send_buffers[2];
     };
 
-    router_buffer router_buffers[8];
+    router_buffer router_buffers[12];
     router_buffer* current_router_buffer;
 
     static FrameRouter* Instance;
@@ -133,29 +133,61 @@ TEST_F(FrameRouter, master_broadcast_is_received_by_everyone) {
     EXPECT_EQ(router_buffers[2].send_buffers[UP_LINK].size(), 0);
 }
 
-TEST_F(FrameRouter, master_send_is_received_by_targets) {
+TEST_F(FrameRouter, master_send_is_received_by_target) {
     frame_buffer_t data;
     data.data = {0xAB, 0x70, 0x55, 0xBB};
     activate_router(0);
-    router_send_frame((1 << 1) | (1 << 2), (uint8_t*)&data, 4);
+    router_send_frame(2, (uint8_t*)&data, 4);
     EXPECT_GT(router_buffers[0].send_buffers[DOWN_LINK].size(), 0);
     EXPECT_EQ(router_buffers[0].send_buffers[UP_LINK].size(), 0);
 
+    EXPECT_CALL(*this, transport_recv_frame(_, _, _))
+        .Times(0);
     simulate_transport(0, 1);
     EXPECT_GT(router_buffers[1].send_buffers[DOWN_LINK].size(), 0);
     EXPECT_EQ(router_buffers[1].send_buffers[UP_LINK].size(), 0);
+    testing::Mock::VerifyAndClearExpectations(this);
 
     EXPECT_CALL(*this, transport_recv_frame(0, _, _))
         .With(Args<1, 2>(ElementsAreArray(data.data)));
     simulate_transport(1, 2);
-    EXPECT_GT(router_buffers[2].send_buffers[DOWN_LINK].size(), 0);
+    EXPECT_EQ(router_buffers[2].send_buffers[DOWN_LINK].size(), 0);
     EXPECT_EQ(router_buffers[2].send_buffers[UP_LINK].size(), 0);
+}
+
+TEST_F(FrameRouter, master_send_reaches_slaves_beyond_eight) {
+    frame_buffer_t data;
+    data.data = {0xAB, 0x70, 0x55, 0xBB};
+    activate_router(0);
+    router_send_frame(10, (uint8_t*)&data, 4);
+
+    EXPECT_CALL(*this, transport_recv_frame(_, _, _))
+        .Times(0);
+    for (uint8_t i = 1; i < 10; i++) {
+        simulate_transport(i - 1, i);
+        EXPECT_GT(router_buffers[i].send_buffers[DOWN_LINK].size(), 0);
+    }
+    testing::Mock::VerifyAndClearExpectations(this);
 
     EXPECT_CALL(*this, transport_recv_frame(0, _, _))
         .With(Args<1, 2>(ElementsAreArray(data.data)));
-    simulate_transport(2, 3);
-    EXPECT_GT(router_buffers[3].send_buffers[DOWN_LINK].size(), 0);
-    EXPECT_EQ(router_buffers[3].send_buffers[UP_LINK].size(), 0);
+    simulate_transport(9, 10);
+    EXPECT_EQ(router_buffers[10].send_buffers[DOWN_LINK].size(), 0);
+}
+
+TEST_F(FrameRouter, slave_beyond_eight_sends_to_master) {
+    frame_buffer_t data;
+    data.data = {0xAB, 0x70, 0x55, 0xBB};
+    activate_router(10);
+    router_send_frame(0, (uint8_t*)&data, 4);
+    for (uint8_t i = 10; i > 1; i--) {
+        simulate_transport(i, i - 1);
+        EXPECT_GT(router_buffers[i - 1].send_buffers[UP_LINK].size(), 0);
+    }
+
+    EXPECT_CALL(*this, transport_recv_frame(10, _, _))
+        .With(Args<1, 2>(ElementsAreArray(data.data)));
+    simulate_transport(1, 0);
 }
 
 TEST_F(FrameRouter, first_link_sends_to_master) {
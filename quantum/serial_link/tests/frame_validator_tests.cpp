@@ -26,6 +26,7 @@ SOFTWARE.
 #include "gmock/gmock.h"
 extern "C" {
 #include "serial_link/protocol/frame_validator.h"
+#include "serial_link/protocol/link_stats.h"
 }
 
 using testing::_;
@@ -36,6 +37,7 @@ class FrameValidator : public testing::Test {
 public:
     FrameValidator() {
         Instance = this;
+        init_link_stats();
     }
 
     ~FrameValidator() {
@@ -113,3 +115,24 @@ TEST_F(FrameValidator, sends_five_bytes_with_correct_crc) {
         .With(Args<1, 2>(ElementsAreArray(expected)));
     validator_send_frame(0, original, 5);
 }
+
+TEST_F(FrameValidator, counts_frames_and_crc_errors_per_link) {
+    uint8_t valid[] = {0x44, 0x04, 0x6A, 0xB3, 0xA3};
+    uint8_t invalid[] = {0x44, 0, 0, 0, 0};
+    uint8_t original[] = {0x44, 0, 0, 0, 0};
+    EXPECT_CALL(*this, route_incoming_frame(_, _, _))
+        .Times(2);
+    EXPECT_CALL(*this, byte_stuffer_send_frame(_, _, _));
+    validator_recv_frame(0, valid, 5);
+    validator_recv_frame(0, valid, 5);
+    validator_recv_frame(0, invalid, 5);
+    validator_recv_frame(1, invalid, 5);
+    validator_recv_frame(1, invalid, 2);
+    validator_send_frame(1, original, 1);
+    EXPECT_EQ(link_stats[0].frames_received, 2);
+    EXPECT_EQ(link_stats[0].crc_errors, 1);
+    EXPECT_EQ(link_stats[0].frames_sent, 0);
+    EXPECT_EQ(link_stats[1].frames_received, 0);
+    EXPECT_EQ(link_stats[1].crc_errors, 2);
+    EXPECT_EQ(link_stats[1].frames_sent, 1);
+}
@@ -0,0 +1,200 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "gtest/gtest.h"
+#include <cstdlib>
+#include <cstring>
+extern "C" {
+#include "serial_link/system/matrix_sync.h"
+}
+
+class MatrixSync : public testing::Test {
+public:
+    MatrixSync() {
+        matrix_sync_init_sender(&sender);
+        matrix_sync_init_receiver(&receiver);
+        memset(rows, 0, sizeof(rows));
+    }
+
+    matrix_sync_result_t scan() {
+        return matrix_sync_encode(&sender, rows, &delta);
+    }
+
+    void send_snapshot() {
+        matrix_snapshot_t snapshot;
+        matrix_sync_snapshot(&sender, &snapshot);
+        matrix_sync_apply_snapshot(&receiver, &snapshot);
+    }
+
+    void expect_in_sync() {
+        for (int i = 0; i < MATRIX_ROWS; i++) {
+            EXPECT_EQ(receiver.rows[i], rows[i]) << "row " << i;
+        }
+    }
+
+    matrix_sync_sender_t sender;
+    matrix_sync_receiver_t receiver;
+    matrix_row_t rows[MATRIX_ROWS];
+    matrix_delta_t delta;
+};
+
+TEST_F(MatrixSync, nothing_is_sent_without_changes) {
+    EXPECT_EQ(scan(), MATRIX_SYNC_NONE);
+    rows[1] = 1;
+    EXPECT_EQ(scan(), MATRIX_SYNC_DELTA);
+    EXPECT_EQ(scan(), MATRIX_SYNC_NONE);
+}
+
+TEST_F(MatrixSync, a_delta_has_the_changed_keys) {
+    rows[1] = 1 << 9;
+    rows[3] = 1 << 0;
+    EXPECT_EQ(scan(), MATRIX_SYNC_DELTA);
+    EXPECT_EQ(delta.seq, 1);
+    EXPECT_EQ(delta.count, 2);
+    EXPECT_EQ(delta.events[0].row, 1);
+    EXPECT_EQ(delta.events[0].col, 9 | MATRIX_SYNC_PRESSED);
+    EXPECT_EQ(delta.events[1].row, 3);
+    EXPECT_EQ(delta.events[1].col, 0 | MATRIX_SYNC_PRESSED);
+    rows[1] = 0;
+    EXPECT_EQ(scan(), MATRIX_SYNC_DELTA);
+    EXPECT_EQ(delta.seq, 2);
+    EXPECT_EQ(delta.count, 1);
+    EXPECT_EQ(delta.events[0].row, 1);
+    EXPECT_EQ(delta.events[0].col, 9);
+}
+
+TEST_F(MatrixSync, too_many_changes_need_a_snapshot) {
+    rows[0] = 0x7;
+    EXPECT_EQ(scan(), MATRIX_SYNC_SNAPSHOT);
+    EXPECT_EQ(scan(), MATRIX_SYNC_NONE);
+    send_snapshot();
+    expect_in_sync();
+    EXPECT_EQ(receiver.seq, 1);
+}
+
+TEST_F(MatrixSync, deltas_need_a_snapshot_first) {
+    rows[2] = 1;
+    scan();
+    EXPECT_FALSE(matrix_sync_apply_delta(&receiver, &delta));
+    EXPECT_EQ(receiver.rows[2], 0);
+    send_snapshot();
+    expect_in_sync();
+    rows[2] = 3;
+    scan();
+    EXPECT_TRUE(matrix_sync_apply_delta(&receiver, &delta));
+    expect_in_sync();
+}
+
+TEST_F(MatrixSync, a_missing_delta_needs_a_snapshot) {
+    send_snapshot();
+    rows[0] = 1;
+    scan();
+    rows[0] = 0;
+    scan();
+    EXPECT_FALSE(matrix_sync_apply_delta(&receiver, &delta));
+    EXPECT_FALSE(receiver.synced);
+    rows[1] = 2;
+    scan();
+    EXPECT_FALSE(matrix_sync_apply_delta(&receiver, &delta));
+    send_snapshot();
+    expect_in_sync();
+    rows[1] = 0;
+    scan();
+    EXPECT_TRUE(matrix_sync_apply_delta(&receiver, &delta));
+    expect_in_sync();
+}
+
+TEST_F(MatrixSync, a_delta_after_the_snapshot_that_has_it_is_ignored) {
+    send_snapshot();
+    rows[0] = 1;
+    scan();
+    send_snapshot();
+    EXPECT_TRUE(matrix_sync_apply_delta(&receiver, &delta));
+    EXPECT_TRUE(receiver.synced);
+    expect_in_sync();
+}
+
+TEST_F(MatrixSync, a_snapshot_after_the_next_delta_is_ignored) {
+    send_snapshot();
+    rows[0] = 1;
+    scan();
+    EXPECT_TRUE(matrix_sync_apply_delta(&receiver, &delta));
+    matrix_snapshot_t snapshot;
+    matrix_sync_snapshot(&sender, &snapshot);
+    rows[0] = 0;
+    scan();
+    EXPECT_TRUE(matrix_sync_apply_delta(&receiver, &delta));
+    matrix_sync_apply_snapshot(&receiver, &snapshot);
+    expect_in_sync();
+    EXPECT_EQ(receiver.seq, 2);
+}
+
+TEST_F(MatrixSync, sequence_numbers_wrap_around) {
+    send_snapshot();
+    for (int i = 0; i < 600; i++) {
+        rows[i % MATRIX_ROWS] ^= 1 << (i % MATRIX_COLS);
+        scan();
+        EXPECT_TRUE(matrix_sync_apply_delta(&receiver, &delta)) << i;
+    }
+    expect_in_sync();
+}
+
+TEST_F(MatrixSync, invalid_keys_need_a_snapshot) {
+    send_snapshot();
+    rows[0] = 1;
+    scan();
+    delta.events[0].col = MATRIX_COLS | MATRIX_SYNC_PRESSED;
+    EXPECT_FALSE(matrix_sync_apply_delta(&receiver, &delta));
+    EXPECT_FALSE(receiver.synced);
+}
+
+// The transport only keeps the latest delta until it's sent, drop some and
+// resynchronize like serial_link_update() does
+TEST_F(MatrixSync, resynchronizes_after_lost_deltas) {
+    srand(1);
+    unsigned lost = 0;
+    unsigned snapshots = 0;
+    bool resync = false;
+    for (int i = 0; i < 5000; i++) {
+        rows[rand() % MATRIX_ROWS] ^= 1 << (rand() % MATRIX_COLS);
+        if (rand() % 4 == 0) {
+            rows[rand() % MATRIX_ROWS] ^= 1 << (rand() % MATRIX_COLS);
+        }
+        matrix_sync_result_t result = scan();
+        if (result == MATRIX_SYNC_DELTA && rand() % 10 == 0) {
+            lost++;
+        } else if (result == MATRIX_SYNC_DELTA) {
+            resync |= !matrix_sync_apply_delta(&receiver, &delta);
+        }
+        if (resync || result == MATRIX_SYNC_SNAPSHOT) {
+            send_snapshot();
+            snapshots++;
+            resync = false;
+            expect_in_sync();
+        }
+    }
+    EXPECT_GT(lost, 0u);
+    // a snapshot for every lost delta, and the scans that changed 3 keys
+    EXPECT_LT(snapshots, 2 * lost + 200);
+}
@@ -0,0 +1,321 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "gtest/gtest.h"
+#include <deque>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+extern "C" {
+#include "serial_link/protocol/transport.h"
+#include "serial_link/protocol/byte_stuffer.h"
+#include "serial_link/protocol/frame_validator.h"
+#include "serial_link/protocol/frame_router.h"
+#include "serial_link/protocol/link_stats.h"
+#include "serial_link/system/matrix_sync.h"
+#include "timer.h"
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+}
+
+// A master and its first slave connected through the real byte stuffer and
+// frame validator, with wires that drop and corrupt bytes. Both ends share the
+// transport, which works because they use different buffers and channels of
+// the objects, and different links.
+
+RELIABLE_MASTER_TO_SINGLE_SLAVE_OBJECT(leds, uint8_t);
+RELIABLE_SLAVE_TO_MASTER_OBJECT(slave_layers, uint32_t);
+MASTER_TO_SINGLE_SLAVE_OBJECT(unreliable_leds, uint8_t);
+// Like keyboard_matrix_delta of serial_link.c
+RELIABLE_SLAVE_TO_MASTER_OBJECT(matrix_delta, matrix_delta_t);
+
+static remote_object_t* test_remote_objects[] = {
+    REMOTE_OBJECT(leds),
+    REMOTE_OBJECT(slave_layers),
+    REMOTE_OBJECT(unreliable_leds),
+    REMOTE_OBJECT(matrix_delta),
+};
+
+class ReliableTransport : public testing::Test {
+public:
+    ReliableTransport() :
+        rng(1)
+    {
+        Instance = this;
+        set_time(0);
+        init_byte_stuffer();
+        init_link_stats();
+        add_remote_objects(test_remote_objects, sizeof(test_remote_objects) / sizeof(remote_object_t*));
+    }
+
+    ~ReliableTransport() {
+        Instance = nullptr;
+        reinitialize_serial_link_transport();
+    }
+
+    struct wire {
+        std::deque<uint8_t> bytes;
+        // Probabilities of losing a byte and of flipping bits of it
+        double drop_rate = 0;
+        double corrupt_rate = 0;
+        // Whole frames to lose, including their delimiter
+        unsigned drop_frames = 0;
+        unsigned corrupt_frames = 0;
+    };
+
+    void send_data(uint8_t link, const uint8_t* data, uint16_t size) {
+        std::copy(data, data + size, std::back_inserter(wires[link].bytes));
+    }
+
+    // Delivers the bytes sent on a link to the other end
+    void deliver(uint8_t link) {
+        wire& w = wires[link];
+        uint8_t receiving_link = link == UP_LINK ? DOWN_LINK : UP_LINK;
+        std::uniform_real_distribution<double> chance(0, 1);
+        while (!w.bytes.empty()) {
+            uint8_t byte = w.bytes.front();
+            w.bytes.pop_front();
+            if (w.drop_frames) {
+                if (byte == 0) {
+                    w.drop_frames--;
+                }
+                continue;
+            }
+            // The last byte of the frame is in the CRC, changing it to
+            // another non zero byte keeps the framing
+            if (w.corrupt_frames && byte != 0 && !w.bytes.empty() && w.bytes.front() == 0) {
+                byte = byte == 0x55 ? 0xAA : 0x55;
+                w.corrupt_frames--;
+            }
+            if (chance(rng) < w.drop_rate) {
+                continue;
+            }
+            if (chance(rng) < w.corrupt_rate) {
+                byte ^= 1 << (rng() % 8);
+            }
+            byte_stuffer_recv_byte(receiving_link, byte);
+        }
+    }
+
+    // One millisecond of both ends running their serial threads
+    void step() {
+        update_transport();
+        deliver(DOWN_LINK);
+        deliver(UP_LINK);
+        advance_time(1);
+    }
+
+    // Runs until the read returns the expected value, and returns how long
+    // it took, or -1 if it didn't arrive within the timeout
+    template<typename T, typename Read>
+    int wait_for(Read read, T expected, int timeout = 200) {
+        for (int time = 0; time < timeout; time++) {
+            step();
+            T* value = read();
+            if (value && *value == expected) {
+                return time;
+            }
+        }
+        return -1;
+    }
+
+    int send_leds(uint8_t leds) {
+        *begin_write_leds(0) = leds;
+        end_write_leds(0);
+        return wait_for<uint8_t>(read_leds, leds);
+    }
+
+    int send_slave_layers(uint32_t layers) {
+        *begin_write_slave_layers() = layers;
+        end_write_slave_layers();
+        return wait_for<uint32_t>([]() { return read_slave_layers(0); }, layers);
+    }
+
+    wire wires[NUM_LINKS];
+    std::mt19937 rng;
+
+    static ReliableTransport* Instance;
+};
+
+ReliableTransport* ReliableTransport::Instance = nullptr;
+
+extern "C" {
+void send_data(uint8_t link, const uint8_t* data, uint16_t size) {
+    ReliableTransport::Instance->send_data(link, data, size);
+}
+
+void signal_data_written(void) {
+}
+
+// The master is at the top of the down link and the slave at the bottom of
+// the up link, so that the link tells which end sends or receives
+void router_send_frame(uint8_t destination, uint8_t* data, uint16_t size) {
+    if (destination == 0) {
+        data[size] = 1;
+        validator_send_frame(UP_LINK, data, size + 1);
+    }
+    else {
+        data[size] = destination;
+        validator_send_frame(DOWN_LINK, data, size + 1);
+    }
+}
+
+void route_incoming_frame(uint8_t link, uint8_t* data, uint16_t size) {
+    if (link == DOWN_LINK) {
+        transport_recv_frame(data[size-1], data, size - 1);
+    }
+    else if (data[size-1] == 1) {
+        transport_recv_frame(0, data, size - 1);
+    }
+}
+}
+
+TEST_F(ReliableTransport, delivers_without_retransmits_on_a_clean_link) {
+    EXPECT_EQ(send_leds(5), 0);
+    EXPECT_EQ(send_slave_layers(0x10002), 0);
+    for (int i = 0; i < 20; i++) {
+        step();
+    }
+    EXPECT_FALSE(transport_retransmit_pending());
+    EXPECT_EQ(link_stats[DOWN_LINK].frames_sent, 2);
+    EXPECT_EQ(link_stats[UP_LINK].frames_sent, 2);
+    EXPECT_EQ(link_stats[DOWN_LINK].retransmits, 0);
+    EXPECT_EQ(link_stats[UP_LINK].retransmits, 0);
+}
+
+TEST_F(ReliableTransport, recovers_a_dropped_frame) {
+    wires[DOWN_LINK].drop_frames = 1;
+    EXPECT_EQ(send_leds(5), SERIAL_LINK_RETRANSMIT_TIMEOUT);
+    EXPECT_EQ(link_stats[DOWN_LINK].retransmits, 1);
+    EXPECT_EQ(link_stats[UP_LINK].crc_errors, 0);
+}
+
+TEST_F(ReliableTransport, recovers_a_corrupted_frame) {
+    wires[UP_LINK].corrupt_frames = 1;
+    EXPECT_EQ(send_slave_layers(0x10002), SERIAL_LINK_RETRANSMIT_TIMEOUT);
+    EXPECT_EQ(link_stats[DOWN_LINK].crc_errors, 1);
+    EXPECT_EQ(link_stats[UP_LINK].retransmits, 1);
+}
+
+TEST_F(ReliableTransport, lost_acknowledgement_does_not_deliver_twice) {
+    EXPECT_EQ(send_leds(1), 0);
+    step();
+    wires[UP_LINK].drop_frames = 1;
+    EXPECT_EQ(send_leds(2), 0);
+    EXPECT_TRUE(transport_retransmit_pending());
+    for (int i = 0; i < SERIAL_LINK_RETRANSMIT_TIMEOUT * 2; i++) {
+        step();
+        EXPECT_EQ(read_leds(), nullptr);
+    }
+    EXPECT_FALSE(transport_retransmit_pending());
+    EXPECT_EQ(link_stats[DOWN_LINK].retransmits, 1);
+}
+
+TEST_F(ReliableTransport, unreliable_object_is_not_recovered) {
+    wires[DOWN_LINK].drop_frames = 1;
+    *begin_write_unreliable_leds(0) = 5;
+    end_write_unreliable_leds(0);
+    EXPECT_EQ(wait_for<uint8_t>(read_unreliable_leds, 5), -1);
+}
+
+TEST_F(ReliableTransport, lost_key_release_is_applied_without_a_snapshot) {
+    matrix_sync_sender_t sender;
+    matrix_sync_receiver_t receiver;
+    matrix_row_t rows[MATRIX_ROWS] = {};
+    matrix_sync_init_sender(&sender);
+    matrix_sync_init_receiver(&receiver);
+    matrix_snapshot_t snapshot;
+    matrix_sync_snapshot(&sender, &snapshot);
+    matrix_sync_apply_snapshot(&receiver, &snapshot);
+
+    auto scan = [&]() {
+        matrix_delta_t delta;
+        ASSERT_EQ(matrix_sync_encode(&sender, rows, &delta), MATRIX_SYNC_DELTA);
+        *begin_write_matrix_delta() = delta;
+        end_write_matrix_delta();
+    };
+    // Runs until the master has applied a delta, and returns how long it took
+    auto apply = [&]() {
+        for (int time = 0; time < 200; time++) {
+            step();
+            matrix_delta_t* delta = read_matrix_delta(0);
+            if (delta) {
+                EXPECT_TRUE(matrix_sync_apply_delta(&receiver, delta));
+                return time;
+            }
+        }
+        return -1;
+    };
+
+    rows[2] = 1 << 3;
+    scan();
+    EXPECT_EQ(apply(), 0);
+    EXPECT_EQ(receiver.rows[2], rows[2]);
+
+    // The release is the last change, no later delta would reveal the loss
+    wires[UP_LINK].drop_frames = 1;
+    rows[2] = 0;
+    scan();
+    EXPECT_EQ(apply(), SERIAL_LINK_RETRANSMIT_TIMEOUT);
+    EXPECT_EQ(receiver.rows[2], 0);
+    EXPECT_TRUE(receiver.synced);
+}
+
+TEST_F(ReliableTransport, gives_up_on_a_dead_link_and_resumes) {
+    wires[DOWN_LINK].drop_rate = 1;
+    EXPECT_EQ(send_leds(5), -1);
+    EXPECT_FALSE(transport_retransmit_pending());
+    EXPECT_EQ(link_stats[DOWN_LINK].retransmits, SERIAL_LINK_MAX_RETRANSMITS);
+
+    wires[DOWN_LINK].drop_rate = 0;
+    EXPECT_EQ(send_leds(6), 0);
+}
+
+TEST_F(ReliableTransport, recovery_latency_with_random_faults) {
+    for (double rate : {0.005, 0.01, 0.02}) {
+        init_link_stats();
+        for (auto& w : wires) {
+            w.drop_rate = rate;
+            w.corrupt_rate = rate;
+        }
+        std::vector<int> latencies;
+        for (uint32_t i = 1; i <= 250; i++) {
+            int latency = i % 2 ? send_leds(i) : send_slave_layers(i << 16);
+            ASSERT_GE(latency, 0) << "value " << i << " with error rate " << rate;
+            latencies.push_back(latency);
+        }
+        double mean = 0;
+        for (int l : latencies) {
+            mean += l;
+        }
+        mean /= latencies.size();
+        int max = *std::max_element(latencies.begin(), latencies.end());
+        std::cout << "byte error rate " << rate * 100 << "%: mean latency "
+            << mean << " ms, max " << max << " ms, "
+            << link_stats[DOWN_LINK].retransmits + link_stats[UP_LINK].retransmits
+            << " retransmits" << std::endl;
+        EXPECT_LE(max, SERIAL_LINK_RETRANSMIT_TIMEOUT * SERIAL_LINK_MAX_RETRANSMITS);
+    }
+}
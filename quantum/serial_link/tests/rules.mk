@@ -4,12 +4,23 @@ serial_link_byte_stuffer_SRC :=\
 
 serial_link_frame_validator_SRC := \
 	$(SERIAL_PATH)/tests/frame_validator_tests.cpp \
-	$(SERIAL_PATH)/protocol/frame_validator.c 
+	$(SERIAL_PATH)/protocol/frame_validator.c \
+	$(SERIAL_PATH)/protocol/crc.c \
+	$(SERIAL_PATH)/protocol/link_stats.c
+
+serial_link_frame_validator_slicing8_SRC := $(serial_link_frame_validator_SRC)
+serial_link_frame_validator_slicing8_DEFS := -DSERIAL_LINK_CRC_SLICING8
+
+serial_link_crc_SRC := \
+	$(SERIAL_PATH)/tests/crc_tests.cpp \
+	$(SERIAL_PATH)/protocol/crc.c
 
 serial_link_frame_router_SRC := \
 	$(SERIAL_PATH)/tests/frame_router_tests.cpp \
 	$(SERIAL_PATH)/protocol/byte_stuffer.c \
 	$(SERIAL_PATH)/protocol/frame_validator.c \
+	$(SERIAL_PATH)/protocol/crc.c \
+	$(SERIAL_PATH)/protocol/link_stats.c \
 	$(SERIAL_PATH)/protocol/frame_router.c
 
 serial_link_triple_buffered_object_SRC := \
@@ -19,4 +30,26 @@ serial_link_triple_buffered_object_SRC := \
 serial_link_transport_SRC := \
 	$(SERIAL_PATH)/tests/transport_tests.cpp \
 	$(SERIAL_PATH)/protocol/transport.c \
-	$(SERIAL_PATH)/protocol/triple_buffered_object.c 
+	$(SERIAL_PATH)/protocol/triple_buffered_object.c \
+	$(SERIAL_PATH)/protocol/link_stats.c \
+	$(TMK_PATH)/common/test/timer.c
+serial_link_transport_INC := $(TMK_PATH)/common
+
+serial_link_reliable_transport_SRC := \
+	$(SERIAL_PATH)/tests/reliable_transport_tests.cpp \
+	$(SERIAL_PATH)/protocol/transport.c \
+	$(SERIAL_PATH)/protocol/triple_buffered_object.c \
+	$(SERIAL_PATH)/protocol/byte_stuffer.c \
+	$(SERIAL_PATH)/protocol/frame_validator.c \
+	$(SERIAL_PATH)/protocol/crc.c \
+	$(SERIAL_PATH)/protocol/link_stats.c \
+	$(SERIAL_PATH)/system/matrix_sync.c \
+	$(TMK_PATH)/common/test/timer.c
+serial_link_reliable_transport_DEFS := -DNUM_SLAVES=1 -DMATRIX_ROWS=4 -DMATRIX_COLS=10
+serial_link_reliable_transport_INC := $(TMK_PATH)/common
+
+serial_link_matrix_sync_SRC := \
+	$(SERIAL_PATH)/tests/matrix_sync_tests.cpp \
+	$(SERIAL_PATH)/system/matrix_sync.c
+serial_link_matrix_sync_DEFS := -DMATRIX_ROWS=4 -DMATRIX_COLS=10
+serial_link_matrix_sync_INC := $(TMK_PATH)/common
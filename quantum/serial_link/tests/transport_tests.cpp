@@ -31,6 +31,11 @@ using testing::Args;
 
 extern "C" {
 #include "serial_link/protocol/transport.h"
+#include "serial_link/protocol/link_stats.h"
+#include "serial_link/protocol/frame_router.h"
+#include "timer.h"
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
 }
 
 struct test_object1 {
@@ -45,17 +50,23 @@ struct test_object2 {
 MASTER_TO_ALL_SLAVES_OBJECT(master_to_slave, test_object1);
 MASTER_TO_SINGLE_SLAVE_OBJECT(master_to_single_slave, test_object1);
 SLAVE_TO_MASTER_OBJECT(slave_to_master, test_object1);
+RELIABLE_MASTER_TO_SINGLE_SLAVE_OBJECT(reliable_master_to_single_slave, test_object1);
+RELIABLE_SLAVE_TO_MASTER_OBJECT(reliable_slave_to_master, test_object1);
 
 static remote_object_t* test_remote_objects[] = {
     REMOTE_OBJECT(master_to_slave),
     REMOTE_OBJECT(master_to_single_slave),
     REMOTE_OBJECT(slave_to_master),
+    REMOTE_OBJECT(reliable_master_to_single_slave),
+    REMOTE_OBJECT(reliable_slave_to_master),
 };
 
 class Transport : public testing::Test {
 public:
     Transport() {
         Instance = this;
+        set_time(0);
+        init_link_stats();
         add_remote_objects(test_remote_objects, sizeof(test_remote_objects) / sizeof(remote_object_t*));
     }
 
@@ -130,6 +141,20 @@ TEST_F(Transport, writes_from_slave_to_master) {
     EXPECT_EQ(obj2->test, 7);
 }
 
+TEST_F(Transport, ignores_slave_beyond_num_slaves) {
+    update_transport();
+    begin_write_slave_to_master()->test = 7;
+    EXPECT_CALL(*this, signal_data_written());
+    end_write_slave_to_master();
+    EXPECT_CALL(*this, router_send_frame(0));
+    update_transport();
+    transport_recv_frame(NUM_SLAVES + 1, sent_data.data(), sent_data.size());
+    transport_recv_frame(0, sent_data.data(), sent_data.size());
+    for (uint8_t i = 0; i < NUM_SLAVES; i++) {
+        EXPECT_EQ(read_slave_to_master(i), nullptr);
+    }
+}
+
 TEST_F(Transport, writes_from_master_to_single_slave) {
     update_transport();
     test_object1* obj = begin_write_master_to_single_slave(3);
@@ -186,3 +211,121 @@ TEST_F(Transport, ignores_object_with_size_too_big) {
     test_object1* obj2 = read_master_to_slave();
     EXPECT_EQ(obj2, nullptr);
 }
+
+TEST_F(Transport, reliable_object_is_resent_until_acknowledged) {
+    update_transport();
+    begin_write_reliable_master_to_single_slave(1)->test = 7;
+    EXPECT_CALL(*this, signal_data_written());
+    end_write_reliable_master_to_single_slave(1);
+    EXPECT_CALL(*this, router_send_frame(2));
+    update_transport();
+    ASSERT_EQ(sent_data.size(), sizeof(test_object1) + 2);
+    EXPECT_TRUE(transport_retransmit_pending());
+    std::vector<uint8_t> frame = sent_data;
+
+    advance_time(SERIAL_LINK_RETRANSMIT_TIMEOUT - 1);
+    EXPECT_CALL(*this, router_send_frame(_)).Times(0);
+    update_transport();
+    testing::Mock::VerifyAndClearExpectations(this);
+
+    advance_time(1);
+    sent_data.clear();
+    EXPECT_CALL(*this, router_send_frame(2));
+    update_transport();
+    EXPECT_EQ(sent_data, frame);
+    EXPECT_EQ(link_stats[DOWN_LINK].retransmits, 1);
+    testing::Mock::VerifyAndClearExpectations(this);
+
+    uint8_t ack[] = {frame[frame.size() - 2], (uint8_t)(3 | 0x80)};
+    transport_recv_frame(2, ack, 2);
+    EXPECT_FALSE(transport_retransmit_pending());
+    advance_time(SERIAL_LINK_RETRANSMIT_TIMEOUT);
+    EXPECT_CALL(*this, router_send_frame(_)).Times(0);
+    update_transport();
+}
+
+TEST_F(Transport, reliable_object_ignores_acknowledgement_of_other_slave) {
+    update_transport();
+    begin_write_reliable_master_to_single_slave(1)->test = 7;
+    EXPECT_CALL(*this, signal_data_written());
+    end_write_reliable_master_to_single_slave(1);
+    EXPECT_CALL(*this, router_send_frame(2));
+    update_transport();
+    uint8_t ack[] = {sent_data[sent_data.size() - 2], (uint8_t)(3 | 0x80)};
+    transport_recv_frame(1, ack, 2);
+    transport_recv_frame(NUM_SLAVES + 1, ack, 2);
+    EXPECT_TRUE(transport_retransmit_pending());
+}
+
+TEST_F(Transport, reliable_object_gives_up_after_max_retransmits) {
+    update_transport();
+    begin_write_reliable_slave_to_master()->test = 7;
+    EXPECT_CALL(*this, signal_data_written());
+    end_write_reliable_slave_to_master();
+    EXPECT_CALL(*this, router_send_frame(0))
+        .Times(SERIAL_LINK_MAX_RETRANSMITS + 1);
+    for (int i = 0; i < SERIAL_LINK_MAX_RETRANSMITS + 5; i++) {
+        update_transport();
+        advance_time(SERIAL_LINK_RETRANSMIT_TIMEOUT);
+    }
+    EXPECT_FALSE(transport_retransmit_pending());
+    EXPECT_EQ(link_stats[UP_LINK].retransmits, SERIAL_LINK_MAX_RETRANSMITS);
+}
+
+TEST_F(Transport, new_write_replaces_unacknowledged_object) {
+    update_transport();
+    begin_write_reliable_slave_to_master()->test = 7;
+    EXPECT_CALL(*this, signal_data_written()).Times(2);
+    end_write_reliable_slave_to_master();
+    EXPECT_CALL(*this, router_send_frame(0)).Times(2);
+    update_transport();
+    uint8_t first_seq = sent_data[sent_data.size() - 2];
+    begin_write_reliable_slave_to_master()->test = 8;
+    end_write_reliable_slave_to_master();
+    sent_data.clear();
+    update_transport();
+    EXPECT_NE(sent_data[sent_data.size() - 2], first_seq);
+    EXPECT_EQ(((test_object1*)sent_data.data())->test, 8);
+
+    uint8_t ack[] = {first_seq, (uint8_t)(4 | 0x80)};
+    transport_recv_frame(0, ack, 2);
+    EXPECT_TRUE(transport_retransmit_pending());
+    ack[0] = sent_data[sent_data.size() - 2];
+    transport_recv_frame(0, ack, 2);
+    EXPECT_FALSE(transport_retransmit_pending());
+}
+
+TEST_F(Transport, reliable_receiver_acknowledges_and_drops_repeated_frames) {
+    test_object1 obj = {7};
+    std::vector<uint8_t> frame((uint8_t*)&obj, (uint8_t*)&obj + sizeof(obj));
+    frame.push_back(5);
+    frame.push_back(4);
+    transport_recv_frame(3, frame.data(), frame.size());
+    EXPECT_EQ(read_reliable_slave_to_master(2)->test, 7);
+    EXPECT_CALL(*this, router_send_frame(3));
+    update_transport();
+    ASSERT_EQ(sent_data.size(), 2);
+    EXPECT_EQ(sent_data[0], 5);
+    EXPECT_EQ(sent_data[1], 4 | 0x80);
+    testing::Mock::VerifyAndClearExpectations(this);
+
+    // The acknowledgement was lost, the repeated frame is acknowledged again
+    transport_recv_frame(3, frame.data(), frame.size());
+    EXPECT_EQ(read_reliable_slave_to_master(2), nullptr);
+    EXPECT_CALL(*this, router_send_frame(3));
+    update_transport();
+    testing::Mock::VerifyAndClearExpectations(this);
+
+    // A sender that started over sends 0, which is always delivered
+    frame[frame.size() - 2] = 0;
+    transport_recv_frame(3, frame.data(), frame.size());
+    EXPECT_NE(read_reliable_slave_to_master(2), nullptr);
+}
+
+TEST_F(Transport, reliable_object_ignores_unreliable_frames) {
+    test_object1 obj = {7};
+    std::vector<uint8_t> frame((uint8_t*)&obj, (uint8_t*)&obj + sizeof(obj));
+    frame.push_back(4);
+    transport_recv_frame(3, frame.data(), frame.size());
+    EXPECT_EQ(read_reliable_slave_to_master(2), nullptr);
+}
@@ -0,0 +1,130 @@
+/* Copyright 2017
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+#include <vector>
+
+using testing::_;
+using testing::AnyNumber;
+using testing::InSequence;
+
+namespace {
+    struct recorded_event {
+        uint8_t row;
+        uint8_t col;
+        bool pressed;
+        uint16_t time;
+    };
+
+    std::vector<recorded_event> recorded_events;
+}
+
+extern "C" bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+    recorded_events.push_back({
+        record->event.key.row,
+        record->event.key.col,
+        record->event.pressed,
+        record->event.time
+    });
+    return true;
+}
+
+class KeyEventQueue : public TestFixture {
+public:
+    KeyEventQueue() {
+        recorded_events.clear();
+    }
+
+    void expect_event(size_t index, uint8_t col, uint8_t row, bool pressed, uint16_t time) {
+        ASSERT_LT(index, recorded_events.size());
+        EXPECT_EQ(recorded_events[index].row, row);
+        EXPECT_EQ(recorded_events[index].col, col);
+        EXPECT_EQ(recorded_events[index].pressed, pressed);
+        EXPECT_EQ(recorded_events[index].time, time);
+    }
+};
+
+TEST_F(KeyEventQueue, AllChangesOfAScanAreProcessedWithTheScanTime) {
+    TestDriver driver;
+    InSequence s;
+    press_key(0, 0);
+    press_key(1, 0);
+    press_key(0, 3);
+    uint16_t scan_time = timer_read() | 1;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_C)));
+    run_one_scan_loop();
+    ASSERT_EQ(recorded_events.size(), 3u);
+    expect_event(0, 0, 0, true, scan_time);
+    expect_event(1, 1, 0, true, scan_time);
+    expect_event(2, 0, 3, true, scan_time);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    clear_all_keys();
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    run_one_scan_loop();
+}
+
+TEST_F(KeyEventQueue, RollOrderAndTimestampsArePreserved) {
+    TestDriver driver;
+    InSequence s;
+    uint16_t times[4];
+
+    // A four key roll, each transition landing in a different scan
+    press_key(0, 0);
+    times[0] = timer_read() | 1;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    run_one_scan_loop();
+    idle_for(2);
+
+    press_key(1, 0);
+    times[1] = timer_read() | 1;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B)));
+    run_one_scan_loop();
+    idle_for(2);
+
+    // Release of A and press of C land in the same scan
+    release_key(0, 0);
+    press_key(0, 3);
+    times[2] = timer_read() | 1;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B, KC_C)));
+    run_one_scan_loop();
+
+    release_key(1, 0);
+    release_key(0, 3);
+    press_key(1, 3);
+    times[3] = timer_read() | 1;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_C)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_D)));
+    run_one_scan_loop();
+
+    ASSERT_EQ(recorded_events.size(), 7u);
+    expect_event(0, 0, 0, true, times[0]);
+    expect_event(1, 1, 0, true, times[1]);
+    expect_event(2, 0, 0, false, times[2]);
+    expect_event(3, 0, 3, true, times[2]);
+    expect_event(4, 1, 0, false, times[3]);
+    expect_event(5, 0, 3, false, times[3]);
+    expect_event(6, 1, 3, true, times[3]);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(1, 3);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
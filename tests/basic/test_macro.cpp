@@ -95,5 +95,8 @@ TEST_F(Macro, PlayASimpleMacro) {
         .AT_TIME(210);
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()))
         .AT_TIME(220);
+    // The macro is typed while the matrix keeps being scanned
     run_one_scan_loop();
+    EXPECT_EQ(timer_elapsed32(current_time), 1u);
+    idle_for(220);
 }
\ No newline at end of file
@@ -16,11 +16,63 @@
 
 #include "test_common.hpp"
 #include "action_tapping.h"
+#include <vector>
 
 using testing::_;
+using testing::AnyNumber;
+using testing::Invoke;
 using testing::InSequence;
 
-class Tapping : public TestFixture {};
+class Tapping : public TestFixture {
+protected:
+    struct typed_key {
+        uint8_t key;
+        uint8_t mods;
+    };
+
+    // Records the keys that are added by each report, and the mods they
+    // were sent with
+    void record_typed_keys(TestDriver& driver) {
+        typed.clear();
+        last = {};
+        EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber())
+            .WillRepeatedly(Invoke([this](report_keyboard_t& report) {
+                for (uint8_t key: report.keys) {
+                    if (key && std::find(std::begin(last.keys), std::end(last.keys), key) == std::end(last.keys)) {
+                        typed.push_back({key, report.mods});
+                    }
+                }
+                last = report;
+            }));
+    }
+
+    // The keys of rows 1 and 2, KC_E to KC_N and KC_Q to KC_Z
+    static uint8_t roll_col(int i) { return i % MATRIX_COLS; }
+    static uint8_t roll_row(int i) { return 1 + i / MATRIX_COLS; }
+    static uint8_t roll_keycode(int i) { return i < MATRIX_COLS ? KC_E + i : KC_Q + i - MATRIX_COLS; }
+
+    // Presses the keys one per scan, each released when the one `overlap`
+    // keys later is pressed
+    void roll(int count, int overlap) {
+        for (int i = 0; i < count + overlap; i++) {
+            if (i < count) press_key(roll_col(i), roll_row(i));
+            if (i >= overlap) release_key(roll_col(i - overlap), roll_row(i - overlap));
+            run_one_scan_loop();
+        }
+    }
+
+    void expect_rolled(size_t first, int count, uint8_t mods) {
+        ASSERT_EQ(typed.size(), first + count);
+        for (int i = 0; i < count; i++) {
+            EXPECT_EQ(typed[first + i].key, roll_keycode(i)) << "key " << i;
+            EXPECT_EQ(typed[first + i].mods, mods) << "key " << i;
+        }
+        EXPECT_EQ(last, report_keyboard_t{});
+    }
+
+    std::vector<typed_key> typed;
+    report_keyboard_t last;
+};
 
 TEST_F(Tapping, TapA_SHFT_T_KeyReportsKey) {
     TestDriver driver;
@@ -95,3 +147,67 @@ TEST_F(Tapping, ANewTapWithinTappingTermIsBuggy) {
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT))).Times(1);
     idle_for(TAPPING_TERM);
 }
+
+TEST_F(Tapping, RollOfPlainKeysIsTypedInOrder) {
+    TestDriver driver;
+    record_typed_keys(driver);
+
+    roll(20, 3);
+    expect_rolled(0, 20, 0);
+}
+
+TEST_F(Tapping, RollWithinTappingTermWaitsForTheModTap) {
+    TestDriver driver;
+    record_typed_keys(driver);
+
+    // the events of the taps wait in the buffer until the mod tap is
+    // settled, the other keys interrupted it, so it's a shift
+    const int taps = (WAITING_BUFFER_SIZE - 1) / 2;
+    press_key(7, 0);
+    run_one_scan_loop();
+    roll(taps, 1);
+    release_key(7, 0);
+    run_one_scan_loop();
+    idle_for(TAPPING_TERM);
+    expect_rolled(0, taps, MOD_BIT(KC_LSFT));
+}
+
+TEST_F(Tapping, OverflowingRollSettlesTheModTapAsHold) {
+    TestDriver driver;
+    record_typed_keys(driver);
+
+    // 20 keys while the mod tap is undecided don't fit in the buffer, none of
+    // them is lost
+    press_key(7, 0);
+    run_one_scan_loop();
+    roll(20, 2);
+    release_key(7, 0);
+    run_one_scan_loop();
+    idle_for(TAPPING_TERM);
+    expect_rolled(0, 20, MOD_BIT(KC_LSFT));
+}
+
+TEST_F(Tapping, RollsAfterOverflowTapAgain) {
+    TestDriver driver;
+    record_typed_keys(driver);
+
+    press_key(7, 0);
+    run_one_scan_loop();
+    roll(WAITING_BUFFER_SIZE + 4, 1);
+    release_key(7, 0);
+    run_one_scan_loop();
+    idle_for(TAPPING_TERM + 1);
+    expect_rolled(0, WAITING_BUFFER_SIZE + 4, MOD_BIT(KC_LSFT));
+
+    // the mod tap is a tap again afterwards
+    typed.clear();
+    press_key(7, 0);
+    run_one_scan_loop();
+    release_key(7, 0);
+    run_one_scan_loop();
+    roll(20, 2);
+    ASSERT_EQ(typed.size(), 21u);
+    EXPECT_EQ(typed[0].key, KC_P);
+    typed.erase(typed.begin());
+    expect_rolled(0, 20, 0);
+}
@@ -0,0 +1,182 @@
+/* Copyright 2017 Fred Sundvik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Also built with an index that is too small as the combo_linear test, which
+// takes the path that searches every combo, so the benchmark output of the
+// two can be compared.
+
+#include "test_common.hpp"
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using testing::_;
+using testing::AnyNumber;
+using testing::AtLeast;
+using testing::InSequence;
+
+namespace {
+    const uint16_t ab_combo[] = {KC_A, KC_B, COMBO_END};
+    const uint16_t cde_combo[] = {KC_C, KC_D, KC_E, COMBO_END};
+
+    void set_combos(const std::vector<combo_t>& combos) {
+        combo_count = combos.size();
+        std::copy(combos.begin(), combos.end(), key_combos);
+        combo_index_rebuild();
+    }
+}
+
+class Combo : public TestFixture {
+public:
+    Combo() {
+        set_combos({
+            COMBO(ab_combo, KC_ESC),
+            COMBO(cde_combo, KC_TAB),
+        });
+    }
+};
+
+TEST_F(Combo, ComboKeysPressedTogetherSendTheComboKeycode) {
+    TestDriver driver;
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    press_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_ESC)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(0, 0);
+    release_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, ThreeKeyComboInOneScan) {
+    TestDriver driver;
+    press_key(2, 0);
+    press_key(3, 0);
+    press_key(4, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_TAB)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(2, 0);
+    release_key(3, 0);
+    release_key(4, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, ComboKeyTappedAloneIsSentOnRelease) {
+    TestDriver driver;
+    InSequence s;
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    idle_for(10);
+
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A))).Times(AtLeast(1));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, ComboKeyHeldAloneIsSentAfterTheComboTerm) {
+    TestDriver driver;
+    // a combo timer of 0 means it isn't running
+    idle_for(10);
+    press_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    idle_for(COMBO_TERM - 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    idle_for(2);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, OtherKeysAreNotDelayed) {
+    TestDriver driver;
+    press_key(5, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_F)));
+    run_one_scan_loop();
+    release_key(5, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+// Not a pass/fail test: prints what process_combo() costs for a key that is
+// in no combo, which is most keys, and for a key that is in two of them,
+// with 10 to 200 two key combos. Reports aren't sent while timing.
+TEST_F(Combo, Benchmark) {
+    host_set_driver(nullptr);
+    typedef std::chrono::steady_clock clock;
+    const unsigned iterations = 20000;
+    // combo i is (F1 + i % 100, F1 + (i + 1) % 100), so every key is in two
+    // combos for each 100 combos
+    static uint16_t keys[MAX_COMBOS][3];
+
+#if COMBO_INDEX_SIZE > 0
+    std::cout << "combo index enabled" << std::endl;
+#else
+    std::cout << "combo index disabled" << std::endl;
+#endif
+
+    for (unsigned count: {10, 25, 50, 100, 200}) {
+        std::vector<combo_t> combos;
+        for (unsigned i = 0; i < count; i++) {
+            keys[i][0] = KC_F1 + i % 100;
+            keys[i][1] = KC_F1 + (i + 1) % 100;
+            keys[i][2] = COMBO_END;
+            combos.push_back(COMBO(keys[i], KC_ESC));
+        }
+        set_combos(combos);
+
+        keyrecord_t record = {};
+        auto start = clock::now();
+        for (unsigned i = 0; i < iterations; i++) {
+            record.event.pressed = true;
+            process_combo(KC_A, &record);
+            record.event.pressed = false;
+            process_combo(KC_A, &record);
+        }
+        double other = std::chrono::duration<double, std::nano>(clock::now() - start).count() / (2 * iterations);
+
+        start = clock::now();
+        for (unsigned i = 0; i < iterations; i++) {
+            record.event.pressed = true;
+            record.event.time = timer_read();
+            process_combo(KC_F1 + 5, &record);
+            record.event.pressed = false;
+            process_combo(KC_F1 + 5, &record);
+        }
+        double combo_key = std::chrono::duration<double, std::nano>(clock::now() - start).count() / (2 * iterations);
+
+        std::cout << count << " combos: " << other << " ns per other key event, "
+            << combo_key << " ns per combo key event" << std::endl;
+    }
+    clear_keyboard();
+    set_combos({});
+}
@@ -0,0 +1,36 @@
+/* Copyright 2017 Fred Sundvik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TESTS_COMBO_LINEAR_CONFIG_H_
+#define TESTS_COMBO_LINEAR_CONFIG_H_
+
+#define MATRIX_ROWS 4
+#define MATRIX_COLS 10
+
+#define COMBO_TERM 40
+
+// Like the combo test, but without room in the index, so every combo is
+// searched on every key event
+#define MAX_COMBOS 200
+#define COMBO_COUNT combo_count
+#define COMBO_INDEX_SIZE 0
+#ifdef __cplusplus
+extern "C" unsigned char combo_count;
+#else
+extern unsigned char combo_count;
+#endif
+
+#endif /* TESTS_COMBO_LINEAR_CONFIG_H_ */
@@ -0,0 +1,56 @@
+/* Copyright 2017 Fred Sundvik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+using testing::_;
+using testing::AnyNumber;
+
+class DynamicMacro : public TestFixture {
+public:
+    void tap(uint8_t col) {
+        press_key(col, 0);
+        run_one_scan_loop();
+        release_key(col, 0);
+        run_one_scan_loop();
+    }
+};
+
+TEST_F(DynamicMacro, LayersAreResolvedAgainAfterPlayback) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    // record a macro that switches layer 1 on, then switch it off again
+    tap(0);
+    tap(3);
+    EXPECT_TRUE(layer_state_is(1));
+    tap(1);
+    tap(3);
+    EXPECT_EQ(layer_state, 0u);
+
+    // playback switches layer 1 on, and restores the layers afterwards
+    tap(2);
+    EXPECT_EQ(layer_state, 0u);
+    keypos_t key = { .col = 4, .row = 0 };
+    EXPECT_EQ(layer_switch_get_layer(key), 0);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    press_key(4, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    run_one_scan_loop();
+    release_key(4, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
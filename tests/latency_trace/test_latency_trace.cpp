@@ -0,0 +1,110 @@
+/* Copyright 2017 Fred Sundvik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+extern "C" {
+#include "latency_trace.h"
+}
+
+using testing::_;
+using testing::AnyNumber;
+using testing::InSequence;
+
+class LatencyTrace : public TestFixture {
+public:
+    LatencyTrace() {
+        latency_trace_clear();
+    }
+
+    // the test timer has a resolution of 1 ms
+    static uint8_t bucket_of_ms(uint32_t ms) {
+        uint8_t bucket = 0;
+        for (uint32_t us = (ms * 1000) >> 5; us && bucket < LATENCY_TRACE_BUCKETS - 1; us >>= 1) {
+            bucket++;
+        }
+        return bucket;
+    }
+
+    static unsigned total(uint8_t stage) {
+        unsigned sum = 0;
+        for (uint8_t bucket = 0; bucket < LATENCY_TRACE_BUCKETS; bucket++) {
+            sum += latency_trace_count(stage, bucket);
+        }
+        return sum;
+    }
+};
+
+TEST_F(LatencyTrace, EveryStageOfAKeyPressIsCounted) {
+    TestDriver driver;
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    run_one_scan_loop();
+
+    EXPECT_EQ(latency_trace_count(LATENCY_MATRIX_SCAN, 0), 1);
+    EXPECT_EQ(latency_trace_count(LATENCY_ACTION_EXEC, 0), 1);
+    EXPECT_EQ(latency_trace_count(LATENCY_PROCESS_RECORD, 0), 1);
+    EXPECT_EQ(latency_trace_count(LATENCY_SEND_KEYBOARD, 0), 1);
+
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    for (uint8_t stage = 0; stage < LATENCY_STAGES; stage++) {
+        EXPECT_EQ(total(stage), 2u);
+    }
+}
+
+TEST_F(LatencyTrace, TapIsCountedWhenItIsResolved) {
+    TestDriver driver;
+    InSequence s;
+
+    press_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    idle_for(49);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_P)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+
+    // the press waited 50 ms for the tap to be decided
+    EXPECT_EQ(latency_trace_count(LATENCY_PROCESS_RECORD, bucket_of_ms(50)), 1);
+    EXPECT_EQ(latency_trace_count(LATENCY_SEND_KEYBOARD, bucket_of_ms(50)), 1);
+    EXPECT_EQ(latency_trace_count(LATENCY_PROCESS_RECORD, 0), 1);
+    EXPECT_EQ(total(LATENCY_ACTION_EXEC), 2u);
+}
+
+TEST_F(LatencyTrace, HistogramsCanBeReadAndClearedOverRawHid) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    press_key(0, 0);
+    run_one_scan_loop();
+
+    uint8_t packet[32] = { LATENCY_TRACE_RAW_HID_ID, LATENCY_SEND_KEYBOARD };
+    EXPECT_TRUE(latency_trace_raw_hid(packet, sizeof(packet)));
+    EXPECT_EQ(packet[0], LATENCY_TRACE_RAW_HID_ID);
+    EXPECT_EQ(packet[1], LATENCY_SEND_KEYBOARD);
+    EXPECT_EQ(packet[2], 1);
+    EXPECT_EQ(packet[3], 0);
+
+    uint8_t clear[32] = { LATENCY_TRACE_RAW_HID_ID, LATENCY_TRACE_RAW_HID_CLEAR };
+    EXPECT_TRUE(latency_trace_raw_hid(clear, sizeof(clear)));
+    EXPECT_EQ(total(LATENCY_SEND_KEYBOARD), 0u);
+
+    uint8_t other[32] = { 0x01 };
+    EXPECT_FALSE(latency_trace_raw_hid(other, sizeof(other)));
+}
@@ -0,0 +1,123 @@
+/* Copyright 2017 Fred Sundvik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h"
+
+// Layers 1 to 15 are transparent, except for KC_F1 + n - 1 on key (1, 0)
+// and, on layers 1 to 9, KC_1 + n - 1 on column n of row 0. Key (3, 9) is
+// KC_NO on layer 0 and transparent everywhere else, so resolving it walks
+// every active layer.
+
+#define ____ KC_TRNS
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+    [0] = {
+        {KC_A,  KC_B,  KC_C,  KC_D,  KC_E,  KC_F,  KC_G,  KC_H,  KC_I,  KC_J},
+        {KC_K,  KC_L,  KC_M,  KC_N,  KC_O,  KC_P,  KC_Q,  KC_R,  KC_S,  KC_T},
+        {KC_U,  KC_V,  KC_W,  KC_X,  KC_Y,  KC_Z,  KC_NO, KC_NO, KC_NO, KC_NO},
+        {KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO},
+    },
+    [1] = {
+        {____,   KC_1,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {KC_F1,  ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+    },
+    [2] = {
+        {____,   ____,   KC_2,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {KC_F2,  ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+    },
+    [3] = {
+        {____,   ____,   ____,   KC_3,   ____,   ____,   ____,   ____,   ____,  ____},
+        {KC_F3,  ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+    },
+    [4] = {
+        {____,   ____,   ____,   ____,   KC_4,   ____,   ____,   ____,   ____,  ____},
+        {KC_F4,  ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+    },
+    [5] = {
+        {____,   ____,   ____,   ____,   ____,   KC_5,   ____,   ____,   ____,  ____},
+        {KC_F5,  ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+    },
+    [6] = {
+        {____,   ____,   ____,   ____,   ____,   ____,   KC_6,   ____,   ____,  ____},
+        {KC_F6,  ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+    },
+    [7] = {
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   KC_7,   ____,  ____},
+        {KC_F7,  ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+    },
+    [8] = {
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   KC_8,  ____},
+        {KC_F8,  ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+    },
+    [9] = {
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  KC_9},
+        {KC_F9,  ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+    },
+    [10] = {
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {KC_F10, ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+    },
+    [11] = {
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {KC_F11, ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+    },
+    [12] = {
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {KC_F12, ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+    },
+    [13] = {
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {KC_F13, ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+    },
+    [14] = {
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {KC_F14, ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+    },
+    [15] = {
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {KC_F15, ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+        {____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,   ____,  ____},
+    },
+};
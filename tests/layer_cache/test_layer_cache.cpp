@@ -0,0 +1,188 @@
+/* Copyright 2017 Fred Sundvik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Also built without RESOLVED_LAYER_CACHE as the layer_cache_disabled test,
+// and with KEYMAP_BITMAP_ENABLE as the keymap_bitmap test, so the benchmark
+// output of them can be compared.
+
+#include "test_common.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+
+using testing::_;
+using testing::AnyNumber;
+
+namespace {
+    // Walk the keymap directly, the way layer_switch_get_layer does without
+    // the cache
+    uint8_t reference_layer(keypos_t key) {
+        uint32_t layers = layer_state | default_layer_state;
+        for (int8_t i = 31; i >= 0; i--) {
+            if ((layers & (1UL << i)) && keymap_key_to_keycode(i, key) != KC_TRNS) {
+                return i;
+            }
+        }
+        return 0;
+    }
+
+    void expect_all_keys_resolved() {
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                keypos_t key = { .col = col, .row = row };
+                ASSERT_EQ(layer_switch_get_layer(key), reference_layer(key))
+                    << "row " << (int)row << " col " << (int)col
+                    << " layer_state " << layer_state
+                    << " default_layer_state " << default_layer_state;
+            }
+        }
+    }
+}
+
+class LayerCache : public TestFixture {
+public:
+    ~LayerCache() {
+        TestDriver driver;
+        EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+        default_layer_set(0);
+    }
+};
+
+TEST_F(LayerCache, TopmostNonTransparentLayerIsUsed) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    layer_on(1);
+    layer_on(2);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    press_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_1)));
+    run_one_scan_loop();
+    release_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+
+    press_key(0, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_F2)));
+    run_one_scan_loop();
+    release_key(0, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    layer_off(1);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    press_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    run_one_scan_loop();
+    release_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(LayerCache, DefaultLayerIsUsed) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    default_layer_set(1UL << 3);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    press_key(3, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_3)));
+    run_one_scan_loop();
+    release_key(3, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(LayerCache, MatchesFullResolutionForRandomLayerChanges) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> layer(0, 17);
+    std::uniform_int_distribution<int> operation(0, 5);
+
+    for (int i = 0; i < 500; i++) {
+        // layers 16 and 17 don't exist in the keymap, and are left out
+        // of the resolution by keymap_key_to_keycode
+        uint8_t l = layer(rng) % 16;
+        switch (operation(rng)) {
+            case 0: layer_on(l); break;
+            case 1: layer_off(l); break;
+            case 2: layer_invert(l); break;
+            case 3: layer_move(l); break;
+            case 4: default_layer_set(1UL << l); break;
+            case 5: default_layer_xor(1UL << l); break;
+        }
+        expect_all_keys_resolved();
+        if (HasFatalFailure()) {
+            return;
+        }
+    }
+}
+
+// Not a pass/fail test: prints the cost of a scan that processes a key event,
+// with 4, 8 and 16 active layers to walk through, and the cost of a layer
+// change, which is where the cache does its work.
+TEST_F(LayerCache, Benchmark) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    const unsigned iterations = 20000;
+    typedef std::chrono::steady_clock clock;
+
+#ifdef RESOLVED_LAYER_CACHE
+    std::cout << "resolved layer cache enabled" << std::endl;
+#else
+    std::cout << "resolved layer cache disabled" << std::endl;
+#endif
+#ifdef KEYMAP_BITMAP_ENABLE
+    std::cout << "keymap bitmap enabled" << std::endl;
+#endif
+
+    auto start = clock::now();
+    for (unsigned i = 0; i < iterations; i++) {
+        run_one_scan_loop();
+    }
+    double idle = std::chrono::duration<double, std::nano>(clock::now() - start).count() / iterations;
+    std::cout << "idle scan: " << idle << " ns" << std::endl;
+
+    for (uint8_t layers: {4, 8, 16}) {
+        layer_state_set(((1UL << layers) - 1) & ~1UL);
+
+        start = clock::now();
+        for (unsigned i = 0; i < iterations; i++) {
+            press_key(9, 3);
+            run_one_scan_loop();
+            release_key(9, 3);
+            run_one_scan_loop();
+        }
+        double event = std::chrono::duration<double, std::nano>(clock::now() - start).count() / (2 * iterations);
+
+        start = clock::now();
+        for (unsigned i = 0; i < iterations; i++) {
+            layer_invert(layers - 1);
+        }
+        double change = std::chrono::duration<double, std::nano>(clock::now() - start).count() / iterations;
+
+        std::cout << (int)layers << " layers: " << event << " ns per scan with an event, "
+            << change << " ns per layer change" << std::endl;
+        layer_clear();
+    }
+}
@@ -0,0 +1,40 @@
+/* Copyright 2017 Fred Sundvik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h"
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+    [0] = {
+        {KC_A, KC_B, KC_C, KC_D, KC_E, KC_F, KC_G, KC_H},
+        {KC_LEAD, KC_X, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO},
+    },
+};
+
+const uint16_t PROGMEM leader_a[] = {KC_A, LEADER_END};
+const uint16_t PROGMEM leader_abcdefgh[] = {KC_A, KC_B, KC_C, KC_D, KC_E, KC_F, KC_G, KC_H, LEADER_END};
+const uint16_t PROGMEM leader_ac[] = {KC_A, KC_C, LEADER_END};
+const uint16_t PROGMEM leader_ad[] = {KC_A, KC_D, LEADER_END};
+const uint16_t PROGMEM leader_dd[] = {KC_D, KC_D, LEADER_END};
+const uint16_t PROGMEM leader_de[] = {KC_D, KC_E, LEADER_END};
+
+const leader_t PROGMEM leader_sequences[LEADER_COUNT] = {
+    LEADER_SEQ(leader_a, KC_1),
+    LEADER_SEQ(leader_abcdefgh, KC_2),
+    LEADER_SEQ_ACTION(leader_ac),
+    LEADER_SEQ_ACTION(leader_ad),
+    LEADER_SEQ(leader_dd, KC_3),
+    LEADER_SEQ(leader_de, KC_4),
+};
@@ -0,0 +1,183 @@
+/* Copyright 2017 Fred Sundvik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+#include <vector>
+
+using testing::_;
+using testing::AnyNumber;
+
+LEADER_EXTERNS();
+
+namespace {
+    std::vector<uint16_t> leader_events;
+}
+
+extern "C" void process_leader_event(uint16_t index) {
+    leader_events.push_back(index);
+}
+
+class Leader : public TestFixture {
+public:
+    Leader() {
+        leader_events.clear();
+    }
+
+    void tap(uint8_t col, uint8_t row) {
+        press_key(col, row);
+        run_one_scan_loop();
+        release_key(col, row);
+        run_one_scan_loop();
+        idle_for(10);
+    }
+
+    void lead() {
+        tap(0, 1);
+    }
+
+    // Only empty reports, from the releases of the swallowed keys
+    void expect_no_keys(TestDriver& driver) {
+        EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    }
+};
+
+TEST_F(Leader, TableIsSorted) {
+    for (int i = 1; i < LEADER_COUNT; i++) {
+        const uint16_t* a = leader_sequences[i - 1].keys;
+        const uint16_t* b = leader_sequences[i].keys;
+        while (*a == *b && *a != LEADER_END) {
+            a++;
+            b++;
+        }
+        EXPECT_LT(*a, *b) << "entries " << i - 1 << " and " << i;
+    }
+}
+
+TEST_F(Leader, SequenceFiresOnItsLastKey) {
+    TestDriver driver;
+    expect_no_keys(driver);
+    lead();
+    tap(3, 0);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    press_key(3, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_3)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    EXPECT_FALSE(leading);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(3, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    run_one_scan_loop();
+}
+
+TEST_F(Leader, ActionSequenceCallsProcessLeaderEvent) {
+    TestDriver driver;
+    expect_no_keys(driver);
+    lead();
+    tap(0, 0);
+    EXPECT_TRUE(leader_events.empty());
+    tap(2, 0);
+    ASSERT_EQ(leader_events.size(), 1u);
+    EXPECT_EQ(leader_events[0], 2u);
+    EXPECT_FALSE(leading);
+}
+
+TEST_F(Leader, SequenceThatStartsALongerOneFiresAtTheTimeout) {
+    TestDriver driver;
+    expect_no_keys(driver);
+    lead();
+    tap(0, 0);
+    EXPECT_TRUE(leading);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_1)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(LEADER_TIMEOUT);
+    EXPECT_FALSE(leading);
+}
+
+TEST_F(Leader, SequencesCanBeLongerThanFiveKeys) {
+    TestDriver driver;
+    expect_no_keys(driver);
+    lead();
+    for (uint8_t col = 0; col < 7; col++) {
+        tap(col, 0);
+    }
+    EXPECT_TRUE(leading);
+    // the keys kept for LEADER_DICTIONARY() don't overflow
+    EXPECT_EQ(leader_sequence_size, 5);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    press_key(7, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_2)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    EXPECT_FALSE(leading);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(7, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    run_one_scan_loop();
+}
+
+TEST_F(Leader, IncompleteSequenceDoesNothingAtTheTimeout) {
+    TestDriver driver;
+    expect_no_keys(driver);
+    lead();
+    tap(0, 0);
+    tap(1, 0);
+    idle_for(LEADER_TIMEOUT);
+    EXPECT_FALSE(leading);
+    EXPECT_TRUE(leader_events.empty());
+}
+
+TEST_F(Leader, UnknownKeyEndsTheSequenceRightAway) {
+    TestDriver driver;
+    expect_no_keys(driver);
+    lead();
+    tap(1, 0);
+    EXPECT_FALSE(leading);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // the next key is typed as usual
+    press_key(1, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    run_one_scan_loop();
+    release_key(1, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Leader, NoKeyIsIgnored) {
+    TestDriver driver;
+    expect_no_keys(driver);
+    lead();
+    tap(2, 1);
+    EXPECT_TRUE(leading);
+    tap(0, 0);
+    tap(2, 1);
+    EXPECT_TRUE(leading);
+    EXPECT_TRUE(leader_events.empty());
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_1)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(LEADER_TIMEOUT);
+    EXPECT_FALSE(leading);
+}
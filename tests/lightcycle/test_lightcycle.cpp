@@ -0,0 +1,198 @@
+/* Copyright 2017 Fred Sundvik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// keyboards/lightcycle/matrix.c scanning the model of lightcycle_sim.h
+
+#include "test_common.hpp"
+#include <iostream>
+
+extern "C" {
+#include "lightcycle_sim.h"
+extern uint8_t mcp23018_status;
+}
+
+using testing::_;
+using testing::AnyNumber;
+using testing::InSequence;
+
+namespace {
+    const uint8_t IOCON = 0x0A;
+    const uint8_t IODIRB = 0x01;
+    const uint8_t GPPUA = 0x0C;
+    const uint8_t SEQOP = 1 << 5;
+
+#if defined(MCP23018_BATCHED_SCAN)
+    // select and read in one transaction with a repeated start
+    const uint32_t STARTS_PER_ROW = 2;
+    const uint32_t BYTES_PER_ROW = 5;
+#else
+    // select, read with a new start, unselect
+    const uint32_t STARTS_PER_ROW = 4;
+    const uint32_t BYTES_PER_ROW = 10;
+#endif
+}
+
+class Lightcycle : public TestFixture {};
+
+TEST_F(Lightcycle, ExpanderIsInitialized) {
+    EXPECT_EQ(mcp23018_status, 0);
+    EXPECT_EQ(sim_mcp23018_register(IODIRB), 0xE0);
+    EXPECT_EQ(sim_mcp23018_register(GPPUA), 0xFF);
+#if defined(MCP23018_BATCHED_SCAN)
+    EXPECT_EQ(sim_mcp23018_register(IOCON) & SEQOP, SEQOP);
+#else
+    EXPECT_EQ(sim_mcp23018_register(IOCON) & SEQOP, 0);
+#endif
+}
+
+TEST_F(Lightcycle, KeysOfBothHandsAreReported) {
+    TestDriver driver;
+    InSequence s;
+
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    press_key(11, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_L)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // the outer columns of the last row are on PD3 and GPA1
+    press_key(0, 4);
+    press_key(11, 4);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_L, KC_1)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_L, KC_1, KC_2)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // releases are debounced
+    clear_all_keys();
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(DEBOUNCE - 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(2);
+}
+
+TEST_F(Lightcycle, ScanBusTraffic) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    // a held key keeps the matrix from going idle
+    press_key(6, 0);
+    run_one_scan_loop();
+    sim_clear_stats();
+    run_one_scan_loop();
+    EXPECT_EQ(sim_stats()->starts, STARTS_PER_ROW * MATRIX_ROWS);
+    EXPECT_EQ(sim_stats()->bytes, BYTES_PER_ROW * MATRIX_ROWS);
+    EXPECT_EQ(sim_stats()->nacks, 0u);
+
+    const uint32_t scans = 1000;
+    sim_clear_stats();
+    idle_for(scans);
+    uint32_t us = sim_stats()->busy_us / scans;
+    std::cout << "Benchmark: " << us << " us on the bus per scan, "
+        << 1000000 / us << " scans/s" << std::endl;
+
+    clear_all_keys();
+    idle_for(DEBOUNCE + 1);
+}
+
+#if defined(MATRIX_WAKE_ON_CHANGE)
+TEST_F(Lightcycle, IdleBusTraffic) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(DEBOUNCE + 1);
+    sim_clear_stats();
+    idle_for(1000);
+#if defined(MCP23018_INTA_INT6)
+    // nothing is scanned until INTA, but the expander is checked for
+    EXPECT_LE(sim_stats()->starts, 2u * (1000 / 256 + 1));
+#else
+    // one read of GPIOA per ms
+    EXPECT_EQ(sim_stats()->starts, 2u * 1000);
+    EXPECT_EQ(sim_stats()->bytes, 4u * 1000);
+#endif
+    std::cout << "Benchmark: " << sim_stats()->busy_us / 1000
+        << " us on the bus per idle ms" << std::endl;
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // both hands wake the scan up
+    press_key(1, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_N)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    clear_all_keys();
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    idle_for(DEBOUNCE + 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // PD2, an external interrupt
+    press_key(10, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_W)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    clear_all_keys();
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    idle_for(DEBOUNCE + 1);
+}
+#endif
+
+TEST_F(Lightcycle, UnpluggedExpanderIsReset) {
+    TestDriver driver;
+    InSequence s;
+
+    // an idle matrix with INTA only checks the expander every 256 ms
+    sim_mcp23018_connect(false);
+    for (int i = 0; i < 256 && !mcp23018_status; i++) {
+        run_one_scan_loop();
+    }
+    EXPECT_NE(mcp23018_status, 0);
+
+    // the right hand keeps working
+    press_key(6, 0);
+    press_key(0, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_G)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // the expander lost its configuration, it's reset within 256 scans of
+    // being plugged back in, and no traffic is sent to it until then
+    sim_reset();
+    sim_clear_stats();
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(10);
+    EXPECT_EQ(sim_stats()->starts, 0u);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_G, KC_M)));
+    for (int i = 0; i < 256 && mcp23018_status; i++) {
+        run_one_scan_loop();
+    }
+    EXPECT_EQ(mcp23018_status, 0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+#if defined(MCP23018_BATCHED_SCAN)
+    EXPECT_EQ(sim_mcp23018_register(IOCON) & SEQOP, SEQOP);
+#endif
+
+    clear_all_keys();
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    idle_for(DEBOUNCE + 1);
+}
@@ -0,0 +1,25 @@
+# Copyright 2017 Fred Sundvik
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# The matrix of keyboards/lightcycle, on a model of its hardware
+LIGHTCYCLE_PATH = keyboards/lightcycle
+
+CUSTOM_MATRIX=yes
+DEBOUNCE_TYPE = asym_eager_defer_pk
+SRC += \
+	$(LIGHTCYCLE_PATH)/matrix.c \
+	$(LIGHTCYCLE_PATH)/lightcycle.c
+TEST_MATRIX_SRC = $(LIGHTCYCLE_PATH)/sim/lightcycle_sim.c
+VPATH += $(LIGHTCYCLE_PATH)/sim
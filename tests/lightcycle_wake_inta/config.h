@@ -0,0 +1,27 @@
+/* Copyright 2017 Fred Sundvik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TESTS_LIGHTCYCLE_WAKE_INTA_CONFIG_H_
+#define TESTS_LIGHTCYCLE_WAKE_INTA_CONFIG_H_
+
+#include "../../keyboards/lightcycle/config.h"
+
+// Scan only after a column changed while the matrix is idle, with INTA of
+// the expander on PE6
+#define MATRIX_WAKE_ON_CHANGE
+#define MCP23018_INTA_INT6
+
+#endif /* TESTS_LIGHTCYCLE_WAKE_INTA_CONFIG_H_ */
@@ -0,0 +1,49 @@
+/* Copyright 2017 Fred Sundvik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h"
+
+// The default lightcycle keymap in matrix order, with a layer tap on space,
+// a mod tap on escape and a combo, so a replay goes through all of them.
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+    [0] = {
+        {CTL_T(KC_ESC), KC_QUOT, KC_COMM, KC_DOT,  KC_P,    KC_Y,    KC_F,    KC_G,    KC_C,    KC_R,    KC_L,           KC_SLSH},
+        {KC_TAB,        KC_A,    KC_O,    KC_E,    KC_U,    KC_I,    KC_D,    KC_H,    KC_T,    KC_N,    KC_S,           KC_MINS},
+        {KC_LSFT,       KC_SCLN, KC_Q,    KC_J,    KC_K,    KC_X,    KC_B,    KC_M,    KC_W,    KC_V,    KC_Z,           KC_RSFT},
+        {KC_LCTL,       KC_LGUI, KC_LALT, KC_LEFT, KC_RGHT, KC_NO,   KC_NO,   KC_UP,   KC_DOWN, KC_LBRC, KC_RBRC,        KC_RALT},
+        {KC_NO,         KC_BSPC, MO(1),   KC_PGDN, KC_ENT,  KC_PGUP, KC_HOME, KC_DEL,  KC_END,  MO(2),   LT(1, KC_SPC),  KC_NO},
+    },
+    [1] = {
+        {KC_TRNS,       KC_F1,   KC_F2,   KC_F3,   KC_F4,   KC_TRNS, KC_TRNS, KC_7,    KC_8,    KC_9,    KC_MINS,        KC_TRNS},
+        {KC_TRNS,       KC_F5,   KC_F6,   KC_F7,   KC_F8,   KC_TRNS, KC_TRNS, KC_4,    KC_5,    KC_6,    KC_PLUS,        KC_TRNS},
+        {KC_TRNS,       KC_F9,   KC_F10,  KC_F11,  KC_F12,  KC_TRNS, KC_TRNS, KC_1,    KC_2,    KC_3,    KC_ASTR,        KC_TRNS},
+        {KC_TRNS,       KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_SLSH,        KC_TRNS},
+        {KC_TRNS,       KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS,        KC_0},
+    },
+    [2] = {
+        {KC_TRNS,       KC_EXLM, KC_AT,   KC_LCBR, KC_RCBR, KC_PIPE, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS,        KC_BSLS},
+        {KC_TRNS,       KC_HASH, KC_DLR,  KC_LPRN, KC_RPRN, KC_GRV,  KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS,        KC_TRNS},
+        {KC_TRNS,       KC_PERC, KC_CIRC, KC_LBRC, KC_RBRC, KC_TILD, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS,        KC_TRNS},
+        {KC_TRNS,       KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS,        KC_TRNS},
+        {KC_TRNS,       KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS,        KC_TRNS},
+    },
+};
+
+const uint16_t PROGMEM left_right_combo[] = {KC_LEFT, KC_RGHT, COMBO_END};
+
+combo_t key_combos[COMBO_COUNT] = {
+    COMBO(left_right_combo, KC_END),
+};
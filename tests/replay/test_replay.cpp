@@ -0,0 +1,225 @@
+/* Copyright 2017 Fred Sundvik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Replays key event traces through keyboard_task(), one scan per ms, and
+// collects the reports sent to the host. A trace is the console output of
+// a keyboard built with KEY_TRACE_ENABLE, see tmk_core/common/key_trace.h.
+// Run with REPLAY_TRACE=<file> to benchmark a recorded trace instead of the
+// one in this directory.
+
+#include "test_common.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "host.h"
+#include "key_trace.h"
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+}
+
+namespace {
+    struct trace_event {
+        uint32_t time;
+        uint8_t row;
+        uint8_t col;
+        bool pressed;
+    };
+
+    // Idle time between events is shortened to this once all keys are up,
+    // it's longer than any timeout of the firmware
+    const uint32_t max_gap = 1000;
+
+    std::vector<trace_event> load_trace(const std::string& path) {
+        std::vector<trace_event> trace;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            unsigned long time;
+            unsigned row, col, pressed;
+            if (line.compare(0, sizeof(KEY_TRACE_TAG) - 1, KEY_TRACE_TAG) != 0) {
+                continue;
+            }
+            if (sscanf(line.c_str() + sizeof(KEY_TRACE_TAG) - 1, "%lu,%u,%u,%u", &time, &row, &col, &pressed) != 4) {
+                std::cerr << "skipped: " << line << std::endl;
+                continue;
+            }
+            if (row >= MATRIX_ROWS || col >= MATRIX_COLS) {
+                std::cerr << "outside of the matrix: " << line << std::endl;
+                continue;
+            }
+            trace.push_back({(uint32_t)time, (uint8_t)row, (uint8_t)col, pressed != 0});
+        }
+        return trace;
+    }
+
+    std::vector<report_keyboard_t> reports;
+
+    uint8_t keyboard_leds(void) { return 0; }
+    void send_keyboard(report_keyboard_t *report) { reports.push_back(*report); }
+    void send_mouse(report_mouse_t *report) {}
+    void send_system(uint16_t data) {}
+    void send_consumer(uint16_t data) {}
+
+    host_driver_t replay_driver = {
+        keyboard_leds,
+        send_keyboard,
+        send_mouse,
+        send_system,
+        send_consumer,
+    };
+
+    // The text typed by the reports, for the keys used by typing.trace
+    std::string reports_to_text(const std::vector<report_keyboard_t>& reports) {
+        static const std::pair<uint8_t, char> chars[] = {
+            {KC_SPC, ' '}, {KC_DOT, '.'}, {KC_COMM, ','}, {KC_SCLN, ';'},
+            {KC_1, '1'}, {KC_2, '2'}, {KC_3, '3'}, {KC_4, '4'}, {KC_5, '5'},
+            {KC_6, '6'}, {KC_7, '7'}, {KC_8, '8'}, {KC_9, '9'}, {KC_0, '0'},
+        };
+        std::string text;
+        report_keyboard_t previous = {};
+        for (auto& report: reports) {
+            bool shift = report.mods & (MOD_BIT(KC_LSFT) | MOD_BIT(KC_RSFT));
+            for (uint8_t key: report.keys) {
+                if (!key) continue;
+                bool was_down = false;
+                for (uint8_t k: previous.keys) {
+                    was_down |= k == key;
+                }
+                if (was_down) continue;
+                if (key >= KC_A && key <= KC_Z) {
+                    text += (shift ? 'A' : 'a') + (key - KC_A);
+                    continue;
+                }
+                char c = '?';
+                for (auto& kc: chars) {
+                    if (kc.first == key) c = kc.second;
+                }
+                text += c;
+            }
+            previous = report;
+        }
+        return text;
+    }
+}
+
+class Replay : public TestFixture {
+public:
+    Replay() {
+        reports.clear();
+    }
+
+    // Replay the trace, returns the number of scans
+    uint32_t replay(const std::vector<trace_event>& trace) {
+        host_driver_t* previous_driver = host_get_driver();
+        host_set_driver(&replay_driver);
+        uint32_t scans = 0;
+        uint8_t keys_down = 0;
+        // trace time = firmware time + offset
+        uint32_t offset = trace.empty() ? 0 : trace[0].time - timer_read32();
+        size_t next = 0;
+        while (next < trace.size()) {
+            uint32_t now = timer_read32() + offset;
+            if (keys_down == 0 && trace[next].time > now + max_gap) {
+                offset = trace[next].time - max_gap - timer_read32();
+                now = timer_read32() + offset;
+            }
+            while (next < trace.size() && trace[next].time <= now) {
+                const trace_event& e = trace[next++];
+                if (e.pressed) {
+                    press_key(e.col, e.row);
+                    keys_down++;
+                } else {
+                    release_key(e.col, e.row);
+                    keys_down--;
+                }
+            }
+            keyboard_task();
+            advance_time(1);
+            scans++;
+        }
+        // let the timeouts run out
+        for (uint32_t i = 0; i < max_gap; i++) {
+            keyboard_task();
+            advance_time(1);
+            scans++;
+        }
+        host_set_driver(previous_driver);
+        return scans;
+    }
+
+    std::vector<trace_event> sample_trace() {
+        std::vector<trace_event> trace = load_trace("tests/replay/typing.trace");
+        EXPECT_EQ(trace.size(), 452u);
+        return trace;
+    }
+};
+
+TEST_F(Replay, SampleTraceTypesItsText) {
+    replay(sample_trace());
+    EXPECT_EQ(reports_to_text(reports),
+        "The quick brown fox jumps over the lazy dog. "
+        "Pack my box with five dozen liquor jugs, said Jim in 1984. "
+        "Sphinx of black quartz, judge my vow; the 42 wizards quickly jinxed 7 gnomes. "
+        "How vexingly quick daft zebras jump.");
+    ASSERT_FALSE(reports.empty());
+    EXPECT_EQ(reports.back().mods, 0);
+    for (uint8_t key: reports.back().keys) {
+        EXPECT_EQ(key, 0);
+    }
+}
+
+TEST_F(Replay, ReplayIsDeterministic) {
+    std::vector<trace_event> trace = sample_trace();
+    replay(trace);
+    std::vector<report_keyboard_t> first = reports;
+    reports.clear();
+    replay(trace);
+    ASSERT_EQ(reports.size(), first.size());
+    for (size_t i = 0; i < reports.size(); i++) {
+        EXPECT_EQ(memcmp(&reports[i], &first[i], sizeof(report_keyboard_t)), 0) << "report " << i;
+    }
+}
+
+// Not a pass/fail test: prints the throughput of the replay in key events
+// per second of CPU time, and the CPU time per event including the scans
+// between events.
+TEST_F(Replay, Benchmark) {
+    const char* path = getenv("REPLAY_TRACE");
+    std::vector<trace_event> trace = path ? load_trace(path) : sample_trace();
+    ASSERT_FALSE(trace.empty());
+    const unsigned repeat = path ? 1 : 20;
+    uint64_t scans = 0;
+
+    std::clock_t start = std::clock();
+    for (unsigned i = 0; i < repeat; i++) {
+        reports.clear();
+        scans += replay(trace);
+    }
+    double seconds = double(std::clock() - start) / CLOCKS_PER_SEC;
+    double events = double(trace.size()) * repeat;
+
+    std::cout << (path ? path : "typing.trace") << ": " << trace.size() << " events, "
+        << scans / repeat << " scans, " << reports.size() << " reports" << std::endl;
+    std::cout << events / seconds << " events/s, " << seconds * 1e9 / events << " ns CPU per event, "
+        << seconds * 1e9 / scans << " ns per scan" << std::endl;
+}
@@ -0,0 +1,65 @@
+/* Copyright 2017 Fred Sundvik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h"
+
+enum custom_keycodes {
+    STR_DELAY = SAFE_RANGE,
+    STR_FAST,
+    STR_LONG,
+};
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+    [0] = {
+        // 0    1      2          3         4         5      6           7             8        9
+        {KC_A,  KC_B,  STR_DELAY, STR_FAST, STR_LONG, M(0),  LSFT(KC_C), UC(0x2328),   KC_LSFT, KC_NO},
+        {KC_NO, KC_NO, KC_NO,     KC_NO,    KC_NO,    KC_NO, KC_NO,      KC_NO,        KC_NO,   KC_NO},
+        {KC_NO, KC_NO, KC_NO,     KC_NO,    KC_NO,    KC_NO, KC_NO,      KC_NO,        KC_NO,   KC_NO},
+        {KC_NO, KC_NO, KC_NO,     KC_NO,    KC_NO,    KC_NO, KC_NO,      KC_NO,        KC_NO,   KC_NO},
+    },
+};
+
+bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+    if (!record->event.pressed) {
+        return true;
+    }
+    switch (keycode) {
+        case STR_DELAY:
+            send_string_with_delay("xy", 10);
+            return false;
+        case STR_FAST:
+            send_string("xy");
+            return false;
+        case STR_LONG:
+            // longer than the queue
+            send_string_with_delay("abcdefghijklmnopqrstuvwxyz", 2);
+            return false;
+    }
+    return true;
+}
+
+const macro_t *action_get_macro(keyrecord_t *record, uint8_t id, uint8_t opt) {
+    if (record->event.pressed) {
+        switch(id) {
+        case 0:
+            return MACRO(D(LSFT), T(X), W(20), U(LSFT), END);
+        }
+    }
+    return MACRO_NONE;
+};
+
+void action_function(keyrecord_t *record, uint8_t id, uint8_t opt) {
+}
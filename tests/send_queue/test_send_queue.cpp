@@ -0,0 +1,236 @@
+/* Copyright 2017 Fred Sundvik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+#include <string>
+
+using testing::_;
+using testing::AnyNumber;
+using testing::InSequence;
+using testing::Invoke;
+
+class SendQueue : public TestFixture {};
+
+TEST_F(SendQueue, DelayedStringIsTypedWhileScanning) {
+    TestDriver driver;
+    InSequence s;
+    press_key(2, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    uint32_t start = timer_read32();
+    run_one_scan_loop();
+    EXPECT_EQ(timer_elapsed32(start), 1u);
+    EXPECT_TRUE(send_queue_busy());
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // A key pressed meanwhile is sent after the string
+    release_key(2, 0);
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(8);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Y)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(2);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(9);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    run_one_scan_loop();
+    EXPECT_FALSE(send_queue_busy());
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(SendQueue, StringWithoutDelayIsSentAtOnce) {
+    TestDriver driver;
+    InSequence s;
+    press_key(3, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Y)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    EXPECT_FALSE(send_queue_busy());
+    release_key(3, 0);
+    run_one_scan_loop();
+}
+
+TEST_F(SendQueue, StringLongerThanTheQueueIsTypedInOrder) {
+    TestDriver driver;
+    std::string typed;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).WillRepeatedly(Invoke([&typed](report_keyboard_t& report) {
+        if (report.keys[0]) {
+            typed += 'a' + report.keys[0] - KC_A;
+        }
+    }));
+    press_key(4, 0);
+    uint32_t start = timer_read32();
+    run_one_scan_loop();
+    // only waits until the rest fits into the queue
+    EXPECT_LT(timer_elapsed32(start), 26u * 2);
+    EXPECT_TRUE(send_queue_busy());
+    release_key(4, 0);
+    idle_for(26 * 2);
+    EXPECT_FALSE(send_queue_busy());
+    EXPECT_EQ(typed, "abcdefghijklmnopqrstuvwxyz");
+}
+
+TEST_F(SendQueue, MacroWaitIsTypedWhileScanning) {
+    TestDriver driver;
+    InSequence s;
+    press_key(5, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_X)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(5, 0);
+    press_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(18);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    idle_for(2);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(SendQueue, ModdedKeyPressedMeanwhileDoesNotShiftTheString) {
+    TestDriver driver;
+    InSequence s;
+    press_key(2, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // The shift of LSFT(KC_C) waits behind the string like the key itself
+    release_key(2, 0);
+    press_key(6, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(8);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Y)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(2);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(9);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_C)));
+    run_one_scan_loop();
+    EXPECT_FALSE(send_queue_busy());
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(6, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(SendQueue, ClearKeyboardWaitsForTheString) {
+    TestDriver driver;
+    InSequence s;
+    press_key(2, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    release_key(2, 0);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    clear_keyboard();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Y)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(2);
+    idle_for(20);
+    EXPECT_FALSE(send_queue_busy());
+}
+
+TEST_F(SendQueue, UnicodeIsTypedWhileScanningAndKeepsTheMods) {
+    TestDriver driver;
+    InSequence s;
+    press_key(8, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // The shift is lifted for the input of the code point
+    press_key(7, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT)));
+    uint32_t start = timer_read32();
+    run_one_scan_loop();
+    EXPECT_EQ(timer_elapsed32(start), 1u);
+    EXPECT_TRUE(send_queue_busy());
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // A second code point doesn't wait for the first one either
+    release_key(7, 0);
+    run_one_scan_loop();
+    press_key(7, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    start = timer_read32();
+    run_one_scan_loop();
+    EXPECT_EQ(timer_elapsed32(start), 1u);
+    release_key(7, 0);
+    idle_for(UNICODE_TYPE_DELAY - 3);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    for (int i = 0; i < 2; i++) {
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT, KC_2)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT, KC_3)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT, KC_2)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT, KC_8)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+        // the shift is back between the code points
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+        if (i == 0) {
+            EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+            EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT)));
+        }
+    }
+    idle_for(UNICODE_TYPE_DELAY * 2);
+    EXPECT_FALSE(send_queue_busy());
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(8, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
@@ -0,0 +1,56 @@
+/* Copyright 2017 Fred Sundvik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h"
+
+// The first row are dances 0-9, the second 30-39
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+    [0] = {
+        {TD(0),  TD(1),  TD(2),  TD(3),  TD(4),  TD(5),  TD(6),  TD(7),  TD(8),  TD(9)},
+        {TD(30), TD(31), TD(32), TD(33), TD(34), TD(35), TD(36), TD(37), TD(38), TD(39)},
+        {KC_A,   KC_B,   KC_C,   KC_D,   KC_E,   KC_F,   KC_G,   KC_H,   KC_I,   KC_J},
+        {KC_NO,  KC_NO,  KC_NO,  KC_NO,  KC_NO,  KC_NO,  KC_NO,  KC_NO,  KC_NO,  KC_NO},
+    },
+};
+
+#define PAIR(n) ACTION_TAP_DANCE_DOUBLE(KC_F1 + (n) % 12, KC_1 + (n) % 10)
+
+// Dance 1 has a shorter tapping term
+qk_tap_dance_action_t tap_dance_actions[TAP_DANCE_COUNT] = {
+    [0] = PAIR(0),
+    [1] = {
+        .fn = { NULL, qk_tap_dance_pair_finished, qk_tap_dance_pair_reset },
+        .user_data = (void *)&((qk_tap_dance_pair_t) { KC_F2, KC_2 }),
+        .custom_tapping_term = 100,
+    },
+    [2] = PAIR(2), [3] = PAIR(3), [4] = PAIR(4), [5] = PAIR(5),
+    [6] = PAIR(6), [7] = PAIR(7), [8] = PAIR(8), [9] = PAIR(9),
+    [10] = PAIR(10), [11] = PAIR(11), [12] = PAIR(12), [13] = PAIR(13),
+    [14] = PAIR(14), [15] = PAIR(15), [16] = PAIR(16), [17] = PAIR(17),
+    [18] = PAIR(18), [19] = PAIR(19), [20] = PAIR(20), [21] = PAIR(21),
+    [22] = PAIR(22), [23] = PAIR(23), [24] = PAIR(24), [25] = PAIR(25),
+    [26] = PAIR(26), [27] = PAIR(27), [28] = PAIR(28), [29] = PAIR(29),
+    [30] = PAIR(30), [31] = PAIR(31), [32] = PAIR(32), [33] = PAIR(33),
+    [34] = PAIR(34), [35] = PAIR(35), [36] = PAIR(36), [37] = PAIR(37),
+    [38] = PAIR(38), [39] = PAIR(39),
+};
+
+const macro_t *action_get_macro(keyrecord_t *record, uint8_t id, uint8_t opt) {
+    return MACRO_NONE;
+};
+
+void action_function(keyrecord_t *record, uint8_t id, uint8_t opt) {
+}
@@ -0,0 +1,168 @@
+/* Copyright 2017 Fred Sundvik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+#include <chrono>
+#include <iostream>
+
+extern "C" {
+#include "timeout.h"
+}
+
+using testing::_;
+using testing::AnyNumber;
+using testing::AtLeast;
+using testing::Sequence;
+
+class TapDance : public TestFixture {
+protected:
+    // taps the key and runs the scan of each event
+    void tap_key(uint8_t col, uint8_t row) {
+        press_key(col, row);
+        run_one_scan_loop();
+        release_key(col, row);
+        run_one_scan_loop();
+    }
+};
+
+TEST_F(TapDance, SingleTapFinishesAfterTappingTerm) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+
+    tap_key(0, 0);
+    idle_for(TAPPING_TERM - 2);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_F1)));
+    idle_for(2);
+}
+
+TEST_F(TapDance, DoubleTap) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_1)));
+    tap_key(0, 0);
+    tap_key(0, 0);
+    idle_for(TAPPING_TERM + 1);
+}
+
+TEST_F(TapDance, CustomTappingTerm) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+
+    tap_key(1, 0);
+    idle_for(100 - 2);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_F2)));
+    idle_for(2);
+}
+
+TEST_F(TapDance, HeldDanceIsResetOnRelease) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+
+    // a held dance finishes at its term, but stays registered
+    press_key(0, 0);
+    run_one_scan_loop();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_F1)));
+    idle_for(TAPPING_TERM + 1);
+    idle_for(TAPPING_TERM);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AtLeast(1));
+    release_key(0, 0);
+    run_one_scan_loop();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // and it dances again afterwards
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_1)));
+    tap_key(0, 0);
+    tap_key(0, 0);
+    idle_for(TAPPING_TERM + 1);
+}
+
+TEST_F(TapDance, OtherKeyInterrupts) {
+    TestDriver driver;
+    Sequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+
+    tap_key(9, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_F4))).InSequence(s);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A))).InSequence(s);
+    press_key(0, 2);
+    run_one_scan_loop();
+    release_key(0, 2);
+    run_one_scan_loop();
+}
+
+TEST_F(TapDance, OtherDanceInterrupts) {
+    TestDriver driver;
+    Sequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+
+    tap_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_F1))).InSequence(s);
+    tap_key(9, 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_F4))).InSequence(s);
+    idle_for(TAPPING_TERM + 1);
+}
+
+// Not a pass/fail test: prints what the timeouts cost per scan with 40
+// dances, when none of them is dancing and when the last one is.
+// Reports aren't sent while timing.
+TEST_F(TapDance, Benchmark) {
+    host_set_driver(nullptr);
+    typedef std::chrono::steady_clock clock;
+    const unsigned iterations = 100000;
+    keyrecord_t record = {};
+
+    // a dance that was used once
+    record.event.pressed = true;
+    process_tap_dance(TD(TAP_DANCE_COUNT - 1), &record);
+    record.event.pressed = false;
+    process_tap_dance(TD(TAP_DANCE_COUNT - 1), &record);
+    idle_for(TAPPING_TERM + 1);
+
+    auto start = clock::now();
+    for (unsigned i = 0; i < iterations; i++) {
+        timeout_task();
+    }
+    double idle = std::chrono::duration<double, std::nano>(clock::now() - start).count() / iterations;
+
+    record.event.pressed = true;
+    process_tap_dance(TD(TAP_DANCE_COUNT - 1), &record);
+    record.event.pressed = false;
+    process_tap_dance(TD(TAP_DANCE_COUNT - 1), &record);
+    start = clock::now();
+    for (unsigned i = 0; i < iterations; i++) {
+        timeout_task();
+    }
+    double dancing = std::chrono::duration<double, std::nano>(clock::now() - start).count() / iterations;
+
+    std::cout << TAP_DANCE_COUNT << " dances: " << idle << " ns per idle scan, "
+        << dancing << " ns per scan with one dance" << std::endl;
+    idle_for(TAPPING_TERM + 1);
+    clear_keyboard();
+}
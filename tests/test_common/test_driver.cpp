@@ -15,6 +15,9 @@
  */
 
 #include "test_driver.hpp"
+extern "C" {
+#include "latency_trace.h"
+}
 
 TestDriver* TestDriver::m_this = nullptr;
 
@@ -41,7 +44,8 @@ uint8_t TestDriver::keyboard_leds(void) {
 
 void TestDriver::send_keyboard(report_keyboard_t* report) {
     m_this->send_keyboard_mock(*report);
-
+    // where a protocol driver hands the report to its endpoint
+    latency_trace_send_keyboard();
 }
 
 void TestDriver::send_mouse(report_mouse_t* report) {
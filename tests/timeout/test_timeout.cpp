@@ -0,0 +1,149 @@
+/* Copyright 2017 Fred Sundvik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+#include <string>
+
+extern "C" {
+#include "timeout.h"
+    void advance_time(uint32_t ms);
+}
+
+using testing::_;
+using testing::AnyNumber;
+
+namespace {
+    std::string fired;
+    timeout_t a, b, c;
+
+    void fire_a(void) { fired += "a"; }
+    void fire_b(void) { fired += "b"; }
+    void fire_c(void) { fired += "c"; }
+    // starts itself again and cancels c
+    void fire_b_again(void) {
+        fired += "b";
+        timeout_start(&b, 0, fire_b);
+        timeout_cancel(&c);
+    }
+}
+
+class Timeout : public TestFixture {
+public:
+    Timeout() {
+        fired.clear();
+    }
+
+    ~Timeout() {
+        timeout_cancel(&a);
+        timeout_cancel(&b);
+        timeout_cancel(&c);
+    }
+};
+
+TEST_F(Timeout, CallbacksRunInDeadlineOrder) {
+    uint16_t ms;
+
+    timeout_start(&a, 30, fire_a);
+    timeout_start(&b, 10, fire_b);
+    timeout_start(&c, 20, fire_c);
+    EXPECT_TRUE(timeout_next(&ms));
+    EXPECT_EQ(ms, 10);
+
+    advance_time(9);
+    timeout_task();
+    EXPECT_EQ(fired, "");
+    advance_time(1);
+    timeout_task();
+    EXPECT_EQ(fired, "b");
+    EXPECT_FALSE(timeout_pending(&b));
+    EXPECT_TRUE(timeout_next(&ms));
+    EXPECT_EQ(ms, 10);
+
+    // all that are due run in one task
+    advance_time(30);
+    timeout_task();
+    EXPECT_EQ(fired, "bca");
+    EXPECT_FALSE(timeout_next(&ms));
+}
+
+TEST_F(Timeout, CancelledAndRestartedTimeouts) {
+    timeout_start(&a, 10, fire_a);
+    timeout_start(&b, 20, fire_b);
+    timeout_cancel(&a);
+    // restarting moves the deadline
+    timeout_start(&b, 5, fire_b);
+    advance_time(25);
+    timeout_task();
+    EXPECT_EQ(fired, "b");
+}
+
+TEST_F(Timeout, CallbacksChangeTheOtherDueTimeouts) {
+    timeout_start(&b, 10, fire_b_again);
+    timeout_start(&c, 10, fire_c);
+    advance_time(10);
+    timeout_task();
+    // c was cancelled before it ran, b started again runs on the next task
+    EXPECT_EQ(fired, "b");
+    EXPECT_TRUE(timeout_pending(&b));
+    timeout_task();
+    EXPECT_EQ(fired, "bb");
+}
+
+TEST_F(Timeout, OneshotModTimesOut) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+
+    press_key(0, 0);
+    run_one_scan_loop();
+    release_key(0, 0);
+    run_one_scan_loop();
+    EXPECT_EQ(get_oneshot_mods(), MOD_BIT(KC_LSFT));
+    idle_for(ONESHOT_TIMEOUT);
+    EXPECT_EQ(get_oneshot_mods(), 0);
+    uint16_t ms;
+    EXPECT_FALSE(timeout_next(&ms));
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    press_key(2, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    run_one_scan_loop();
+    release_key(2, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Timeout, OneshotLayerTimesOut) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+
+    press_key(1, 0);
+    run_one_scan_loop();
+    release_key(1, 0);
+    run_one_scan_loop();
+    EXPECT_TRUE(is_oneshot_layer_active());
+    idle_for(ONESHOT_TIMEOUT - 2);
+    EXPECT_TRUE(is_oneshot_layer_active());
+    idle_for(2);
+    EXPECT_FALSE(is_oneshot_layer_active());
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    press_key(3, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    run_one_scan_loop();
+    release_key(3, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
@@ -19,6 +19,8 @@ TMK_COMMON_SRC +=	$(COMMON_DIR)/host.c \
 	$(COMMON_DIR)/util.c \
 	$(COMMON_DIR)/eeconfig.c \
 	$(COMMON_DIR)/report.c \
+	$(COMMON_DIR)/send_queue.c \
+	$(COMMON_DIR)/timeout.c \
 	$(PLATFORM_COMMON_DIR)/suspend.c \
 	$(PLATFORM_COMMON_DIR)/timer.c \
 	$(PLATFORM_COMMON_DIR)/bootloader.c \
@@ -73,6 +75,16 @@ ifeq ($(strip $(COMMAND_ENABLE)), yes)
     TMK_COMMON_DEFS += -DCOMMAND_ENABLE
 endif
 
+ifeq ($(strip $(LATENCY_TRACE_ENABLE)), yes)
+    TMK_COMMON_SRC += $(COMMON_DIR)/latency_trace.c
+    TMK_COMMON_DEFS += -DLATENCY_TRACE_ENABLE
+endif
+
+ifeq ($(strip $(KEY_TRACE_ENABLE)), yes)
+    TMK_COMMON_SRC += $(COMMON_DIR)/key_trace.c
+    TMK_COMMON_DEFS += -DKEY_TRACE_ENABLE
+endif
+
 ifeq ($(strip $(NKRO_ENABLE)), yes)
     TMK_COMMON_DEFS += -DNKRO_ENABLE
 endif
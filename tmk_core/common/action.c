@@ -26,6 +26,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "action_macro.h"
 #include "action_util.h"
 #include "action.h"
+#include "latency_trace.h"
+#include "send_queue.h"
 #include "wait.h"
 
 #ifdef DEBUG_ACTION
@@ -49,6 +51,7 @@ void action_exec(keyevent_t event)
     if (!IS_NOEVENT(event)) {
         dprint("\n---- action_exec: start -----\n");
         dprint("EVENT: "); debug_event(event); dprintln();
+        latency_trace_action_exec(event.time);
 #ifdef RETRO_TAPPING
         retro_tapping_counter++;
 #endif
@@ -72,15 +75,6 @@ void action_exec(keyevent_t event)
 
     keyrecord_t record = { .event = event };
 
-#if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
-    if (has_oneshot_layer_timed_out()) {
-        clear_oneshot_layer_state(ONESHOT_OTHER_KEY_PRESSED);
-    }
-    if (has_oneshot_mods_timed_out()) {
-        clear_oneshot_mods();
-    }
-#endif
-
 #ifndef NO_ACTION_TAPPING
     action_tapping_process(record);
 #else
@@ -184,22 +178,20 @@ void process_action(keyrecord_t *record, action_t action)
                             // e.g. LSFT(KC_LGUI): we don't want the LSFT to be weak as it would make it useless.
                             // This also makes LSFT(KC_LGUI) behave exactly the same as LGUI(KC_LSFT).
                             // Same applies for some keys like KC_MEH which are declared as MEH(KC_NO).
-                            add_mods(mods);
+                            register_mods(mods);
                         } else {
-                            add_weak_mods(mods);
+                            register_weak_mods(mods);
                         }
-                        send_keyboard_report();
                     }
                     register_code(action.key.code);
                 } else {
                     unregister_code(action.key.code);
                     if (mods) {
                         if (IS_MOD(action.key.code) || action.key.code == KC_NO) {
-                            del_mods(mods);
+                            unregister_mods(mods);
                         } else {
-                            del_weak_mods(mods);
+                            unregister_weak_mods(mods);
                         }
-                        send_keyboard_report();
                     }
                 }
             }
@@ -477,6 +469,7 @@ void process_action(keyrecord_t *record, action_t action)
                         if (tap_count > 0) {
                             dprint("KEYMAP_TAP_KEY: Tap: unregister_code\n");
                             if (action.layer_tap.code == KC_CAPS) {
+                                host_keyboard_flush();
                                 wait_ms(80);
                             }
                             unregister_code(action.layer_tap.code);
@@ -647,6 +640,10 @@ void register_code(uint8_t code)
         return;
     }
 
+    else if (send_queue_defer(SEND_QUEUE_REGISTER, code)) {
+        return;
+    }
+
 #ifdef LOCKING_SUPPORT_ENABLE
     else if (KC_LOCKING_CAPS == code) {
 #ifdef LOCKING_RESYNC_ENABLE
@@ -655,6 +652,7 @@ void register_code(uint8_t code)
 #endif
         add_key(KC_CAPSLOCK);
         send_keyboard_report();
+        host_keyboard_flush();
         wait_ms(100);
         del_key(KC_CAPSLOCK);
         send_keyboard_report();
@@ -666,6 +664,7 @@ void register_code(uint8_t code)
 #endif
         add_key(KC_NUMLOCK);
         send_keyboard_report();
+        host_keyboard_flush();
         wait_ms(100);
         del_key(KC_NUMLOCK);
         send_keyboard_report();
@@ -677,6 +676,7 @@ void register_code(uint8_t code)
 #endif
         add_key(KC_SCROLLLOCK);
         send_keyboard_report();
+        host_keyboard_flush();
         wait_ms(100);
         del_key(KC_SCROLLLOCK);
         send_keyboard_report();
@@ -725,6 +725,10 @@ void unregister_code(uint8_t code)
         return;
     }
 
+    else if (send_queue_defer(SEND_QUEUE_UNREGISTER, code)) {
+        return;
+    }
+
 #ifdef LOCKING_SUPPORT_ENABLE
     else if (KC_LOCKING_CAPS == code) {
 #ifdef LOCKING_RESYNC_ENABLE
@@ -776,7 +780,7 @@ void unregister_code(uint8_t code)
 
 void register_mods(uint8_t mods)
 {
-    if (mods) {
+    if (mods && !send_queue_defer(SEND_QUEUE_REGISTER_MODS, mods)) {
         add_mods(mods);
         send_keyboard_report();
     }
@@ -784,20 +788,42 @@ void register_mods(uint8_t mods)
 
 void unregister_mods(uint8_t mods)
 {
-    if (mods) {
+    if (mods && !send_queue_defer(SEND_QUEUE_UNREGISTER_MODS, mods)) {
         del_mods(mods);
         send_keyboard_report();
     }
 }
 
+void register_weak_mods(uint8_t mods)
+{
+    if (mods && !send_queue_defer(SEND_QUEUE_REGISTER_WEAK_MODS, mods)) {
+        add_weak_mods(mods);
+        send_keyboard_report();
+    }
+}
+
+void unregister_weak_mods(uint8_t mods)
+{
+    if (mods && !send_queue_defer(SEND_QUEUE_UNREGISTER_WEAK_MODS, mods)) {
+        del_weak_mods(mods);
+        send_keyboard_report();
+    }
+}
+
 void clear_keyboard(void)
 {
+    if (send_queue_defer(SEND_QUEUE_CLEAR_KEYBOARD, 0)) {
+        return;
+    }
     clear_mods();
     clear_keyboard_but_mods();
 }
 
 void clear_keyboard_but_mods(void)
 {
+    if (send_queue_defer(SEND_QUEUE_CLEAR_KEYBOARD_BUT_MODS, 0)) {
+        return;
+    }
     clear_weak_mods();
     clear_macro_mods();
     clear_keys();
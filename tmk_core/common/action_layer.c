@@ -3,6 +3,7 @@
 #include "action.h"
 #include "util.h"
 #include "action_layer.h"
+#include "progmem.h"
 
 #ifdef DEBUG_ACTION
 #include "debug.h"
@@ -10,6 +11,11 @@
 #include "nodebug.h"
 #endif
 
+#if !defined(NO_ACTION_LAYER) && defined(RESOLVED_LAYER_CACHE)
+static void resolved_layer_cache_update(void);
+#else
+#define resolved_layer_cache_update()
+#endif
 
 /*
  * Default Layer State
@@ -28,6 +34,7 @@ static void default_layer_state_set(uint32_t state)
     default_layer_debug(); debug(" to ");
     default_layer_state = state;
     default_layer_debug(); debug("\n");
+    resolved_layer_cache_update();
     clear_keyboard_but_mods(); // To avoid stuck keys
 }
 
@@ -80,6 +87,7 @@ void layer_state_set(uint32_t state)
     layer_debug(); dprint(" to ");
     layer_state = state;
     layer_debug(); dprintln();
+    resolved_layer_cache_update();
     clear_keyboard_but_mods(); // To avoid stuck keys
 }
 
@@ -201,13 +209,37 @@ action_t store_or_get_action(bool pressed, keypos_t key)
 }
 
 
-int8_t layer_switch_get_layer(keypos_t key)
-{
 #ifndef NO_ACTION_LAYER
+#ifdef KEYMAP_BITMAP_ENABLE
+/*
+ * Generated at build time from keymaps[], see keymap_bitmap.mk. Bit n is set
+ * when the n-th keycode of keymaps[][MATRIX_ROWS][MATRIX_COLS] isn't KC_TRNS.
+ */
+extern const uint8_t keymap_bitmap[];
+extern const uint16_t keymap_bitmap_size;
+
+/* return the topmost layer in layers where key is not transparent, or fallback */
+static uint8_t resolve_layer(keypos_t key, uint32_t layers, uint8_t fallback)
+{
+    uint16_t key_index = key.row * MATRIX_COLS + key.col;
+
+    while (layers) {
+        uint8_t i = biton32(layers);
+        uint16_t bit = i * (MATRIX_ROWS * MATRIX_COLS) + key_index;
+        /* layers beyond the end of keymaps[] count as transparent */
+        if (bit < keymap_bitmap_size && (pgm_read_byte(&keymap_bitmap[bit / 8]) & (1 << (bit % 8)))) {
+            return i;
+        }
+        layers &= ~(1UL<<i);
+    }
+    return fallback;
+}
+#else
+/* return the topmost layer in layers where key is not transparent, or fallback */
+static uint8_t resolve_layer(keypos_t key, uint32_t layers, uint8_t fallback)
+{
     action_t action;
-    action.code = ACTION_TRANSPARENT;
 
-    uint32_t layers = layer_state | default_layer_state;
     /* check top layer first */
     for (int8_t i = 31; i >= 0; i--) {
         if (layers & (1UL<<i)) {
@@ -217,8 +249,76 @@ int8_t layer_switch_get_layer(keypos_t key)
             }
         }
     }
+    return fallback;
+}
+#endif
+#endif
+
+#if !defined(NO_ACTION_LAYER) && defined(RESOLVED_LAYER_CACHE)
+/*
+ * Resolved layer of every key for the layer state in resolved_layers_state.
+ * Both layer states start at 0, where every key resolves to layer 0, so the
+ * zero initialized table is valid from the start.
+ */
+static uint8_t resolved_layers[MATRIX_ROWS][MATRIX_COLS];
+static uint32_t resolved_layers_state = 0;
+
+/*
+ * Bring the table up to date with layer_state | default_layer_state. Only
+ * keys whose layer was switched off are resolved again from the top, the
+ * others only look at the newly enabled layers above their current one.
+ */
+static void resolved_layer_cache_update(void)
+{
+    uint32_t layers = layer_state | default_layer_state;
+    uint32_t added = layers & ~resolved_layers_state;
+    uint32_t removed = resolved_layers_state & ~layers;
+
+    resolved_layers_state = layers;
+    if (!added && !removed) {
+        return;
+    }
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            keypos_t key = { .col = col, .row = row };
+            uint8_t layer = resolved_layers[row][col];
+
+            if (removed & (1UL<<layer)) {
+                layer = resolve_layer(key, layers, 0);
+            } else {
+                uint32_t above = added & ~((2UL<<layer) - 1);
+                if (above) {
+                    layer = resolve_layer(key, above, layer);
+                }
+            }
+            resolved_layers[row][col] = layer;
+        }
+    }
+}
+
+void resolved_layer_cache_rebuild(void)
+{
+    resolved_layers_state = 0;
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            resolved_layers[row][col] = 0;
+        }
+    }
+    resolved_layer_cache_update();
+}
+#endif
+
+int8_t layer_switch_get_layer(keypos_t key)
+{
+#ifndef NO_ACTION_LAYER
+#ifdef RESOLVED_LAYER_CACHE
+    if (key.row < MATRIX_ROWS && key.col < MATRIX_COLS) {
+        return resolved_layers[key.row][key.col];
+    }
+#endif
     /* fall back to layer 0 */
-    return 0;
+    return resolve_layer(key, layer_state | default_layer_state, 0);
 #else
     return biton32(default_layer_state);
 #endif
@@ -94,6 +94,13 @@ uint32_t layer_state_set_kb(uint32_t state);
 void update_source_layers_cache(keypos_t key, uint8_t layer);
 uint8_t read_source_layers_cache(keypos_t key);
 #endif
+#if !defined(NO_ACTION_LAYER) && defined(RESOLVED_LAYER_CACHE)
+/* resolve all keys again, needed when the keymap itself changes at runtime */
+void resolved_layer_cache_rebuild(void);
+#else
+#define resolved_layer_cache_rebuild()
+#endif
+
 action_t store_or_get_action(bool pressed, keypos_t key);
 
 /* return the topmost non-transparent layer currently associated with key */
@@ -17,7 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "action.h"
 #include "action_util.h"
 #include "action_macro.h"
-#include "wait.h"
+#include "send_queue.h"
 
 #ifdef DEBUG_ACTION
 #include "debug.h"
@@ -41,8 +41,7 @@ void action_macro_play(const macro_t *macro_p)
                 MACRO_READ();
                 dprintf("KEY_DOWN(%02X)\n", macro);
                 if (IS_MOD(macro)) {
-                    add_macro_mods(MOD_BIT(macro));
-                    send_keyboard_report();
+                    send_queue_step(SEND_QUEUE_ADD_MACRO_MODS, MOD_BIT(macro));
                 } else {
                     register_code(macro);
                 }
@@ -51,8 +50,7 @@ void action_macro_play(const macro_t *macro_p)
                 MACRO_READ();
                 dprintf("KEY_UP(%02X)\n", macro);
                 if (IS_MOD(macro)) {
-                    del_macro_mods(MOD_BIT(macro));
-                    send_keyboard_report();
+                    send_queue_step(SEND_QUEUE_DEL_MACRO_MODS, MOD_BIT(macro));
                 } else {
                     unregister_code(macro);
                 }
@@ -60,7 +58,7 @@ void action_macro_play(const macro_t *macro_p)
             case WAIT:
                 MACRO_READ();
                 dprintf("WAIT(%u)\n", macro);
-                { uint8_t ms = macro; while (ms--) wait_ms(1); }
+                send_queue_wait(macro);
                 break;
             case INTERVAL:
                 interval = MACRO_READ();
@@ -79,7 +77,7 @@ void action_macro_play(const macro_t *macro_p)
                 return;
         }
         // interval
-        { uint8_t ms = interval; while (ms--) wait_ms(1); }
+        send_queue_wait(interval);
     }
 }
 #endif
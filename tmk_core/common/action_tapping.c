@@ -22,12 +22,32 @@
 
 
 static keyrecord_t tapping_key = {};
-static keyrecord_t waiting_buffer[WAITING_BUFFER_SIZE] = {};
+
+/* Waiting buffer
+ *
+ * The records are packed into the key index with the pressed flag, the time
+ * and two bits of the tap state: records only wait with a tap count of 0 or
+ * 1. That is 3 bytes and 2 bits instead of a keyrecord_t of 6 to 8 bytes.
+ */
+#if MATRIX_ROWS * MATRIX_COLS <= 128
+typedef uint8_t waiting_key_t;
+#else
+typedef uint16_t waiting_key_t;
+#endif
+#define WAITING_KEY_PRESSED     ((waiting_key_t)1 << (sizeof(waiting_key_t) * 8 - 1))
+#define WAITING_TAP_COUNT       1
+#define WAITING_TAP_INTERRUPTED 2
+
+static waiting_key_t waiting_buffer_key[WAITING_BUFFER_SIZE];
+static uint16_t waiting_buffer_time[WAITING_BUFFER_SIZE];
+static uint8_t waiting_buffer_tap[(WAITING_BUFFER_SIZE + 3) / 4];
 static uint8_t waiting_buffer_head = 0;
 static uint8_t waiting_buffer_tail = 0;
 
 static bool process_tapping(keyrecord_t *record);
+static void waiting_buffer_process(void);
 static bool waiting_buffer_enq(keyrecord_t record);
+static bool waiting_buffer_overflow(keyrecord_t record);
 static void waiting_buffer_clear(void);
 static bool waiting_buffer_typed(keyevent_t event);
 static bool waiting_buffer_has_anykey_pressed(void);
@@ -43,7 +63,7 @@ void action_tapping_process(keyrecord_t record)
             debug("processed: "); debug_record(record); debug("\n");
         }
     } else {
-        if (!waiting_buffer_enq(record)) {
+        if (!waiting_buffer_enq(record) && !waiting_buffer_overflow(record)) {
             // clear all in case of overflow.
             debug("OVERFLOW: CLEAR ALL STATES\n");
             clear_keyboard();
@@ -56,14 +76,7 @@ void action_tapping_process(keyrecord_t record)
     if (!IS_NOEVENT(record.event) && waiting_buffer_head != waiting_buffer_tail) {
         debug("---- action_exec: process waiting_buffer -----\n");
     }
-    for (; waiting_buffer_tail != waiting_buffer_head; waiting_buffer_tail = (waiting_buffer_tail + 1) % WAITING_BUFFER_SIZE) {
-        if (process_tapping(&waiting_buffer[waiting_buffer_tail])) {
-            debug("processed: waiting_buffer["); debug_dec(waiting_buffer_tail); debug("] = ");
-            debug_record(waiting_buffer[waiting_buffer_tail]); debug("\n\n");
-        } else {
-            break;
-        }
-    }
+    waiting_buffer_process();
     if (!IS_NOEVENT(record.event)) {
         debug("\n");
     }
@@ -291,6 +304,57 @@ bool process_tapping(keyrecord_t *keyp)
 /*
  * Waiting buffer
  */
+static keyrecord_t waiting_buffer_get(uint8_t i)
+{
+    waiting_key_t key = waiting_buffer_key[i];
+    uint8_t tap = waiting_buffer_tap[i / 4] >> (i % 4 * 2);
+    waiting_key_t index = key & ~WAITING_KEY_PRESSED;
+
+    return (keyrecord_t){
+        .event.key = (keypos_t){ .row = index / MATRIX_COLS, .col = index % MATRIX_COLS },
+        .event.pressed = key & WAITING_KEY_PRESSED,
+        .event.time = waiting_buffer_time[i],
+        .tap.count = tap & WAITING_TAP_COUNT,
+        .tap.interrupted = (tap & WAITING_TAP_INTERRUPTED) ? 1 : 0,
+    };
+}
+
+static void waiting_buffer_set(uint8_t i, keyrecord_t *record)
+{
+    uint8_t tap = (record->tap.count ? WAITING_TAP_COUNT : 0) |
+                  (record->tap.interrupted ? WAITING_TAP_INTERRUPTED : 0);
+
+    waiting_buffer_key[i] = (record->event.key.row * MATRIX_COLS + record->event.key.col) |
+                            (record->event.pressed ? WAITING_KEY_PRESSED : 0);
+    waiting_buffer_time[i] = record->event.time;
+    waiting_buffer_tap[i / 4] = (waiting_buffer_tap[i / 4] & ~(3 << (i % 4 * 2))) | (tap << (i % 4 * 2));
+}
+
+static bool waiting_buffer_pressed(uint8_t i)
+{
+    return waiting_buffer_key[i] & WAITING_KEY_PRESSED;
+}
+
+static bool waiting_buffer_keyeq(uint8_t i, keypos_t key)
+{
+    return (waiting_buffer_key[i] & ~WAITING_KEY_PRESSED) == key.row * MATRIX_COLS + key.col;
+}
+
+/* process the waiting records until one has to wait again */
+void waiting_buffer_process(void)
+{
+    for (; waiting_buffer_tail != waiting_buffer_head; waiting_buffer_tail = (waiting_buffer_tail + 1) % WAITING_BUFFER_SIZE) {
+        keyrecord_t record = waiting_buffer_get(waiting_buffer_tail);
+        if (process_tapping(&record)) {
+            debug("processed: waiting_buffer["); debug_dec(waiting_buffer_tail); debug("] = ");
+            debug_record(record); debug("\n\n");
+        } else {
+            waiting_buffer_set(waiting_buffer_tail, &record);
+            break;
+        }
+    }
+}
+
 bool waiting_buffer_enq(keyrecord_t record)
 {
     if (IS_NOEVENT(record.event)) {
@@ -302,13 +366,34 @@ bool waiting_buffer_enq(keyrecord_t record)
         return false;
     }
 
-    waiting_buffer[waiting_buffer_head] = record;
+    waiting_buffer_set(waiting_buffer_head, &record);
     waiting_buffer_head = (waiting_buffer_head + 1) % WAITING_BUFFER_SIZE;
 
     debug("waiting_buffer_enq: "); debug_waiting_buffer();
     return true;
 }
 
+/* The buffer is full while a tap key is pressed and undecided: settle it as
+ * a hold, as if TAPPING_TERM had passed, which makes room for the record.
+ * Returns false if the state has to be cleared instead. */
+bool waiting_buffer_overflow(keyrecord_t record)
+{
+#ifdef WAITING_BUFFER_OVERFLOW_CLEAR
+    return false;
+#else
+    if (!IS_TAPPING_PRESSED() || tapping_key.tap.count != 0) {
+        return false;
+    }
+
+    debug("OVERFLOW: Tapping: End. Hold.\n");
+    process_record(&tapping_key);
+    tapping_key = (keyrecord_t){};
+    debug_tapping_key();
+    waiting_buffer_process();
+    return waiting_buffer_enq(record);
+#endif
+}
+
 void waiting_buffer_clear(void)
 {
     waiting_buffer_head = 0;
@@ -318,7 +403,7 @@ void waiting_buffer_clear(void)
 bool waiting_buffer_typed(keyevent_t event)
 {
     for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = (i + 1) % WAITING_BUFFER_SIZE) {
-        if (KEYEQ(event.key, waiting_buffer[i].event.key) && event.pressed !=  waiting_buffer[i].event.pressed) {
+        if (waiting_buffer_keyeq(i, event.key) && event.pressed != waiting_buffer_pressed(i)) {
             return true;
         }
     }
@@ -329,7 +414,7 @@ __attribute__((unused))
 bool waiting_buffer_has_anykey_pressed(void)
 {
     for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = (i + 1) % WAITING_BUFFER_SIZE) {
-        if (waiting_buffer[i].event.pressed) return true;
+        if (waiting_buffer_pressed(i)) return true;
     }
     return false;
 }
@@ -343,11 +428,13 @@ void waiting_buffer_scan_tap(void)
     if (!tapping_key.event.pressed) return;
 
     for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = (i + 1) % WAITING_BUFFER_SIZE) {
-        if (IS_TAPPING_KEY(waiting_buffer[i].event.key) &&
-                !waiting_buffer[i].event.pressed &&
-                WITHIN_TAPPING_TERM(waiting_buffer[i].event)) {
+        keyrecord_t record = waiting_buffer_get(i);
+        if (IS_TAPPING_KEY(record.event.key) &&
+                !record.event.pressed &&
+                WITHIN_TAPPING_TERM(record.event)) {
             tapping_key.tap.count = 1;
-            waiting_buffer[i].tap.count = 1;
+            record.tap.count = 1;
+            waiting_buffer_set(i, &record);
             process_record(&tapping_key);
 
             debug("waiting_buffer_scan_tap: found at ["); debug_dec(i); debug("]\n");
@@ -370,7 +457,7 @@ static void debug_waiting_buffer(void)
 {
     debug("{ ");
     for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = (i + 1) % WAITING_BUFFER_SIZE) {
-        debug("["); debug_dec(i); debug("]="); debug_record(waiting_buffer[i]); debug(" ");
+        debug("["); debug_dec(i); debug("]="); debug_record(waiting_buffer_get(i)); debug(" ");
     }
     debug("}\n");
 }
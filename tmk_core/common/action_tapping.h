@@ -31,7 +31,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define TAPPING_TOGGLE  5
 #endif
 
-#define WAITING_BUFFER_SIZE 8
+/* key events that wait for a tap key to be settled, at 3 bytes each */
+#ifndef WAITING_BUFFER_SIZE
+#define WAITING_BUFFER_SIZE 16
+#endif
 
 
 #ifndef NO_ACTION_TAPPING
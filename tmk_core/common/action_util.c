@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "action_util.h"
 #include "action_layer.h"
 #include "timer.h"
+#include "timeout.h"
 #include "keycode_config.h"
 
 extern keymap_config_t keymap_config;
@@ -54,9 +55,13 @@ int8_t get_oneshot_locked_mods(void) { return oneshot_locked_mods; }
 void set_oneshot_locked_mods(int8_t mods) { oneshot_locked_mods = mods; }
 void clear_oneshot_locked_mods(void) { oneshot_locked_mods = 0; }
 #if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
-static int16_t oneshot_time = 0;
+static timeout_t oneshot_timeout;
 bool has_oneshot_mods_timed_out(void) {
-  return TIMER_DIFF_16(timer_read(), oneshot_time) >= ONESHOT_TIMEOUT;
+  return !timeout_pending(&oneshot_timeout);
+}
+static void oneshot_mods_timed_out(void) {
+  dprintf("Oneshot: timeout\n");
+  clear_oneshot_mods();
 }
 #else
 bool has_oneshot_mods_timed_out(void) {
@@ -79,11 +84,16 @@ inline uint8_t get_oneshot_layer(void) { return oneshot_layer_data >> 3; }
 inline uint8_t get_oneshot_layer_state(void) { return oneshot_layer_data & 0b111; }
 
 #if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
-static int16_t oneshot_layer_time = 0;
+static timeout_t oneshot_layer_timeout;
 inline bool has_oneshot_layer_timed_out() {
-    return TIMER_DIFF_16(timer_read(), oneshot_layer_time) >= ONESHOT_TIMEOUT &&
+    return !timeout_pending(&oneshot_layer_timeout) &&
         !(get_oneshot_layer_state() & ONESHOT_TOGGLED);
 }
+static void oneshot_layer_timed_out(void) {
+    if (!(get_oneshot_layer_state() & ONESHOT_TOGGLED)) {
+        clear_oneshot_layer_state(ONESHOT_OTHER_KEY_PRESSED);
+    }
+}
 #endif
 
 /* Oneshot layer */
@@ -92,13 +102,13 @@ void set_oneshot_layer(uint8_t layer, uint8_t state)
     oneshot_layer_data = layer << 3 | state;
     layer_on(layer);
 #if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
-    oneshot_layer_time = timer_read();
+    timeout_start(&oneshot_layer_timeout, ONESHOT_TIMEOUT, oneshot_layer_timed_out);
 #endif
 }
 void reset_oneshot_layer(void) {
     oneshot_layer_data = 0;
 #if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
-    oneshot_layer_time = 0;
+    timeout_cancel(&oneshot_layer_timeout);
 #endif
 }
 void clear_oneshot_layer_state(oneshot_fullfillment_t state)
@@ -108,7 +118,7 @@ void clear_oneshot_layer_state(oneshot_fullfillment_t state)
     if (!get_oneshot_layer_state() && start_state != oneshot_layer_data) {
         layer_off(get_oneshot_layer());
 #if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
-    oneshot_layer_time = 0;
+    timeout_cancel(&oneshot_layer_timeout);
 #endif
     }
 }
@@ -124,12 +134,6 @@ void send_keyboard_report(void) {
     keyboard_report->mods |= macro_mods;
 #ifndef NO_ACTION_ONESHOT
     if (oneshot_mods) {
-#if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
-        if (has_oneshot_mods_timed_out()) {
-            dprintf("Oneshot: timeout\n");
-            clear_oneshot_mods();
-        }
-#endif
         keyboard_report->mods |= oneshot_mods;
         if (has_anykey(keyboard_report)) {
             clear_oneshot_mods();
@@ -167,14 +171,14 @@ void set_oneshot_mods(uint8_t mods)
 {
     oneshot_mods = mods;
 #if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
-    oneshot_time = timer_read();
+    timeout_start(&oneshot_timeout, ONESHOT_TIMEOUT, oneshot_mods_timed_out);
 #endif
 }
 void clear_oneshot_mods(void)
 {
     oneshot_mods = 0;
 #if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
-    oneshot_time = 0;
+    timeout_cancel(&oneshot_timeout);
 #endif
 }
 uint8_t get_oneshot_mods(void)
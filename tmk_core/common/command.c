@@ -33,6 +33,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "led.h"
 #include "command.h"
 #include "backlight.h"
+#include "latency_trace.h"
 #include "quantum.h"
 #include "version.h"
 
@@ -51,6 +52,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 	#include "usbdrv.h"
 #endif
 
+#ifdef PROTOCOL_LUFA
+	#include "report_fifo.h"
+#endif
+
 #ifdef AUDIO_ENABLE
     #include "audio.h"
 #endif /* AUDIO_ENABLE */
@@ -170,6 +175,10 @@ static void command_common_help(void)
 #ifdef SLEEP_LED_ENABLE
 		STR(MAGIC_KEY_SLEEP_LED   ) ":	Sleep LED Test\n"
 #endif
+
+#ifdef LATENCY_TRACE_ENABLE
+		STR(MAGIC_KEY_LATENCY_TRACE) ":	Print and Clear Latency Histograms\n"
+#endif
     );
 }
 
@@ -253,6 +262,19 @@ static void print_status(void)
     print_val_hex8(usb_keyboard_idle_count);
 #endif
 
+#ifdef PROTOCOL_LUFA
+    print_val_hex8(keyboard_report_fifo.high_water);
+    print_val_hex16(keyboard_report_fifo.dropped);
+#   ifdef MOUSE_ENABLE
+    print_val_hex8(mouse_report_fifo.high_water);
+    print_val_hex16(mouse_report_fifo.dropped);
+#   endif
+    print_val_hex8(system_report_fifo.high_water);
+    print_val_hex16(system_report_fifo.dropped);
+    print_val_hex8(consumer_report_fifo.high_water);
+    print_val_hex16(consumer_report_fifo.dropped);
+#endif
+
 #ifdef PROTOCOL_PJRC
 #   if USB_COUNT_SOF
     print_val_hex8(usbSofCount);
@@ -322,6 +344,15 @@ static bool command_common(uint8_t code)
             break;
 #endif
 
+#ifdef LATENCY_TRACE_ENABLE
+
+		// print latency histograms, and start over
+        case MAGIC_KC(MAGIC_KEY_LATENCY_TRACE):
+            latency_trace_print();
+            latency_trace_clear();
+            break;
+#endif
+
 #ifdef BOOTMAGIC_ENABLE
 
 		// print stored eeprom config
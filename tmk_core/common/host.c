@@ -16,16 +16,33 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <stdint.h>
+#include <string.h>
 //#include <avr/interrupt.h>
 #include "keycode.h"
 #include "host.h"
 #include "util.h"
 #include "debug.h"
+#ifdef KEYBOARD_REPORT_COALESCE
+#include "timer.h"
+#ifdef NKRO_ENABLE
+#include "keycode_config.h"
+#endif
+#endif
 
 static host_driver_t *driver;
 static uint16_t last_system_report = 0;
 static uint16_t last_consumer_report = 0;
 
+#ifdef KEYBOARD_REPORT_COALESCE
+/* report waiting for the next frame and the last one the host got */
+static report_keyboard_t staged;
+static report_keyboard_t sent;
+static bool dirty = false;
+/* a report was sent, until then the state of the host is unknown */
+static bool sent_valid = false;
+static uint16_t sent_time;
+#endif
+
 
 void host_set_driver(host_driver_t *d)
 {
@@ -42,10 +59,9 @@ uint8_t host_keyboard_leds(void)
     if (!driver) return 0;
     return (*driver->keyboard_leds)();
 }
-/* send report */
-void host_keyboard_send(report_keyboard_t *report)
+
+static void send_keyboard(report_keyboard_t *report)
 {
-    if (!driver) return;
     (*driver->send_keyboard)(report);
 
     if (debug_keyboard) {
@@ -57,6 +73,101 @@ void host_keyboard_send(report_keyboard_t *report)
     }
 }
 
+#ifdef KEYBOARD_REPORT_COALESCE
+/* Whether 'next' can replace the staged report without the host missing one
+ * of its events: what it presses is still held, and what it releases is not
+ * pressed again. */
+static inline bool merge_bits(uint8_t staged_bits, uint8_t sent_bits, uint8_t next_bits)
+{
+    uint8_t pressed = staged_bits & ~sent_bits;
+    uint8_t released = sent_bits & ~staged_bits;
+    return !(pressed & ~next_bits) && !(released & next_bits);
+}
+
+static bool has_key(report_keyboard_t *report, uint8_t code)
+{
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (report->keys[i] == code) return true;
+    }
+    return false;
+}
+
+static bool can_merge(report_keyboard_t *next)
+{
+    if (!sent_valid) return false;
+    if (!merge_bits(staged.mods, sent.mods, next->mods)) return false;
+#ifdef NKRO_ENABLE
+    if (keyboard_protocol && keymap_config.nkro) {
+        for (uint8_t i = 0; i < KEYBOARD_REPORT_BITS; i++) {
+            if (!merge_bits(staged.nkro.bits[i], sent.nkro.bits[i], next->nkro.bits[i])) return false;
+        }
+        return true;
+    }
+#endif
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        uint8_t code = staged.keys[i];
+        if (code && !has_key(&sent, code) && !has_key(next, code)) return false;
+        code = sent.keys[i];
+        if (code && !has_key(&staged, code) && has_key(next, code)) return false;
+    }
+    return true;
+}
+
+static void send_staged(void)
+{
+    dirty = false;
+    sent_valid = true;
+    sent = staged;
+    sent_time = timer_read();
+    send_keyboard(&sent);
+}
+
+/* Reports are staged and sent once per frame by host_keyboard_task(), so
+ * a burst of changes in one scan, like the shift and the key of send_char(),
+ * reaches the host in one report. A change that would hide an event of the
+ * staged report sends that one first, which keeps taps and their order. */
+void host_keyboard_send(report_keyboard_t *report)
+{
+    if (!driver) return;
+    if (dirty && !can_merge(report)) {
+        send_staged();
+    }
+    staged = *report;
+    dirty = !sent_valid || memcmp(&staged, &sent, sizeof(staged)) != 0;
+}
+
+void host_keyboard_flush(void)
+{
+    if (!driver || !dirty) return;
+    send_staged();
+}
+
+/* whether the driver can take a report without waiting, see lufa.c */
+__attribute__ ((weak))
+bool host_keyboard_ready(void)
+{
+    return true;
+}
+
+void host_keyboard_task(void)
+{
+    if (!driver || !dirty) return;
+    if (timer_elapsed(sent_time) < KEYBOARD_REPORT_SPACING) return;
+    if (!host_keyboard_ready()) return;
+    send_staged();
+}
+#else
+/* send report */
+void host_keyboard_send(report_keyboard_t *report)
+{
+    if (!driver) return;
+    send_keyboard(report);
+}
+
+void host_keyboard_flush(void) {}
+void host_keyboard_task(void) {}
+#endif
+
 void host_mouse_send(report_mouse_t *report)
 {
     if (!driver) return;
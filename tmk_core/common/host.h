@@ -28,6 +28,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 extern "C" {
 #endif
 
+/* Keyboard reports are coalesced and sent at most once per
+ * KEYBOARD_REPORT_SPACING ms when KEYBOARD_REPORT_COALESCE is defined */
+#ifndef KEYBOARD_REPORT_SPACING
+#define KEYBOARD_REPORT_SPACING 1
+#endif
+
 extern uint8_t keyboard_idle;
 extern uint8_t keyboard_protocol;
 
@@ -43,6 +49,14 @@ void host_mouse_send(report_mouse_t *report);
 void host_system_send(uint16_t data);
 void host_consumer_send(uint16_t data);
 
+/* send the staged keyboard report now, before a wait or a reset */
+void host_keyboard_flush(void);
+/* send the staged keyboard report when the next frame is due */
+void host_keyboard_task(void);
+#ifdef KEYBOARD_REPORT_COALESCE
+bool host_keyboard_ready(void);
+#endif
+
 uint16_t host_last_system_report(void);
 uint16_t host_last_consumer_report(void);
 
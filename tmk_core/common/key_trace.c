@@ -0,0 +1,61 @@
+/*
+Copyright 2017
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "key_trace.h"
+#include "timer.h"
+#include "print.h"
+
+/* events between two calls of key_trace_task(), must be a power of two */
+#ifndef KEY_TRACE_BUFFER_SIZE
+#define KEY_TRACE_BUFFER_SIZE 16
+#endif
+
+static struct {
+    uint32_t time;
+    uint8_t row;
+    uint8_t col;
+    bool pressed;
+} events[KEY_TRACE_BUFFER_SIZE];
+static uint8_t head = 0;
+static uint8_t tail = 0;
+static uint16_t lost = 0;
+
+void key_trace_event(keyevent_t event)
+{
+    uint8_t next = (head + 1) & (KEY_TRACE_BUFFER_SIZE - 1);
+    if (next == tail) {
+        lost++;
+        return;
+    }
+    events[head].time = timer_read32();
+    events[head].row = event.key.row;
+    events[head].col = event.key.col;
+    events[head].pressed = event.pressed;
+    head = next;
+}
+
+void key_trace_task(void)
+{
+    while (tail != head) {
+        xprintf(KEY_TRACE_TAG "%lu,%u,%u,%u\n", events[tail].time,
+                events[tail].row, events[tail].col, events[tail].pressed);
+        tail = (tail + 1) & (KEY_TRACE_BUFFER_SIZE - 1);
+    }
+    if (lost) {
+        xprintf(KEY_TRACE_TAG "lost %u\n", lost);
+        lost = 0;
+    }
+}
@@ -0,0 +1,50 @@
+/*
+Copyright 2017
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef KEY_TRACE_H
+#define KEY_TRACE_H
+
+#include <stdint.h>
+#include "keyboard.h"
+
+/*
+ * Trace of the key events found by the matrix scan, for replaying real
+ * typing in the host build (see tests/replay). Every event is printed to
+ * the console as a line
+ *
+ *   kt <time>,<row>,<col>,<pressed>
+ *
+ * with the time of the scan in ms from timer_read32(). Other lines in the
+ * console output are ignored by the replay. If the console can't keep up,
+ * a line "kt lost <count>" tells how many events were left out.
+ */
+#define KEY_TRACE_TAG "kt "
+
+#ifdef KEY_TRACE_ENABLE
+
+/* an event was queued by the matrix scan */
+void key_trace_event(keyevent_t event);
+/* print the events traced since the last call */
+void key_trace_task(void);
+
+#else
+
+#define key_trace_event(event)
+#define key_trace_task()
+
+#endif
+
+#endif
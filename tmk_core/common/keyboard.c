@@ -31,6 +31,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "eeconfig.h"
 #include "backlight.h"
 #include "action_layer.h"
+#include "latency_trace.h"
+#include "key_trace.h"
+#include "send_queue.h"
+#include "timeout.h"
 #ifdef BOOTMAGIC_ENABLE
 #   include "bootmagic.h"
 #else
@@ -162,6 +166,92 @@ void keyboard_init(void) {
 #if defined(NKRO_ENABLE) && defined(FORCE_NKRO)
     keymap_config.nkro = 1;
 #endif
+    // the report of the initial state goes out right away
+    host_keyboard_flush();
+}
+
+/* Key event queue
+ *
+ * Every change found by diffing the matrix against the previous state is
+ * pushed here with the time of the scan that detected it, and the queue is
+ * drained through action_exec() in the same keyboard_task() call. Events left
+ * over (only when QMK_KEYS_PER_SCAN limits the drain) keep their original
+ * timestamp and are handled first on the next call.
+ */
+#ifndef KEYEVENT_QUEUE_SIZE
+#   define KEYEVENT_QUEUE_SIZE 16
+#endif
+
+#if (KEYEVENT_QUEUE_SIZE & (KEYEVENT_QUEUE_SIZE - 1)) != 0 || KEYEVENT_QUEUE_SIZE > 128
+#   error "KEYEVENT_QUEUE_SIZE must be a power of two no larger than 128"
+#endif
+
+static keyevent_t keyevent_queue[KEYEVENT_QUEUE_SIZE];
+static uint8_t keyevent_queue_head = 0;
+static uint8_t keyevent_queue_tail = 0;
+
+static inline bool keyevent_queue_push(keyevent_t event)
+{
+    uint8_t next = (keyevent_queue_head + 1) & (KEYEVENT_QUEUE_SIZE - 1);
+    if (next == keyevent_queue_tail) {
+        return false;
+    }
+    keyevent_queue[keyevent_queue_head] = event;
+    keyevent_queue_head = next;
+    return true;
+}
+
+static inline bool keyevent_queue_pop(keyevent_t *event)
+{
+    if (keyevent_queue_head == keyevent_queue_tail) {
+        return false;
+    }
+    *event = keyevent_queue[keyevent_queue_tail];
+    keyevent_queue_tail = (keyevent_queue_tail + 1) & (KEYEVENT_QUEUE_SIZE - 1);
+    return true;
+}
+
+/* Diff the whole matrix against the last queued state and queue every change.
+ * A change that doesn't fit in the queue is left out of matrix_prev, so it is
+ * picked up again by a later scan instead of being lost.
+ * Returns true if anything was queued.
+ */
+static bool keyevent_queue_matrix_changes(matrix_row_t matrix_prev[], uint16_t scan_time)
+{
+    bool queued = false;
+
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        matrix_row_t matrix_row = matrix_get_row(r);
+        matrix_row_t matrix_change = matrix_row ^ matrix_prev[r];
+        if (!matrix_change) {
+            continue;
+        }
+#ifdef MATRIX_HAS_GHOST
+        if (has_ghost_in_row(r, matrix_row)) {
+            /* Don't update matrix_prev until un-ghosted, or the last key
+             * would be lost.
+             */
+            continue;
+        }
+#endif
+        if (debug_matrix) matrix_print();
+        for (uint8_t c = 0; c < MATRIX_COLS; c++) {
+            if (matrix_change & ((matrix_row_t)1<<c)) {
+                keyevent_t event = {
+                    .key = (keypos_t){ .row = r, .col = c },
+                    .pressed = (matrix_row & ((matrix_row_t)1<<c)),
+                    .time = scan_time
+                };
+                if (!keyevent_queue_push(event)) {
+                    return queued;
+                }
+                key_trace_event(event);
+                matrix_prev[r] ^= ((matrix_row_t)1<<c);
+                queued = true;
+            }
+        }
+    }
+    return queued;
 }
 
 /*
@@ -171,65 +261,38 @@ void keyboard_init(void) {
 void keyboard_task(void)
 {
     static matrix_row_t matrix_prev[MATRIX_ROWS];
-#ifdef MATRIX_HAS_GHOST
-  //  static matrix_row_t matrix_ghost[MATRIX_ROWS];
-#endif
     static uint8_t led_status = 0;
-    matrix_row_t matrix_row = 0;
-    matrix_row_t matrix_change = 0;
-#ifdef QMK_KEYS_PER_SCAN
+    keyevent_t event;
     uint8_t keys_processed = 0;
-#endif
 
+#ifdef LATENCY_TRACE_ENABLE
+    uint32_t scan_start = latency_trace_now();
+#endif
     matrix_scan();
+    // typing of strings and macros that is due
+    send_queue_task();
+    // timeouts of tapping features that are due, before the key events
+    timeout_task();
     if (is_keyboard_master()) {
-        for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
-            matrix_row = matrix_get_row(r);
-            matrix_change = matrix_row ^ matrix_prev[r];
-            if (matrix_change) {
-#ifdef MATRIX_HAS_GHOST
-                if (has_ghost_in_row(r, matrix_row)) {
-                    /* Keep track of whether ghosted status has changed for
-                    * debugging. But don't update matrix_prev until un-ghosted, or
-                    * the last key would be lost.
-                    */
-                    //if (debug_matrix && matrix_ghost[r] != matrix_row) {
-                    //    matrix_print();
-                    //}
-                    //matrix_ghost[r] = matrix_row;
-                    continue;
-                }
-                //matrix_ghost[r] = matrix_row;
-#endif
-                if (debug_matrix) matrix_print();
-                for (uint8_t c = 0; c < MATRIX_COLS; c++) {
-                    if (matrix_change & ((matrix_row_t)1<<c)) {
-                        action_exec((keyevent_t){
-                            .key = (keypos_t){ .row = r, .col = c },
-                            .pressed = (matrix_row & ((matrix_row_t)1<<c)),
-                            .time = (timer_read() | 1) /* time should not be 0 */
-                        });
-                        // record a processed key
-                        matrix_prev[r] ^= ((matrix_row_t)1<<c);
+        // all changes seen by this scan share its timestamp, time should not be 0
+        uint16_t scan_time = timer_read() | 1;
+        if (keyevent_queue_matrix_changes(matrix_prev, scan_time)) {
+            latency_trace_scan(scan_time, scan_start);
+        }
+
+        while (keyevent_queue_pop(&event)) {
+            action_exec(event);
 #ifdef QMK_KEYS_PER_SCAN
-                        // only jump out if we have processed "enough" keys.
-                        if (++keys_processed >= QMK_KEYS_PER_SCAN)
+            // leave the rest queued if we have processed "enough" keys.
+            if (++keys_processed >= QMK_KEYS_PER_SCAN) break;
+#else
+            keys_processed++;
 #endif
-                        // process a key per task call
-                        goto MATRIX_LOOP_END;
-                    }
-                }
-            }
         }
     }
     // call with pseudo tick event when no real key event.
-#ifdef QMK_KEYS_PER_SCAN
-    // we can get here with some keys processed now.
     if (!keys_processed)
-#endif
-    action_exec(TICK);
-
-MATRIX_LOOP_END:
+        action_exec(TICK);
 
 #ifdef MOUSEKEY_ENABLE
     // mousekey repeat & acceleration
@@ -260,11 +323,16 @@ MATRIX_LOOP_END:
     pointing_device_task();
 #endif
 
+    host_keyboard_task();
+
     // update LED
     if (led_status != host_keyboard_leds()) {
         led_status = host_keyboard_leds();
         keyboard_set_leds(led_status);
     }
+
+    // print the traced events last, so that the console doesn't delay reports
+    key_trace_task();
 }
 
 void keyboard_set_leds(uint8_t leds)
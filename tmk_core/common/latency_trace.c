@@ -0,0 +1,192 @@
+/*
+Copyright 2017
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "latency_trace.h"
+#include "timer.h"
+#include "print.h"
+#if defined(__AVR__)
+#   include <avr/io.h>
+#   include <util/atomic.h>
+#   include "avr/timer_avr.h"
+#endif
+
+/* number of scans whose events can be traced at the same time */
+#ifndef LATENCY_TRACE_SCANS
+#define LATENCY_TRACE_SCANS 8
+#endif
+
+static uint16_t histograms[LATENCY_STAGES][LATENCY_TRACE_BUCKETS];
+
+static struct {
+    uint16_t time;
+    uint32_t origin;
+} scans[LATENCY_TRACE_SCANS];
+static uint8_t scan_next = 0;
+
+static uint32_t report_origin;
+static bool report_pending = false;
+
+#if defined(__AVR__)
+extern volatile uint32_t timer_count;
+
+uint32_t latency_trace_now(void)
+{
+    uint32_t ms;
+    uint8_t raw;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ms = timer_count;
+        raw = TIMER_RAW;
+        /* the counter has wrapped but the interrupt hasn't run yet */
+#ifndef __AVR_ATmega32A__
+        if (TIFR0 & (1<<OCF0A)) {
+#else
+        if (TIFR & (1<<OCF0)) {
+#endif
+            ms++;
+            raw = TIMER_RAW;
+        }
+    }
+    return ms * 1000 + raw * (1000000UL / TIMER_RAW_FREQ);
+}
+#else
+uint32_t latency_trace_now(void)
+{
+    return timer_read32() * 1000;
+}
+#endif
+
+static void add(uint8_t stage, uint32_t us)
+{
+    uint8_t bucket = 0;
+
+    us >>= 5;
+    while (us && bucket < LATENCY_TRACE_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    if (histograms[stage][bucket] != UINT16_MAX) {
+        histograms[stage][bucket]++;
+    }
+}
+
+static bool find_origin(uint16_t time, uint32_t *origin)
+{
+    uint8_t i = scan_next;
+
+    /* newest first */
+    for (uint8_t n = 0; n < LATENCY_TRACE_SCANS; n++) {
+        i = (i ? i : LATENCY_TRACE_SCANS) - 1;
+        if (scans[i].time == time) {
+            *origin = scans[i].origin;
+            return true;
+        }
+    }
+    return false;
+}
+
+void latency_trace_scan(uint16_t time, uint32_t scan_start)
+{
+    uint32_t now = latency_trace_now();
+
+    add(LATENCY_MATRIX_SCAN, now - scan_start);
+    scans[scan_next].time = time;
+    scans[scan_next].origin = now;
+    scan_next = (scan_next + 1) % LATENCY_TRACE_SCANS;
+}
+
+void latency_trace_action_exec(uint16_t time)
+{
+    uint32_t origin;
+
+    if (find_origin(time, &origin)) {
+        add(LATENCY_ACTION_EXEC, latency_trace_now() - origin);
+    }
+}
+
+void latency_trace_process_record(uint16_t time)
+{
+    if (find_origin(time, &report_origin)) {
+        add(LATENCY_PROCESS_RECORD, latency_trace_now() - report_origin);
+        report_pending = true;
+    }
+}
+
+void latency_trace_send_keyboard(void)
+{
+    if (report_pending) {
+        add(LATENCY_SEND_KEYBOARD, latency_trace_now() - report_origin);
+        report_pending = false;
+    }
+}
+
+void latency_trace_clear(void)
+{
+    for (uint8_t stage = 0; stage < LATENCY_STAGES; stage++) {
+        for (uint8_t bucket = 0; bucket < LATENCY_TRACE_BUCKETS; bucket++) {
+            histograms[stage][bucket] = 0;
+        }
+    }
+}
+
+uint16_t latency_trace_count(uint8_t stage, uint8_t bucket)
+{
+    return histograms[stage][bucket];
+}
+
+void latency_trace_print(void)
+{
+// Print these variables if NO_PRINT or USER_PRINT are not defined.
+#if !defined(NO_PRINT) && !defined(USER_PRINT)
+    static const char *names[LATENCY_STAGES] = {
+        "matrix_scan", "action_exec", "process_record", "send_keyboard"
+    };
+
+    print("\n\t- Latency (us) -\n");
+    print("upto:");
+    for (uint8_t bucket = 0; bucket < LATENCY_TRACE_BUCKETS - 1; bucket++) {
+        xprintf(" %lu", 32UL << bucket);
+    }
+    print(" more\n");
+    for (uint8_t stage = 0; stage < LATENCY_STAGES; stage++) {
+        xprintf("%s:", names[stage]);
+        for (uint8_t bucket = 0; bucket < LATENCY_TRACE_BUCKETS; bucket++) {
+            xprintf(" %u", histograms[stage][bucket]);
+        }
+        print("\n");
+    }
+#endif
+}
+
+bool latency_trace_raw_hid(uint8_t *data, uint8_t length)
+{
+    if (length < 2 + 2 * LATENCY_TRACE_BUCKETS || data[0] != LATENCY_TRACE_RAW_HID_ID) {
+        return false;
+    }
+
+    uint8_t stage = data[1];
+    if (stage == LATENCY_TRACE_RAW_HID_CLEAR) {
+        latency_trace_clear();
+    }
+    for (uint8_t bucket = 0; bucket < LATENCY_TRACE_BUCKETS; bucket++) {
+        uint16_t count = stage < LATENCY_STAGES ? histograms[stage][bucket] : 0;
+        data[2 + 2 * bucket] = count & 0xFF;
+        data[3 + 2 * bucket] = count >> 8;
+    }
+    return true;
+}
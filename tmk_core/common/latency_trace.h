@@ -0,0 +1,83 @@
+/*
+Copyright 2017
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Latency histograms of the path from a matrix change to the USB report.
+ *
+ * Every scan that sees a change is the origin of its key events, which
+ * carry the scan time in event.time. Each stage adds the time since the
+ * origin of its event to the histogram of the stage. Bucket 0 counts less
+ * than 32us, bucket n counts [2^(n+4), 2^(n+5)) us, and the last bucket
+ * counts everything above.
+ */
+enum latency_trace_stage {
+    LATENCY_MATRIX_SCAN,      // duration of the matrix_scan() that saw a change
+    LATENCY_ACTION_EXEC,      // change seen -> action_exec()
+    LATENCY_PROCESS_RECORD,   // change seen -> process_record_quantum()
+    LATENCY_SEND_KEYBOARD,    // change seen -> report handed to the endpoint
+    LATENCY_STAGES
+};
+
+#define LATENCY_TRACE_BUCKETS 15
+
+/* first byte of a raw HID packet for latency_trace_raw_hid() */
+#define LATENCY_TRACE_RAW_HID_ID 'L'
+/* stage number in a raw HID request that clears the histograms */
+#define LATENCY_TRACE_RAW_HID_CLEAR 0xFF
+
+#ifdef LATENCY_TRACE_ENABLE
+
+/* free running clock in microseconds, with the resolution of the platform */
+uint32_t latency_trace_now(void);
+
+/* a scan that started at scan_start has queued events stamped with time */
+void latency_trace_scan(uint16_t time, uint32_t scan_start);
+/* the event with the given time reached action_exec() */
+void latency_trace_action_exec(uint16_t time);
+/* the event with the given time reached process_record_quantum() */
+void latency_trace_process_record(uint16_t time);
+/* a keyboard report was handed to the host, it's attributed to the last
+ * event that reached process_record_quantum() */
+void latency_trace_send_keyboard(void);
+
+void latency_trace_clear(void);
+uint16_t latency_trace_count(uint8_t stage, uint8_t bucket);
+/* print the histograms to the console */
+void latency_trace_print(void);
+/*
+ * Handle a raw HID packet of 32 bytes. Requests are LATENCY_TRACE_RAW_HID_ID
+ * followed by a stage, or by LATENCY_TRACE_RAW_HID_CLEAR. The packet is
+ * replaced by the reply, the two request bytes and the counts of the stage
+ * as little endian words. Returns false if the packet isn't a request.
+ */
+bool latency_trace_raw_hid(uint8_t *data, uint8_t length);
+
+#else
+
+#define latency_trace_scan(time, scan_start)
+#define latency_trace_action_exec(time)
+#define latency_trace_process_record(time)
+#define latency_trace_send_keyboard()
+
+#endif
+
+#endif
@@ -0,0 +1,198 @@
+/*
+Copyright 2017
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "send_queue.h"
+#include "action.h"
+#include "action_util.h"
+#include "host.h"
+#include "timer.h"
+#include "wait.h"
+#if defined(__AVR__)
+#   include <util/atomic.h>
+#   define SEND_QUEUE_ATOMIC ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#else
+#   define SEND_QUEUE_ATOMIC
+#endif
+
+typedef struct {
+    uint8_t op;
+    uint8_t arg;
+} send_queue_entry_t;
+
+static send_queue_entry_t queue[SEND_QUEUE_SIZE];
+static uint8_t head = 0;
+static uint8_t count = 0;
+/* steps are being released, they must not queue themselves again */
+static bool running = false;
+/* the WAIT at the head has started */
+static bool waiting = false;
+static uint16_t wait_start;
+/* the mods taken away by SEND_QUEUE_SAVE_MODS */
+static uint8_t saved_mods = 0;
+
+static void run(send_queue_entry_t step)
+{
+    switch (step.op) {
+        case SEND_QUEUE_REGISTER:
+            register_code(step.arg);
+            break;
+        case SEND_QUEUE_UNREGISTER:
+            unregister_code(step.arg);
+            break;
+        case SEND_QUEUE_ADD_MACRO_MODS:
+            add_macro_mods(step.arg);
+            send_keyboard_report();
+            break;
+        case SEND_QUEUE_DEL_MACRO_MODS:
+            del_macro_mods(step.arg);
+            send_keyboard_report();
+            break;
+        case SEND_QUEUE_REGISTER_MODS:
+            register_mods(step.arg);
+            break;
+        case SEND_QUEUE_UNREGISTER_MODS:
+            unregister_mods(step.arg);
+            break;
+        case SEND_QUEUE_REGISTER_WEAK_MODS:
+            register_weak_mods(step.arg);
+            break;
+        case SEND_QUEUE_UNREGISTER_WEAK_MODS:
+            unregister_weak_mods(step.arg);
+            break;
+        case SEND_QUEUE_CLEAR_KEYBOARD:
+            clear_keyboard();
+            break;
+        case SEND_QUEUE_CLEAR_KEYBOARD_BUT_MODS:
+            clear_keyboard_but_mods();
+            break;
+        case SEND_QUEUE_SAVE_MODS:
+            saved_mods = keyboard_report->mods;
+            unregister_mods(saved_mods);
+            break;
+        case SEND_QUEUE_RESTORE_MODS:
+            register_mods(saved_mods);
+            saved_mods = 0;
+            break;
+    }
+}
+
+static void start_wait(void)
+{
+    host_keyboard_flush();
+    waiting = true;
+    wait_start = timer_read();
+}
+
+static void pop(void)
+{
+    SEND_QUEUE_ATOMIC {
+        head = (head + 1) % SEND_QUEUE_SIZE;
+        count--;
+    }
+}
+
+/* The queue is full, so the producer finishes the oldest step itself. That
+ * waits out the rest of one WAIT at most, a long macro keeps its pace. */
+static void make_room(void)
+{
+    send_queue_entry_t step = queue[head];
+
+    running = true;
+    if (step.op == SEND_QUEUE_WAIT) {
+        if (!waiting) start_wait();
+        while (timer_elapsed(wait_start) < step.arg) {
+            wait_ms(1);
+        }
+        waiting = false;
+    } else {
+        run(step);
+    }
+    pop();
+    running = false;
+}
+
+static void push(uint8_t op, uint8_t arg)
+{
+    if (count >= SEND_QUEUE_SIZE) {
+        make_room();
+    }
+    if (count == 0 && op == SEND_QUEUE_WAIT) {
+        start_wait();
+    }
+    SEND_QUEUE_ATOMIC {
+        queue[(head + count) % SEND_QUEUE_SIZE] = (send_queue_entry_t){ op, arg };
+        count++;
+    }
+}
+
+void send_queue_step(uint8_t op, uint8_t arg)
+{
+    if (count == 0 || running) {
+        run((send_queue_entry_t){ op, arg });
+    } else {
+        push(op, arg);
+    }
+}
+
+void send_queue_wait(uint8_t ms)
+{
+    if (ms && !running) {
+        push(SEND_QUEUE_WAIT, ms);
+    }
+}
+
+bool send_queue_defer(uint8_t op, uint8_t arg)
+{
+    if (count == 0 || running) {
+        return false;
+    }
+    push(op, arg);
+    return true;
+}
+
+bool send_queue_busy(void)
+{
+    return count > 0;
+}
+
+void send_queue_task(void)
+{
+    uint8_t steps = 0;
+
+    if (running) return;
+    running = true;
+    while (count && steps < SEND_QUEUE_BURST) {
+        send_queue_entry_t step = queue[head];
+        if (step.op == SEND_QUEUE_WAIT) {
+            if (!waiting) start_wait();
+            if (timer_elapsed(wait_start) < step.arg) break;
+            waiting = false;
+        } else {
+            run(step);
+        }
+        pop();
+        steps++;
+    }
+    running = false;
+}
+
+void send_queue_flush(void)
+{
+    while (count) {
+        send_queue_task();
+        if (count) wait_ms(1);
+    }
+}
@@ -0,0 +1,78 @@
+/*
+Copyright 2017
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef SEND_QUEUE_H
+#define SEND_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Output scheduler for typed text and macros.
+ *
+ * Instead of waiting inline, send_string_with_delay(), action_macro_play()
+ * and the unicode input queue their pauses as WAIT steps, which
+ * send_queue_task() releases from keyboard_task(), so the matrix keeps being
+ * scanned while they type. While steps are pending, register_code(),
+ * register_mods(), register_weak_mods(), their unregister counterparts and
+ * clear_keyboard() queue behind them, which keeps everything that is sent
+ * afterwards, including keys pressed meanwhile, in order. Until they run,
+ * get_mods() and the other state of action_util.c don't show them yet.
+ *
+ * When the queue is full the producer runs the oldest step itself, waiting
+ * out the rest of its pause if it is one, like before.
+ *
+ * Steps are only queued from the main loop. The USB stacks that handle
+ * SET_PROTOCOL in an interrupt leave its clear_keyboard() to the main loop.
+ */
+#ifndef SEND_QUEUE_SIZE
+#define SEND_QUEUE_SIZE 32
+#endif
+
+/* steps released by a call of send_queue_task() at most */
+#ifndef SEND_QUEUE_BURST
+#define SEND_QUEUE_BURST 16
+#endif
+
+enum send_queue_op {
+    SEND_QUEUE_REGISTER,                /* register_code(arg) */
+    SEND_QUEUE_UNREGISTER,              /* unregister_code(arg) */
+    SEND_QUEUE_ADD_MACRO_MODS,          /* add_macro_mods(arg) and send the report */
+    SEND_QUEUE_DEL_MACRO_MODS,          /* del_macro_mods(arg) and send the report */
+    SEND_QUEUE_REGISTER_MODS,           /* register_mods(arg) */
+    SEND_QUEUE_UNREGISTER_MODS,         /* unregister_mods(arg) */
+    SEND_QUEUE_REGISTER_WEAK_MODS,      /* register_weak_mods(arg) */
+    SEND_QUEUE_UNREGISTER_WEAK_MODS,    /* unregister_weak_mods(arg) */
+    SEND_QUEUE_CLEAR_KEYBOARD,          /* clear_keyboard() */
+    SEND_QUEUE_CLEAR_KEYBOARD_BUT_MODS, /* clear_keyboard_but_mods() */
+    SEND_QUEUE_SAVE_MODS,               /* unregister the mods of the report and keep them */
+    SEND_QUEUE_RESTORE_MODS,            /* register the kept mods again */
+    SEND_QUEUE_WAIT,                    /* pause for arg ms */
+};
+
+/* run the step now, or after the pending ones */
+void send_queue_step(uint8_t op, uint8_t arg);
+/* pause the steps that follow for ms */
+void send_queue_wait(uint8_t ms);
+/* queue the step if steps are pending, and return if it did */
+bool send_queue_defer(uint8_t op, uint8_t arg);
+bool send_queue_busy(void);
+/* release the steps that are due */
+void send_queue_task(void);
+/* run all pending steps, waiting inline */
+void send_queue_flush(void);
+
+#endif
@@ -0,0 +1,110 @@
+/*
+Copyright 2017
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <stddef.h>
+#include "timeout.h"
+#include "timer.h"
+
+static timeout_t *pending = NULL;
+/* the ones timeout_task() is running the callbacks of */
+static timeout_t *due = NULL;
+
+static bool timeout_unlink_from(timeout_t **list, timeout_t *timeout)
+{
+    for (timeout_t **p = list; *p; p = &(*p)->next) {
+        if (*p == timeout) {
+            *p = timeout->next;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void timeout_unlink(timeout_t *timeout)
+{
+    if (!timeout_unlink_from(&pending, timeout)) {
+        timeout_unlink_from(&due, timeout);
+    }
+    timeout->next = NULL;
+    timeout->pending = false;
+}
+
+void timeout_start(timeout_t *timeout, uint16_t ms, timeout_callback_t callback)
+{
+    timeout_t **p;
+
+    if (timeout->pending) {
+        timeout_unlink(timeout);
+    }
+    timeout->callback = callback;
+    timeout->deadline = timer_read() + ms;
+    timeout->pending = true;
+
+    // after the ones with the same deadline
+    for (p = &pending; *p && (int16_t)((*p)->deadline - timeout->deadline) <= 0; p = &(*p)->next);
+    timeout->next = *p;
+    *p = timeout;
+}
+
+void timeout_cancel(timeout_t *timeout)
+{
+    if (timeout->pending) {
+        timeout_unlink(timeout);
+    }
+}
+
+bool timeout_pending(const timeout_t *timeout)
+{
+    return timeout->pending;
+}
+
+bool timeout_next(uint16_t *ms)
+{
+    if (!pending) {
+        return false;
+    }
+    int16_t left = pending->deadline - timer_read();
+    *ms = left > 0 ? left : 0;
+    return true;
+}
+
+void timeout_task(void)
+{
+    timeout_t *last;
+    uint16_t now;
+
+    if (!pending) {
+        return;
+    }
+    now = timer_read();
+    if ((int16_t)(now - pending->deadline) < 0) {
+        return;
+    }
+
+    // detach the due ones first, so that the callbacks can start them again
+    // for a later task, or cancel the ones that haven't run yet
+    due = pending;
+    for (last = due; last->next && (int16_t)(now - last->next->deadline) >= 0; last = last->next);
+    pending = last->next;
+    last->next = NULL;
+    while (due) {
+        timeout_t *timeout = due;
+        due = timeout->next;
+        timeout->next = NULL;
+        timeout->pending = false;
+        timeout->callback();
+    }
+}
@@ -0,0 +1,55 @@
+/*
+Copyright 2017
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef TIMEOUT_H
+#define TIMEOUT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Deadlines of the features that wait for time to pass.
+ *
+ * A feature keeps a timeout_t for each thing it times, and starts it instead
+ * of comparing timer_elapsed() on every scan. keyboard_task() calls
+ * timeout_task(), which runs the callbacks that are due, after the matrix
+ * scan and before its key events, where the features used to poll. The
+ * pending timeouts are kept sorted by deadline, so a task with nothing due
+ * looks at the first one only, and timeout_next() tells how long the main
+ * loop may sleep.
+ *
+ * Callbacks may start timeouts again, those run on a later task at the
+ * earliest.
+ */
+typedef void (*timeout_callback_t)(void);
+
+typedef struct timeout {
+    struct timeout *next;
+    timeout_callback_t callback;
+    uint16_t deadline;
+    bool pending;
+} timeout_t;
+
+/* (re)start the timeout, the callback runs once ms have passed */
+void timeout_start(timeout_t *timeout, uint16_t ms, timeout_callback_t callback);
+void timeout_cancel(timeout_t *timeout);
+bool timeout_pending(const timeout_t *timeout);
+/* ms until the first deadline, returns false if nothing is pending */
+bool timeout_next(uint16_t *ms);
+/* run the callbacks that are due */
+void timeout_task(void);
+
+#endif
@@ -17,6 +17,7 @@ endif
 LUFA_SRC = lufa.c \
 	   descriptor.c \
 	   outputselect.c \
+	   report_fifo.c \
 	   $(LUFA_SRC_USB)
 
 ifeq ($(strip $(MIDI_ENABLE)), yes)
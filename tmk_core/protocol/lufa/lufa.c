@@ -54,6 +54,9 @@
 #include "quantum.h"
 #include <util/atomic.h>
 #include "outputselect.h"
+#include "latency_trace.h"
+#include "report_fifo.h"
+#include "timer.h"
 
 #ifdef NKRO_ENABLE
   #include "keycode_config.h"
@@ -96,6 +99,35 @@ uint8_t keyboard_protocol = 1;
 static uint8_t keyboard_led_stats = 0;
 
 static report_keyboard_t keyboard_report_sent;
+/* set by SET_PROTOCOL, keys held with the previous protocol are released */
+static volatile bool keyboard_clear_pending = false;
+
+REPORT_FIFO(keyboard_report_fifo, sizeof(report_keyboard_t));
+#ifdef MOUSE_ENABLE
+REPORT_FIFO(mouse_report_fifo, sizeof(report_mouse_t));
+#endif
+/* System and consumer share the endpoint but not the queue, a report only
+ * ever replaces one with the same report ID */
+REPORT_FIFO(system_report_fifo, sizeof(report_extra_t));
+REPORT_FIFO(consumer_report_fifo, sizeof(report_extra_t));
+
+/* Set by the USB events, which may run in the interrupt, when the queued
+ * reports were made for the previous connection or protocol. A boot protocol
+ * host must not get NKRO sized reports. */
+static volatile bool report_fifos_stale = false;
+
+/* Drops the stale reports, only the main loop touches the queues */
+static void report_fifos_settle(void)
+{
+    if (!report_fifos_stale) return;
+    report_fifos_stale = false;
+    report_fifo_clear(&keyboard_report_fifo);
+#ifdef MOUSE_ENABLE
+    report_fifo_clear(&mouse_report_fifo);
+#endif
+    report_fifo_clear(&system_report_fifo);
+    report_fifo_clear(&consumer_report_fifo);
+}
 
 #ifdef MIDI_ENABLE
 static void usb_send_func(MidiDevice * device, uint16_t cnt, uint8_t byte0, uint8_t byte1, uint8_t byte2);
@@ -254,6 +286,13 @@ static void raw_hid_task(void)
 
 		if ( data_read )
 		{
+#ifdef LATENCY_TRACE_ENABLE
+			if ( latency_trace_raw_hid( data, sizeof(data) ) )
+			{
+				raw_hid_send( data, sizeof(data) );
+				return;
+			}
+#endif
 			raw_hid_receive( data, sizeof(data) );
 		}
 	}
@@ -344,6 +383,7 @@ void EVENT_USB_Device_Disconnect(void)
     print("[D]");
     /* For battery powered device */
     USB_IsInitialized = false;
+    report_fifos_stale = true;
 /* TODO: This doesn't work. After several plug in/outs can not be enumerated.
     if (USB_IsInitialized) {
         USB_Disable();  // Disable all interrupts
@@ -356,6 +396,7 @@ void EVENT_USB_Device_Disconnect(void)
 void EVENT_USB_Device_Reset(void)
 {
     print("[R]");
+    report_fifos_stale = true;
 }
 
 void EVENT_USB_Device_Suspend()
@@ -388,9 +429,21 @@ static bool console_flush = false;
   } \
 } while (0)
 
+#endif
+
+#ifdef KEYBOARD_REPORT_COALESCE
+/* a frame started since the last keyboard report */
+static volatile bool keyboard_frame = false;
+#endif
+
+#if defined(CONSOLE_ENABLE) || defined(KEYBOARD_REPORT_COALESCE)
 // called every 1ms
 void EVENT_USB_Device_StartOfFrame(void)
 {
+#ifdef KEYBOARD_REPORT_COALESCE
+    keyboard_frame = true;
+#endif
+#ifdef CONSOLE_ENABLE
     static uint8_t count;
     if (++count % 50) return;
     count = 0;
@@ -398,8 +451,8 @@ void EVENT_USB_Device_StartOfFrame(void)
     if (!console_flush) return;
     Console_Task();
     console_flush = false;
+#endif
 }
-
 #endif
 
 /** Event handler for the USB_ConfigurationChanged event.
@@ -412,6 +465,8 @@ void EVENT_USB_Device_ConfigurationChanged(void)
 {
     bool ConfigSuccess = true;
 
+    report_fifos_stale = true;
+
     /* Setup Keyboard HID Report Endpoints */
     ConfigSuccess &= ENDPOINT_CONFIG(KEYBOARD_IN_EPNUM, EP_TYPE_INTERRUPT, ENDPOINT_DIR_IN,
                                      KEYBOARD_EPSIZE, ENDPOINT_BANK_SINGLE);
@@ -555,8 +610,12 @@ void EVENT_USB_Device_ControlRequest(void)
                     Endpoint_ClearSETUP();
                     Endpoint_ClearStatusStage();
 
-                    keyboard_protocol = (USB_ControlRequest.wValue & 0xFF);
-                    clear_keyboard();
+                    if (keyboard_protocol != (USB_ControlRequest.wValue & 0xFF)) {
+                        keyboard_protocol = (USB_ControlRequest.wValue & 0xFF);
+                        report_fifos_stale = true;
+                    }
+                    /* this may be the interrupt, the main loop clears */
+                    keyboard_clear_pending = true;
                 }
             }
 
@@ -597,11 +656,125 @@ static uint8_t keyboard_leds(void)
     return keyboard_led_stats;
 }
 
+#ifdef KEYBOARD_REPORT_COALESCE
+/* Staged reports go out on the first scan after a frame started and only
+ * when the endpoint is free, so they can still be merged while the host has
+ * not taken the previous one. */
+bool host_keyboard_ready(void)
+{
+    if (!keyboard_frame) return false;
+    if (report_fifo_peek(&keyboard_report_fifo)) return false;
+
+    uint8_t where = where_to_send();
+    if (where != OUTPUT_USB && where != OUTPUT_USB_AND_BT) {
+        return true;
+    }
+#ifdef NKRO_ENABLE
+    if (keyboard_protocol && keymap_config.nkro) {
+        Endpoint_SelectEndpoint(NKRO_IN_EPNUM);
+    }
+    else
+#endif
+    {
+        Endpoint_SelectEndpoint(KEYBOARD_IN_EPNUM);
+    }
+    return Endpoint_IsReadWriteAllowed();
+}
+#endif
+
+/* Writes the queued reports of an endpoint for as long as it takes them */
+static void report_fifo_write(report_fifo_t *fifo, uint8_t epnum)
+{
+    const void *report;
+
+    Endpoint_SelectEndpoint(epnum);
+    while ((report = report_fifo_peek(fifo)) && Endpoint_IsReadWriteAllowed()) {
+        Endpoint_Write_Stream_LE(report, fifo->size, NULL);
+        Endpoint_ClearIN();
+        report_fifo_pop(fifo);
+    }
+}
+
+static void keyboard_report_write(void)
+{
+    const report_keyboard_t *report;
+    uint8_t size = KEYBOARD_EPSIZE;
+
+    /* Select the Keyboard Report Endpoint */
+#ifdef NKRO_ENABLE
+    if (keyboard_protocol && keymap_config.nkro) {
+        /* Report protocol - NKRO */
+        Endpoint_SelectEndpoint(NKRO_IN_EPNUM);
+        size = NKRO_EPSIZE;
+    }
+    else
+#endif
+    {
+        /* Boot protocol */
+        Endpoint_SelectEndpoint(KEYBOARD_IN_EPNUM);
+    }
+
+    while ((report = report_fifo_peek(&keyboard_report_fifo)) && Endpoint_IsReadWriteAllowed()) {
+        /* Write Keyboard Report Data */
+        Endpoint_Write_Stream_LE(report, size, NULL);
+
+        /* Finalize the stream transfer to send the last packet */
+        Endpoint_ClearIN();
+        latency_trace_send_keyboard();
+
+        keyboard_report_sent = *report;
+        report_fifo_pop(&keyboard_report_fifo);
+    }
+}
+
+/* Writes the queued reports that the host is ready for. Runs from the main
+ * loop and after every send, never from an interrupt, so that it does not
+ * switch endpoints under the main loop. */
+static void report_task(void)
+{
+    if (USB_DeviceState != DEVICE_STATE_Configured)
+        return;
+
+    report_fifos_settle();
+
+    uint8_t ep = Endpoint_GetCurrentEndpoint();
+
+    keyboard_report_write();
+#ifdef MOUSE_ENABLE
+    report_fifo_write(&mouse_report_fifo, MOUSE_IN_EPNUM);
+#endif
+    report_fifo_write(&system_report_fifo, EXTRAKEY_IN_EPNUM);
+    report_fifo_write(&consumer_report_fifo, EXTRAKEY_IN_EPNUM);
+
+    Endpoint_SelectEndpoint(ep);
+}
+
+/* Queues a report and writes what the host is ready for. A full queue waits
+ * for the host to take a report, like the send functions did before there
+ * was a queue, so that no press or release is lost. Only when the host
+ * doesn't poll for REPORT_FIFO_TIMEOUT ms is the newest report replaced. */
+static void queue_report(report_fifo_t *fifo, const void *report)
+{
+    report_fifos_settle();
+    if (report_fifo_full(fifo)) {
+        uint16_t start = timer_read();
+        do {
+            report_task();
+        } while (report_fifo_full(fifo) && USB_DeviceState == DEVICE_STATE_Configured &&
+                 timer_elapsed(start) < REPORT_FIFO_TIMEOUT);
+    }
+    report_fifo_push(fifo, report);
+    report_task();
+}
+
 static void send_keyboard(report_keyboard_t *report)
 {
-    uint8_t timeout = 255;
     uint8_t where = where_to_send();
 
+#ifdef KEYBOARD_REPORT_COALESCE
+    keyboard_frame = false;
+#endif
+
 #ifdef BLUETOOTH_ENABLE
   if (where == OUTPUT_BLUETOOTH || where == OUTPUT_USB_AND_BT) {
     #ifdef MODULE_ADAFRUIT_BLE
@@ -626,43 +799,12 @@ static void send_keyboard(report_keyboard_t *report)
       return;
     }
 
-    /* Select the Keyboard Report Endpoint */
-#ifdef NKRO_ENABLE
-    if (keyboard_protocol && keymap_config.nkro) {
-        /* Report protocol - NKRO */
-        Endpoint_SelectEndpoint(NKRO_IN_EPNUM);
-
-        /* Check if write ready for a polling interval around 1ms */
-        while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(4);
-        if (!Endpoint_IsReadWriteAllowed()) return;
-
-        /* Write Keyboard Report Data */
-        Endpoint_Write_Stream_LE(report, NKRO_EPSIZE, NULL);
-    }
-    else
-#endif
-    {
-        /* Boot protocol */
-        Endpoint_SelectEndpoint(KEYBOARD_IN_EPNUM);
-
-        /* Check if write ready for a polling interval around 10ms */
-        while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
-        if (!Endpoint_IsReadWriteAllowed()) return;
-
-        /* Write Keyboard Report Data */
-        Endpoint_Write_Stream_LE(report, KEYBOARD_EPSIZE, NULL);
-    }
-
-    /* Finalize the stream transfer to send the last packet */
-    Endpoint_ClearIN();
-
-    keyboard_report_sent = *report;
+    queue_report(&keyboard_report_fifo, report);
 }
 
 static void send_mouse(report_mouse_t *report)
 {
 #ifdef MOUSE_ENABLE
-    uint8_t timeout = 255;
     uint8_t where = where_to_send();
 
 #ifdef BLUETOOTH_ENABLE
@@ -688,25 +830,12 @@ static void send_mouse(report_mouse_t *report)
       return;
     }
 
-    /* Select the Mouse Report Endpoint */
-    Endpoint_SelectEndpoint(MOUSE_IN_EPNUM);
-
-    /* Check if write ready for a polling interval around 10ms */
-    while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
-    if (!Endpoint_IsReadWriteAllowed()) return;
-
-    /* Write Mouse Report Data */
-    Endpoint_Write_Stream_LE(report, sizeof(report_mouse_t), NULL);
-
-    /* Finalize the stream transfer to send the last packet */
-    Endpoint_ClearIN();
+    queue_report(&mouse_report_fifo, report);
 #endif
 }
 
 static void send_system(uint16_t data)
 {
-    uint8_t timeout = 255;
-
     if (USB_DeviceState != DEVICE_STATE_Configured)
         return;
 
@@ -714,19 +843,11 @@ static void send_system(uint16_t data)
         .report_id = REPORT_ID_SYSTEM,
         .usage = data - SYSTEM_POWER_DOWN + 1
     };
-    Endpoint_SelectEndpoint(EXTRAKEY_IN_EPNUM);
-
-    /* Check if write ready for a polling interval around 10ms */
-    while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
-    if (!Endpoint_IsReadWriteAllowed()) return;
-
-    Endpoint_Write_Stream_LE(&r, sizeof(report_extra_t), NULL);
-    Endpoint_ClearIN();
+    queue_report(&system_report_fifo, &r);
 }
 
 static void send_consumer(uint16_t data)
 {
-    uint8_t timeout = 255;
     uint8_t where = where_to_send();
 
 #ifdef BLUETOOTH_ENABLE
@@ -769,14 +890,7 @@ static void send_consumer(uint16_t data)
         .report_id = REPORT_ID_CONSUMER,
         .usage = data
     };
-    Endpoint_SelectEndpoint(EXTRAKEY_IN_EPNUM);
-
-    /* Check if write ready for a polling interval around 10ms */
-    while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
-    if (!Endpoint_IsReadWriteAllowed()) return;
-
-    Endpoint_Write_Stream_LE(&r, sizeof(report_extra_t), NULL);
-    Endpoint_ClearIN();
+    queue_report(&consumer_report_fifo, &r);
 }
 
 
@@ -1190,6 +1304,10 @@ int main(void)
         }
         #endif
 
+        if (keyboard_clear_pending) {
+            keyboard_clear_pending = false;
+            clear_keyboard();
+        }
         keyboard_task();
 
 #ifdef MIDI_ENABLE
@@ -1216,6 +1334,8 @@ int main(void)
         raw_hid_task();
 #endif
 
+        report_task();
+
 #if !defined(INTERRUPT_CONTROL_ENDPOINT)
         USB_USBTask();
 #endif
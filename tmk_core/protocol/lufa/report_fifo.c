@@ -0,0 +1,60 @@
+/*
+Copyright 2017
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <string.h>
+#include "report_fifo.h"
+
+static uint8_t *slot(report_fifo_t *fifo, uint8_t index)
+{
+    return fifo->buffer + ((fifo->head + index) % fifo->length) * fifo->size;
+}
+
+bool report_fifo_push(report_fifo_t *fifo, const void *report)
+{
+    if (fifo->count == fifo->length) {
+        memcpy(slot(fifo, fifo->count - 1), report, fifo->size);
+        if (fifo->dropped < 0xFFFF) fifo->dropped++;
+        return false;
+    }
+    memcpy(slot(fifo, fifo->count), report, fifo->size);
+    fifo->count++;
+    if (fifo->count > fifo->high_water) fifo->high_water = fifo->count;
+    return true;
+}
+
+bool report_fifo_full(const report_fifo_t *fifo)
+{
+    return fifo->count == fifo->length;
+}
+
+const void *report_fifo_peek(report_fifo_t *fifo)
+{
+    if (fifo->count == 0) return NULL;
+    return slot(fifo, 0);
+}
+
+void report_fifo_pop(report_fifo_t *fifo)
+{
+    if (fifo->count == 0) return;
+    fifo->head = (fifo->head + 1) % fifo->length;
+    fifo->count--;
+}
+
+void report_fifo_clear(report_fifo_t *fifo)
+{
+    fifo->head = 0;
+    fifo->count = 0;
+}
@@ -0,0 +1,79 @@
+/*
+Copyright 2017
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef REPORT_FIFO_H
+#define REPORT_FIFO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Queue of the reports of one IN endpoint.
+ *
+ * The send functions of lufa.c push their report and return. The queue is
+ * written to the endpoint whenever the host has taken the previous report,
+ * from the send function itself and from the main loop, so nothing waits for
+ * the host to poll.
+ *
+ * A full queue makes the send function wait for the host. Only when the host
+ * stops polling for REPORT_FIFO_TIMEOUT ms is the newest report replaced
+ * instead of being appended. The reports before it stay in order and the
+ * host still ends up with the current state; 'dropped' counts these. Every
+ * queue holds the reports of one report ID, so a replaced report is always
+ * superseded by one of the same kind.
+ *
+ * lufa.c clears the queues on USB reset, disconnect, configuration and
+ * protocol changes, so a report is never sent to a host it wasn't made for.
+ * The queues are only used from the main loop.
+ */
+#ifndef REPORT_FIFO_LENGTH
+#define REPORT_FIFO_LENGTH 4
+#endif
+
+#ifndef REPORT_FIFO_TIMEOUT
+#define REPORT_FIFO_TIMEOUT 50
+#endif
+
+typedef struct {
+    uint8_t *buffer;
+    uint8_t size;       /* bytes per report */
+    uint8_t length;     /* reports that fit */
+    uint8_t head;
+    uint8_t count;
+    uint8_t high_water; /* most reports queued at once */
+    uint16_t dropped;   /* reports replaced while the queue was full */
+} report_fifo_t;
+
+#define REPORT_FIFO(name, report_size) \
+    static uint8_t name##_buffer[(report_size) * REPORT_FIFO_LENGTH]; \
+    report_fifo_t name = { name##_buffer, (report_size), REPORT_FIFO_LENGTH, 0, 0, 0, 0 }
+
+/* returns false if a queued report was replaced */
+bool report_fifo_push(report_fifo_t *fifo, const void *report);
+bool report_fifo_full(const report_fifo_t *fifo);
+/* the oldest report, or NULL */
+const void *report_fifo_peek(report_fifo_t *fifo);
+void report_fifo_pop(report_fifo_t *fifo);
+/* drops every queued report, the statistics are kept */
+void report_fifo_clear(report_fifo_t *fifo);
+
+/* the queues of lufa.c */
+extern report_fifo_t keyboard_report_fifo;
+extern report_fifo_t mouse_report_fifo;
+extern report_fifo_t system_report_fifo;
+extern report_fifo_t consumer_report_fifo;
+
+#endif
@@ -0,0 +1,160 @@
+/* Copyright 2017
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+extern "C" {
+#include "report_fifo.h"
+}
+
+namespace {
+    struct report {
+        uint8_t mods;
+        uint8_t key;
+    };
+
+    REPORT_FIFO(fifo, sizeof(report));
+
+    report make_report(uint8_t key) {
+        return report { 0, key };
+    }
+
+    uint8_t peek_key() {
+        const report* r = static_cast<const report*>(report_fifo_peek(&fifo));
+        return r ? r->key : 0;
+    }
+}
+
+class ReportFifo : public testing::Test {
+protected:
+    ReportFifo() {
+        report_fifo_clear(&fifo);
+        fifo.high_water = 0;
+        fifo.dropped = 0;
+    }
+};
+
+TEST_F(ReportFifo, StartsEmpty) {
+    EXPECT_EQ(report_fifo_peek(&fifo), nullptr);
+    EXPECT_EQ(fifo.count, 0);
+    EXPECT_FALSE(report_fifo_full(&fifo));
+}
+
+TEST_F(ReportFifo, PopOfAnEmptyQueueDoesNothing) {
+    report_fifo_pop(&fifo);
+    EXPECT_EQ(report_fifo_peek(&fifo), nullptr);
+    EXPECT_EQ(fifo.count, 0);
+    report r = make_report(1);
+    report_fifo_push(&fifo, &r);
+    EXPECT_EQ(peek_key(), 1);
+}
+
+TEST_F(ReportFifo, ReportsComeOutInOrder) {
+    for (uint8_t i = 1; i <= 3; i++) {
+        report r = make_report(i);
+        EXPECT_TRUE(report_fifo_push(&fifo, &r));
+    }
+    for (uint8_t i = 1; i <= 3; i++) {
+        EXPECT_EQ(peek_key(), i);
+        report_fifo_pop(&fifo);
+    }
+    EXPECT_EQ(report_fifo_peek(&fifo), nullptr);
+    EXPECT_EQ(fifo.high_water, 3);
+}
+
+TEST_F(ReportFifo, WrapsAroundTheEndOfTheBuffer) {
+    uint8_t next_in = 1;
+    uint8_t next_out = 1;
+    // keep two or three reports queued while the head goes around several times
+    for (int i = 0; i < 3 * REPORT_FIFO_LENGTH; i++) {
+        report r = make_report(next_in++);
+        EXPECT_TRUE(report_fifo_push(&fifo, &r));
+        r = make_report(next_in++);
+        EXPECT_TRUE(report_fifo_push(&fifo, &r));
+        EXPECT_EQ(peek_key(), next_out++);
+        report_fifo_pop(&fifo);
+        EXPECT_EQ(peek_key(), next_out++);
+        report_fifo_pop(&fifo);
+    }
+    EXPECT_EQ(report_fifo_peek(&fifo), nullptr);
+    EXPECT_EQ(fifo.dropped, 0);
+}
+
+TEST_F(ReportFifo, IsFullAtItsLength) {
+    for (uint8_t i = 1; i <= REPORT_FIFO_LENGTH; i++) {
+        EXPECT_FALSE(report_fifo_full(&fifo));
+        report r = make_report(i);
+        report_fifo_push(&fifo, &r);
+    }
+    EXPECT_TRUE(report_fifo_full(&fifo));
+    report_fifo_pop(&fifo);
+    EXPECT_FALSE(report_fifo_full(&fifo));
+}
+
+TEST_F(ReportFifo, TheNewestReportIsReplacedWhenFull) {
+    for (uint8_t i = 1; i <= REPORT_FIFO_LENGTH; i++) {
+        report r = make_report(i);
+        EXPECT_TRUE(report_fifo_push(&fifo, &r));
+    }
+    report r = make_report(10);
+    EXPECT_FALSE(report_fifo_push(&fifo, &r));
+    r = make_report(11);
+    EXPECT_FALSE(report_fifo_push(&fifo, &r));
+    EXPECT_EQ(fifo.dropped, 2);
+    EXPECT_EQ(fifo.count, REPORT_FIFO_LENGTH);
+    EXPECT_EQ(fifo.high_water, REPORT_FIFO_LENGTH);
+
+    for (uint8_t i = 1; i < REPORT_FIFO_LENGTH; i++) {
+        EXPECT_EQ(peek_key(), i);
+        report_fifo_pop(&fifo);
+    }
+    EXPECT_EQ(peek_key(), 11);
+    report_fifo_pop(&fifo);
+    EXPECT_EQ(report_fifo_peek(&fifo), nullptr);
+}
+
+TEST_F(ReportFifo, ReplacesTheNewestAfterWrapping) {
+    report r = make_report(1);
+    report_fifo_push(&fifo, &r);
+    report_fifo_pop(&fifo);
+    for (uint8_t i = 2; i < 2 + REPORT_FIFO_LENGTH; i++) {
+        r = make_report(i);
+        EXPECT_TRUE(report_fifo_push(&fifo, &r));
+    }
+    r = make_report(20);
+    EXPECT_FALSE(report_fifo_push(&fifo, &r));
+    for (uint8_t i = 2; i < 1 + REPORT_FIFO_LENGTH; i++) {
+        EXPECT_EQ(peek_key(), i);
+        report_fifo_pop(&fifo);
+    }
+    EXPECT_EQ(peek_key(), 20);
+}
+
+TEST_F(ReportFifo, ClearDropsTheQueuedReports) {
+    for (uint8_t i = 1; i <= 3; i++) {
+        report r = make_report(i);
+        report_fifo_push(&fifo, &r);
+    }
+    report_fifo_pop(&fifo);
+    report_fifo_clear(&fifo);
+    EXPECT_EQ(report_fifo_peek(&fifo), nullptr);
+    EXPECT_EQ(fifo.high_water, 3);
+
+    report r = make_report(5);
+    EXPECT_TRUE(report_fifo_push(&fifo, &r));
+    EXPECT_EQ(peek_key(), 5);
+    report_fifo_pop(&fifo);
+    EXPECT_EQ(report_fifo_peek(&fifo), nullptr);
+}
@@ -0,0 +1,5 @@
+report_fifo_SRC := \
+	$(TMK_PATH)/protocol/lufa/tests/report_fifo_tests.cpp \
+	$(TMK_PATH)/protocol/lufa/report_fifo.c
+report_fifo_DEFS := -DREPORT_FIFO_LENGTH=4
+report_fifo_INC := $(TMK_PATH)/protocol/lufa
@@ -35,6 +35,7 @@
 #include "util.h"
 #include "suspend.h"
 #include "host.h"
+#include "action.h"
 #include "pjrc.h"
 
 
@@ -69,6 +70,10 @@ int main(void)
             }
         }
 
+        if (keyboard_clear_pending) {
+            keyboard_clear_pending = false;
+            clear_keyboard();
+        }
         keyboard_task(); 
     }
 }
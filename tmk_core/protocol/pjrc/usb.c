@@ -103,6 +103,7 @@
 
 bool remote_wakeup = false;
 bool suspend = false;
+volatile bool keyboard_clear_pending = false;
 
 // 0:control endpoint is enabled automatically by controller.
 static const uint8_t PROGMEM endpoint_config_table[] = {
@@ -940,7 +941,7 @@ ISR(USB_COM_vect)
 #ifdef NKRO_ENABLE
                                         keymap_config.nkro = !!keyboard_protocol;
 #endif
-                                        clear_keyboard();
+                                        keyboard_clear_pending = true;
 					//usb_wait_in_ready();
 					usb_send_in();
 					return;
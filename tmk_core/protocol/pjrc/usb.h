@@ -31,6 +31,8 @@
 
 extern bool remote_wakeup;
 extern bool suspend;
+// SET_PROTOCOL arrives in the interrupt, the main loop clears the keyboard
+extern volatile bool keyboard_clear_pending;
 
 void usb_init(void);			// initialize everything
 uint8_t usb_configured(void);		// is the USB port configured
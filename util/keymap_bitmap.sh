@@ -0,0 +1,78 @@
+#!/bin/sh
+#
+# Usage: keymap_bitmap.sh <objdump> <objcopy> <keymap object> <keymap source>
+#
+# Writes a C file to stdout with a bitmap of the entries of keymaps[] in the
+# compiled keymap object that are not KC_TRNS. Bit n is the n-th keycode of
+# the flattened keymaps[layer][row][col] array, so the matrix size doesn't
+# have to be known here. The keycodes are read as little endian words, which
+# is what both AVR and ARM targets use, from single bytes so that any od
+# will do.
+
+set -e
+
+OBJDUMP=$1
+OBJCOPY=$2
+OBJ=$3
+KEYMAP=$4
+
+set -- $($OBJDUMP -t "$OBJ" | awk '$NF == "keymaps" { print $(NF-2), $(NF-1), $1 }')
+if [ $# -ne 3 ]; then
+    echo "keymaps[] not found in $OBJ" >&2
+    exit 1
+fi
+SECTION=$1
+SIZE=$((0x$2))
+OFFSET=$((0x$3))
+
+BIN=$(mktemp)
+trap 'rm -f "$BIN"' EXIT
+$OBJCOPY -O binary --only-section="$SECTION" "$OBJ" "$BIN"
+
+od -An -v -tu1 -j "$OFFSET" -N "$SIZE" "$BIN" | awk -v keymap="$KEYMAP" '
+BEGIN {
+    KC_TRNS = 1
+    print "/* Generated from " keymap " by util/keymap_bitmap.sh, do not edit */"
+    print ""
+    print "#include <stdint.h>"
+    print "#include \"progmem.h\""
+    print ""
+    print "const uint8_t keymap_bitmap[] PROGMEM = {"
+    n = 0
+    byte = 0
+    line = ""
+    low = -1
+}
+{
+    for (i = 1; i <= NF; i++) {
+        if (low < 0) {
+            low = $i
+            continue
+        }
+        keycode = low + 256 * $i
+        low = -1
+        if (keycode != KC_TRNS) {
+            byte += 2 ^ (n % 8)
+        }
+        n++
+        if (n % 8 == 0) {
+            line = line sprintf(" 0x%02X,", byte)
+            byte = 0
+            if (n % 128 == 0) {
+                print "   " line
+                line = ""
+            }
+        }
+    }
+}
+END {
+    if (n % 8 != 0) {
+        line = line sprintf(" 0x%02X,", byte)
+    }
+    if (line != "") {
+        print "   " line
+    }
+    print "};"
+    print ""
+    print "const uint16_t keymap_bitmap_size = " n ";"
+}'